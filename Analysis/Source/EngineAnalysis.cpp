@@ -0,0 +1,517 @@
+/*
+  ==============================================================================
+
+    EngineAnalysis.cpp
+    Measures the quality and CPU cost of each engine and setting offline.
+
+  ==============================================================================
+*/
+
+#include "EngineAnalysis.h"
+#include "../../Source/PitchShifter.h"
+#include "../../Source/AnalogOctave.h"
+#include "../../Source/PolyOctave.h"
+
+namespace EngineAnalysis
+{
+namespace
+{
+    constexpr int blockSize = 512;
+
+    // 32768 points: 1.5 Hz bins at 48 kHz, fine enough to separate the chord's notes
+    constexpr int fftOrder = 15;
+    constexpr int fftSize = 1 << fftOrder;
+
+    // Blackman-Harris sidelobes sit below -90 dB; its main lobe is 4 bins either side
+    constexpr int lobeBins = 6;
+
+    constexpr double settleSeconds = 0.5;
+    constexpr double lowestFrequency = 20.0, highestFrequency = 20000.0;
+    constexpr int numSweepTones = 24;
+    constexpr float sweepLevel = 0.5f;
+
+    // G major across two octaves, each note 3 or more semitones from the next
+    constexpr double chordFrequencies[] = { 196.00, 246.94, 293.66, 392.00 };
+    constexpr float chordLevel = 0.15f;
+
+    constexpr double burstFrequency = 500.0, burstSeconds = 0.005, burstStartSeconds = 0.1, burstWindowSeconds = 0.5;
+
+    //==============================================================================
+    // One fresh engine per run, timed while it processes
+    class EngineRunner
+    {
+    public:
+        EngineRunner (const Configuration& c, double sampleRate)
+            : configuration (c)
+        {
+            pitchShifter.prepare (sampleRate, blockSize);
+            pitchShifter.setInterpolation (configuration.kernel);
+            analogOctave.prepare (sampleRate);
+            polyOctave.prepare (sampleRate);
+            polyOctave.setNumBands (configuration.polyBands);
+        }
+
+        std::vector<float> process (std::vector<float> samples)
+        {
+            pitchShifter.reset();
+            analogOctave.reset();
+            polyOctave.reset();
+
+            const int octaves = juce::roundToInt (configuration.semitones / 12.0f);
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+
+            for (int offset = 0; offset < (int) samples.size(); offset += blockSize)
+            {
+                const int numSamples = juce::jmin (blockSize, (int) samples.size() - offset);
+                auto* block = samples.data() + offset;
+
+                if (configuration.engine == EngineType::analogOctave)
+                {
+                    analogOctave.process (block, numSamples, octaves, 1.0f);
+                }
+                else if (configuration.engine == EngineType::polyOctave)
+                {
+                    polyOctave.process (block, numSamples, octaves, 1.0f);
+                }
+                else
+                {
+                    juce::AudioBuffer<float> buffer (&block, 1, numSamples);
+                    pitchShifter.processBlock (buffer, configuration.semitones, 1.0f, 0.0f);
+                }
+            }
+
+            elapsedTicks += juce::Time::getHighResolutionTicks() - startTicks;
+            numSamplesProcessed += (juce::int64) samples.size();
+            return samples;
+        }
+
+        void resetTiming() noexcept
+        {
+            elapsedTicks = numSamplesProcessed = 0;
+        }
+
+        double getCpuPercent (double sampleRate) const noexcept
+        {
+            if (numSamplesProcessed == 0)
+                return 0.0;
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (elapsedTicks);
+            return 100.0 * seconds * sampleRate / (double) numSamplesProcessed;
+        }
+
+    private:
+        Configuration configuration;
+        PitchShifter pitchShifter;
+        AnalogOctave analogOctave;
+        PolyOctave polyOctave;
+
+        juce::int64 elapsedTicks = 0, numSamplesProcessed = 0;
+    };
+
+    //==============================================================================
+    double toDecibels (double powerRatio) noexcept
+    {
+        return 10.0 * std::log10 (juce::jmax (powerRatio, 1.0e-20));
+    }
+
+    double getRatio (const Configuration& configuration) noexcept
+    {
+        // The octave engines snap to the nearest octave, so that's what they're measured against
+        if (configuration.engine != EngineType::delayLine)
+            return std::pow (2.0, juce::roundToInt (configuration.semitones / 12.0f));
+
+        return std::pow (2.0, configuration.semitones / 12.0);
+    }
+
+    std::vector<float> makeSilence (double sampleRate, double seconds)
+    {
+        return std::vector<float> ((size_t) std::ceil (seconds * sampleRate), 0.0f);
+    }
+
+    void addSine (std::vector<float>& signal, double sampleRate, double frequency, float level)
+    {
+        const auto phaseStep = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+        for (size_t i = 0; i < signal.size(); ++i)
+            signal[i] += level * (float) std::sin (phaseStep * (double) i);
+    }
+
+    //==============================================================================
+    // Power spectrum of the fftSize samples after the engine has settled
+    class Spectrum
+    {
+    public:
+        Spectrum (const std::vector<float>& signal, double sampleRate)
+            : binHz (sampleRate / fftSize),
+              lowBin (juce::jmax (1, (int) std::ceil (lowestFrequency / binHz))),
+              highBin (juce::jmin (fftSize / 2 - 1, (int) std::floor (juce::jmin (highestFrequency, sampleRate * 0.49) / binHz)))
+        {
+            const auto start = (size_t) std::ceil (settleSeconds * sampleRate);
+            jassert (signal.size() >= start + fftSize);
+
+            std::vector<float> data ((size_t) fftSize * 2, 0.0f);
+            std::copy (signal.begin() + (std::ptrdiff_t) start, signal.begin() + (std::ptrdiff_t) (start + fftSize), data.begin());
+
+            juce::dsp::WindowingFunction<float> window ((size_t) fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris, false);
+            window.multiplyWithWindowingTable (data.data(), (size_t) fftSize);
+
+            juce::dsp::FFT fft (fftOrder);
+            fft.performFrequencyOnlyForwardTransform (data.data());
+
+            power.resize ((size_t) fftSize / 2 + 1);
+
+            for (size_t bin = 0; bin < power.size(); ++bin)
+                power[bin] = (double) data[bin] * (double) data[bin];
+        }
+
+        double getTopFrequency() const noexcept     { return highBin * binHz; }
+
+        struct Tone
+        {
+            double frequency = 0.0, power = 0.0;
+        };
+
+        // The strongest peak within a semitone of expected, located between bins by a parabola
+        // through the log power, and the power over its main lobe
+        Tone findTone (double expected) const
+        {
+            const int first = juce::jlimit (lowBin, highBin, (int) std::floor (expected * 0.944 / binHz));
+            const int last = juce::jlimit (lowBin, highBin, (int) std::ceil (expected * 1.059 / binHz));
+            int peak = first;
+
+            for (int bin = first + 1; bin <= last; ++bin)
+                if (power[(size_t) bin] > power[(size_t) peak])
+                    peak = bin;
+
+            const auto logPower = [this] (int bin) { return std::log (power[(size_t) bin] + 1.0e-30); };
+            const auto a = logPower (peak - 1), b = logPower (peak), c = logPower (peak + 1);
+            const auto curvature = a - 2.0 * b + c;
+            const auto offset = curvature < 0.0 ? 0.5 * (a - c) / curvature : 0.0;
+
+            return { (peak + offset) * binHz, sumBins (peak - lobeBins, peak + lobeBins) };
+        }
+
+        // Power left after taking out every harmonic of each given fundamental
+        double getPowerOutsideHarmonics (const std::vector<double>& fundamentals) const
+        {
+            std::vector<bool> excluded (power.size(), false);
+
+            for (auto fundamental : fundamentals)
+            {
+                for (auto harmonic = fundamental; harmonic <= getTopFrequency() + lobeBins * binHz; harmonic += fundamental)
+                {
+                    const int centre = juce::roundToInt (harmonic / binHz);
+
+                    for (int bin = juce::jmax (0, centre - lobeBins); bin <= juce::jmin ((int) power.size() - 1, centre + lobeBins); ++bin)
+                        excluded[(size_t) bin] = true;
+                }
+            }
+
+            double sum = 0.0;
+
+            for (int bin = lowBin; bin <= highBin; ++bin)
+                if (! excluded[(size_t) bin])
+                    sum += power[(size_t) bin];
+
+            return sum;
+        }
+
+        double getTotalPower() const                { return sumBins (lowBin, highBin); }
+
+    private:
+        double sumBins (int first, int last) const
+        {
+            double sum = 0.0;
+
+            for (int bin = juce::jmax (lowBin, first); bin <= juce::jmin (highBin, last); ++bin)
+                sum += power[(size_t) bin];
+
+            return sum;
+        }
+
+        double binHz;
+        int lowBin, highBin;
+        std::vector<double> power;
+    };
+
+    //==============================================================================
+    void measureSweep (EngineRunner& runner, double sampleRate, double ratio, Result& result)
+    {
+        const auto length = settleSeconds + (fftSize + blockSize) / sampleRate;
+        const auto topFrequency = juce::jmin (highestFrequency, sampleRate * 0.45);
+        const auto highestInput = topFrequency / juce::jmax (1.0, ratio);
+
+        double thdPlusNoiseSum = 0.0, worstInharmonic = 0.0, worstPitchError = 0.0;
+        int numMeasured = 0;
+
+        for (int i = 0; i < numSweepTones; ++i)
+        {
+            const auto frequency = 80.0 * std::pow (highestInput / 80.0, i / (double) (numSweepTones - 1));
+            const auto expected = frequency * ratio;
+
+            auto input = makeSilence (sampleRate, length);
+            addSine (input, sampleRate, frequency, sweepLevel);
+
+            const Spectrum spectrum (runner.process (std::move (input)), sampleRate);
+            const auto tone = spectrum.findTone (expected);
+            const auto wanted = juce::jmax (tone.power, 1.0e-30);
+
+            thdPlusNoiseSum += (spectrum.getTotalPower() - tone.power) / wanted;
+            worstInharmonic = juce::jmax (worstInharmonic, spectrum.getPowerOutsideHarmonics ({ tone.frequency }) / wanted);
+
+            const auto pitchError = 1200.0 * std::log2 (juce::jmax (tone.frequency, 1.0) / expected);
+
+            if (std::abs (pitchError) > std::abs (worstPitchError))
+                worstPitchError = pitchError;
+
+            ++numMeasured;
+        }
+
+        result.thdPlusNoiseDb = toDecibels (thdPlusNoiseSum / juce::jmax (1, numMeasured));
+        result.aliasingDb = toDecibels (worstInharmonic);
+        result.pitchErrorCents = worstPitchError;
+    }
+
+    void measureChord (EngineRunner& runner, double sampleRate, double ratio, Result& result)
+    {
+        auto input = makeSilence (sampleRate, settleSeconds + (fftSize + blockSize) / sampleRate);
+
+        for (auto frequency : chordFrequencies)
+            addSine (input, sampleRate, frequency, chordLevel);
+
+        const Spectrum spectrum (runner.process (std::move (input)), sampleRate);
+
+        std::vector<double> notes;
+        double wanted = 0.0;
+
+        for (auto frequency : chordFrequencies)
+        {
+            const auto tone = spectrum.findTone (frequency * ratio);
+            notes.push_back (tone.frequency);
+            wanted += tone.power;
+        }
+
+        result.multiToneDb = toDecibels (spectrum.getPowerOutsideHarmonics (notes) / juce::jmax (wanted, 1.0e-30));
+    }
+
+    // Time between 10% and 90% of the signal's energy
+    double getEnergySpanSeconds (const std::vector<float>& signal, double sampleRate)
+    {
+        double total = 0.0;
+
+        for (auto sample : signal)
+            total += (double) sample * sample;
+
+        if (total <= 0.0)
+            return 0.0;
+
+        double sum = 0.0;
+        size_t start = 0, end = 0;
+
+        for (size_t i = 0; i < signal.size(); ++i)
+        {
+            const auto previous = sum;
+            sum += (double) signal[i] * signal[i];
+
+            if (previous < 0.1 * total && sum >= 0.1 * total)
+                start = i;
+
+            if (previous < 0.9 * total && sum >= 0.9 * total)
+                end = i;
+        }
+
+        return (double) (end - start) / sampleRate;
+    }
+
+    void measureBurst (EngineRunner& runner, double sampleRate, Result& result)
+    {
+        auto input = makeSilence (sampleRate, burstStartSeconds + burstWindowSeconds);
+        const auto burstStart = (size_t) (burstStartSeconds * sampleRate);
+        const auto burstLength = (size_t) (burstSeconds * sampleRate);
+
+        for (size_t i = 0; i < burstLength; ++i)
+        {
+            const auto window = 0.5 - 0.5 * std::cos (juce::MathConstants<double>::twoPi * (double) i / (double) burstLength);
+            input[burstStart + i] = (float) (window * std::sin (juce::MathConstants<double>::twoPi * burstFrequency * (double) i / sampleRate));
+        }
+
+        const auto inputSpan = getEnergySpanSeconds (input, sampleRate);
+        const auto outputSpan = getEnergySpanSeconds (runner.process (input), sampleRate);
+
+        result.smearMilliseconds = 1000.0 * (outputSpan - inputSpan);
+    }
+
+    //==============================================================================
+    // Plucked strings across a guitar's range, some notes overlapping, a bit like a played part
+    std::vector<float> makePluckedCorpus (double sampleRate)
+    {
+        constexpr double noteSeconds = 0.4;
+        constexpr int numNotes = 25;
+        constexpr double pentatonic[] = { 0.0, 3.0, 5.0, 7.0, 10.0 };
+
+        auto corpus = makeSilence (sampleRate, noteSeconds * numNotes + 2.0);
+        juce::Random random (1);
+
+        for (int note = 0; note < numNotes; ++note)
+        {
+            const auto semitone = pentatonic[(size_t) random.nextInt ((int) std::size (pentatonic))] + 12.0 * random.nextInt (3);
+            const auto period = juce::jmax (2, juce::roundToInt (sampleRate / (82.41 * std::pow (2.0, semitone / 12.0))));
+
+            // Karplus-Strong: a burst of noise recirculating through an averaging delay line
+            std::vector<float> line ((size_t) period);
+
+            for (auto& sample : line)
+                sample = random.nextFloat() * 0.6f - 0.3f;
+
+            const auto start = (size_t) (note * noteSeconds * sampleRate);
+
+            for (size_t i = 0, position = 0; start + i < corpus.size(); ++i)
+            {
+                const auto next = (position + 1) % line.size();
+                corpus[start + i] += line[position];
+                line[position] = 0.498f * (line[position] + line[next]);
+                position = next;
+            }
+        }
+
+        return corpus;
+    }
+}
+
+//==============================================================================
+juce::String Configuration::getEngineName() const
+{
+    switch (engine)
+    {
+        case EngineType::analogOctave:  return "Analog Octave";
+        case EngineType::polyOctave:    return "Poly Octave";
+        case EngineType::delayLine:
+        default:                        return "Delay Line";
+    }
+}
+
+juce::String Configuration::getSettingName() const
+{
+    switch (engine)
+    {
+        case EngineType::analogOctave:  return "-";
+        case EngineType::polyOctave:    return juce::String (polyBands) + " bands";
+        case EngineType::delayLine:
+        default:                        return Interpolation::getKernelNames()[(int) kernel];
+    }
+}
+
+std::vector<Configuration> getDefaultConfigurations()
+{
+    std::vector<Configuration> configurations;
+
+    for (auto semitones : { -12.0f, 7.0f, 12.0f })
+    {
+        for (int kernel = 0; kernel < Interpolation::getKernelNames().size(); ++kernel)
+            configurations.push_back ({ EngineType::delayLine, static_cast<Interpolation::Kernel> (kernel), 32, semitones });
+
+        // The octave engines only shift by whole octaves
+        if (std::abs (std::fmod (semitones, 12.0f)) > 0.0f)
+            continue;
+
+        configurations.push_back ({ EngineType::analogOctave, Interpolation::Kernel::hermite, 32, semitones });
+
+        for (int choice = 0; choice < PolyOctave::getBandCountNames().size(); ++choice)
+            configurations.push_back ({ EngineType::polyOctave, Interpolation::Kernel::hermite, PolyOctave::getBandCount (choice), semitones });
+    }
+
+    return configurations;
+}
+
+Result analyse (const Configuration& configuration, double sampleRate, const std::vector<std::vector<float>>& corpus)
+{
+    Result result;
+    result.configuration = configuration;
+
+    EngineRunner runner (configuration, sampleRate);
+    const auto ratio = getRatio (configuration);
+
+    measureSweep (runner, sampleRate, ratio, result);
+    measureChord (runner, sampleRate, ratio, result);
+    measureBurst (runner, sampleRate, result);
+
+    // Cost comes from material that sounds like use, not from the test tones
+    runner.resetTiming();
+    runner.process (makePluckedCorpus (sampleRate));
+
+    for (const auto& file : corpus)
+        runner.process (file);
+
+    result.cpuPercent = runner.getCpuPercent (sampleRate);
+    return result;
+}
+
+void markParetoFront (std::vector<Result>& results)
+{
+    // Unwanted power from whichever of the sweep and the chord comes out worse
+    const auto getNoise = [] (const Result& result)
+    {
+        return juce::jmax (result.thdPlusNoiseDb, result.multiToneDb);
+    };
+
+    for (auto& candidate : results)
+    {
+        candidate.paretoOptimal = std::none_of (results.begin(), results.end(), [&] (const Result& other)
+        {
+            return &other != &candidate
+                && other.configuration.semitones == candidate.configuration.semitones
+                && other.cpuPercent <= candidate.cpuPercent
+                && getNoise (other) <= getNoise (candidate)
+                && (other.cpuPercent < candidate.cpuPercent || getNoise (other) < getNoise (candidate));
+        });
+    }
+}
+
+juce::String toCsv (const std::vector<Result>& results)
+{
+    juce::String csv ("engine,setting,semitones,cpu_percent,thd_n_db,aliasing_db,multitone_db,pitch_error_cents,smear_ms,pareto\n");
+
+    for (const auto& result : results)
+    {
+        csv << result.configuration.getEngineName() << ','
+            << result.configuration.getSettingName() << ','
+            << juce::String (result.configuration.semitones, 1) << ','
+            << juce::String (result.cpuPercent, 3) << ','
+            << juce::String (result.thdPlusNoiseDb, 1) << ','
+            << juce::String (result.aliasingDb, 1) << ','
+            << juce::String (result.multiToneDb, 1) << ','
+            << juce::String (result.pitchErrorCents, 2) << ','
+            << juce::String (result.smearMilliseconds, 2) << ','
+            << (result.paretoOptimal ? "yes" : "no") << '\n';
+    }
+
+    return csv;
+}
+
+juce::String toJson (const std::vector<Result>& results, double sampleRate)
+{
+    juce::Array<juce::var> entries;
+
+    for (const auto& result : results)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty ("engine", result.configuration.getEngineName());
+        entry->setProperty ("setting", result.configuration.getSettingName());
+        entry->setProperty ("semitones", result.configuration.semitones);
+        entry->setProperty ("cpuPercent", result.cpuPercent);
+        entry->setProperty ("thdPlusNoiseDb", result.thdPlusNoiseDb);
+        entry->setProperty ("aliasingDb", result.aliasingDb);
+        entry->setProperty ("multiToneDb", result.multiToneDb);
+        entry->setProperty ("pitchErrorCents", result.pitchErrorCents);
+        entry->setProperty ("smearMilliseconds", result.smearMilliseconds);
+        entry->setProperty ("pareto", result.paretoOptimal);
+        entries.add (juce::var (entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("sampleRate", sampleRate);
+    root->setProperty ("results", entries);
+
+    return juce::JSON::toString (juce::var (root));
+}
+}
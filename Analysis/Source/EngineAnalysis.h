@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    EngineAnalysis.h
+    Measures the quality and CPU cost of each engine and setting offline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/Interpolation.h"
+
+//==============================================================================
+/**
+    Runs the shifting engines on the bench, away from the plugin and host.
+
+    Each configuration is fed test signals and its output is measured with
+    windowed FFTs:
+
+    - a stepped sine sweep gives THD+N, the worst inharmonic (aliased) product
+      and the worst pitch error against the intended ratio;
+    - a four-note chord gives the intermodulation and noise between notes;
+    - a short tone burst gives how far the engine spreads a transient in time.
+
+    Cost is the time spent inside the engine per second of audio, measured on a
+    generated corpus of plucked notes and on any audio files passed in.
+*/
+namespace EngineAnalysis
+{
+    enum class EngineType
+    {
+        delayLine = 0,
+        analogOctave,
+        polyOctave
+    };
+
+    struct Configuration
+    {
+        EngineType engine = EngineType::delayLine;
+        Interpolation::Kernel kernel = Interpolation::Kernel::hermite;  // Delay Line only
+        int polyBands = 32;                                             // Poly Octave only
+        float semitones = 12.0f;
+
+        juce::String getEngineName() const;
+        juce::String getSettingName() const;
+    };
+
+    /** Quality figures are in dB relative to the wanted signal, so lower is better for all of them. */
+    struct Result
+    {
+        Configuration configuration;
+        double cpuPercent = 0.0;        // Of one core, running in realtime
+        double thdPlusNoiseDb = 0.0;    // Power-averaged over the sweep
+        double aliasingDb = 0.0;        // Worst inharmonic product over the sweep
+        double multiToneDb = 0.0;       // Everything but the shifted notes and their harmonics
+        double pitchErrorCents = 0.0;   // Worst over the sweep
+        double smearMilliseconds = 0.0; // Growth in the span holding a burst's middle 80% of energy
+        bool paretoOptimal = false;
+    };
+
+    /** Every engine at each shift it supports, with each interpolation kernel and band count. */
+    std::vector<Configuration> getDefaultConfigurations();
+
+    /** corpus is extra mono material at sampleRate to time the engine on, on top of the generated notes. */
+    Result analyse (const Configuration& configuration, double sampleRate, const std::vector<std::vector<float>>& corpus);
+
+    /** Marks the results that no other result at the same shift beats on both cost and noise,
+        where noise is the worse of THD+N and the chord's intermodulation.
+    */
+    void markParetoFront (std::vector<Result>& results);
+
+    juce::String toCsv (const std::vector<Result>& results);
+    juce::String toJson (const std::vector<Result>& results, double sampleRate);
+}
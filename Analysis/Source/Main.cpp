@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command-line entry point of the engine analysis suite.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "EngineAnalysis.h"
+#include "StateBenchmark.h"
+#include "../../Source/DspKernels.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: NoctaveAnalysis [--rate <Hz>] [--corpus <folder>] [--output <path>]\n"
+                     "       NoctaveAnalysis --state-benchmark [<instances>]\n\n"
+                     "Measures every engine and setting and writes <path>.csv and <path>.json\n"
+                     "(default: NoctaveAnalysis in the working directory).\n"
+                     "Audio files in the corpus folder at the analysis rate are added to the timing runs.\n\n"
+                     "--state-benchmark saves and restores the state of that many plugin instances\n"
+                     "(default 1000), in the binary format and as XML, and prints the times.\n";
+    }
+
+    // Mono mixdowns of the audio files in folder that are at sampleRate
+    std::vector<std::vector<float>> loadCorpus (const juce::File& folder, double sampleRate)
+    {
+        std::vector<std::vector<float>> corpus;
+
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        for (const auto& entry : juce::RangedDirectoryIterator (folder, false, formatManager.getWildcardForAllFormats()))
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (entry.getFile()));
+
+            if (reader == nullptr || reader->sampleRate != sampleRate || reader->lengthInSamples > std::numeric_limits<int>::max())
+            {
+                std::cerr << "Skipping " << entry.getFile().getFileName() << ": not readable audio at "
+                          << sampleRate << " Hz\n";
+                continue;
+            }
+
+            juce::AudioBuffer<float> audio ((int) reader->numChannels, (int) reader->lengthInSamples);
+            reader->read (&audio, 0, audio.getNumSamples(), 0, true, true);
+
+            std::vector<float> mono ((size_t) audio.getNumSamples(), 0.0f);
+
+            for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                juce::FloatVectorOperations::addWithMultiply (mono.data(), audio.getReadPointer (channel),
+                                                              1.0f / (float) audio.getNumChannels(), audio.getNumSamples());
+
+            corpus.push_back (std::move (mono));
+        }
+
+        return corpus;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (arguments.containsOption ("--state-benchmark"))
+    {
+        const auto value = arguments.getValueForOption ("--state-benchmark");
+        const int numInstances = value.isNotEmpty() ? value.getIntValue() : 1000;
+
+        if (numInstances < 1)
+        {
+            printUsage();
+            return 1;
+        }
+
+        // The processors start timers, which need the message manager
+        juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+        const auto result = StateBenchmark::run (numInstances);
+        std::cout << StateBenchmark::toText (result);
+
+        return result.binary.mismatches == 0 && result.xml.mismatches == 0 ? 0 : 1;
+    }
+
+    const auto sampleRate = arguments.containsOption ("--rate") ? arguments.getValueForOption ("--rate").getDoubleValue() : 48000.0;
+
+    if (sampleRate < 8000.0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::vector<float>> corpus;
+
+    if (arguments.containsOption ("--corpus"))
+    {
+        const auto folder = arguments.getFileForOption ("--corpus");
+
+        if (! folder.isDirectory())
+        {
+            std::cerr << "No corpus folder at " << folder.getFullPathName() << "\n";
+            return 1;
+        }
+
+        corpus = loadCorpus (folder, sampleRate);
+    }
+
+    const auto output = arguments.containsOption ("--output")
+                          ? arguments.getFileForOption ("--output")
+                          : juce::File::getCurrentWorkingDirectory().getChildFile ("NoctaveAnalysis");
+
+    // Same kernels the plugin would pick on this machine, so the costs match
+    std::cout << "Kernels: " << DspKernels::getName (DspKernels::select().instructionSet) << "\n";
+
+    std::vector<EngineAnalysis::Result> results;
+
+    for (const auto& configuration : EngineAnalysis::getDefaultConfigurations())
+    {
+        std::cout << "Analysing " << configuration.getEngineName() << " (" << configuration.getSettingName() << ") at "
+                  << configuration.semitones << " semitones..." << std::endl;
+        results.push_back (EngineAnalysis::analyse (configuration, sampleRate, corpus));
+    }
+
+    EngineAnalysis::markParetoFront (results);
+
+    const auto csv = EngineAnalysis::toCsv (results);
+    std::cout << "\n" << csv;
+
+    const auto csvFile = output.withFileExtension ("csv");
+    const auto jsonFile = output.withFileExtension ("json");
+
+    if (! csvFile.replaceWithText (csv) || ! jsonFile.replaceWithText (EngineAnalysis::toJson (results, sampleRate)))
+    {
+        std::cerr << "Couldn't write " << output.getFullPathName() << ".csv/.json\n";
+        return 1;
+    }
+
+    std::cout << "\nWritten to " << csvFile.getFullPathName() << " and " << jsonFile.getFileName() << "\n";
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    StateBenchmark.cpp
+    Times saving and restoring the state of many plugin instances.
+
+  ==============================================================================
+*/
+
+#include "StateBenchmark.h"
+#include "../../Source/PluginProcessor.h"
+
+namespace StateBenchmark
+{
+namespace
+{
+    using Instances = std::vector<std::unique_ptr<NoctaveAudioProcessor>>;
+    using Snapshot = std::vector<float>;
+
+    Snapshot takeSnapshot (NoctaveAudioProcessor& instance)
+    {
+        Snapshot values;
+
+        for (auto* parameter : instance.getParameters())
+            values.push_back (parameter->getValue());
+
+        return values;
+    }
+
+    int countMismatches (NoctaveAudioProcessor& instance, const Snapshot& expected)
+    {
+        const auto restored = takeSnapshot (instance);
+        int mismatches = 0;
+
+        for (size_t i = 0; i < expected.size(); ++i)
+            if (std::abs (restored[i] - expected[i]) > 1.0e-6f)
+                ++mismatches;
+
+        return mismatches;
+    }
+
+    // Saves every instance, then restores each one from the next one's state, so every
+    // value really changes and nothing is restored onto itself
+    template <typename SaveFunction>
+    Timings roundTrip (Instances& instances, SaveFunction&& save)
+    {
+        Timings timings;
+        const auto numInstances = instances.size();
+        std::vector<juce::MemoryBlock> blobs (numInstances);
+        std::vector<Snapshot> expected;
+
+        for (auto& instance : instances)
+            expected.push_back (takeSnapshot (*instance));
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (size_t i = 0; i < numInstances; ++i)
+            save (*instances[i], blobs[i]);
+
+        timings.saveMilliseconds = juce::Time::getMillisecondCounterHiRes() - start;
+        start = juce::Time::getMillisecondCounterHiRes();
+
+        for (size_t i = 0; i < numInstances; ++i)
+        {
+            const auto& blob = blobs[(i + 1) % numInstances];
+            instances[i]->setStateInformation (blob.getData(), (int) blob.getSize());
+        }
+
+        timings.restoreMilliseconds = juce::Time::getMillisecondCounterHiRes() - start;
+
+        for (size_t i = 0; i < numInstances; ++i)
+        {
+            timings.bytesPerInstance += blobs[i].getSize();
+            timings.mismatches += countMismatches (*instances[i], expected[(i + 1) % numInstances]);
+        }
+
+        timings.bytesPerInstance /= juce::jmax ((size_t) 1, numInstances);
+        return timings;
+    }
+}
+
+//==============================================================================
+Result run (int numInstances)
+{
+    Result result;
+    result.numInstances = numInstances;
+
+    Instances instances;
+
+    for (int i = 0; i < numInstances; ++i)
+        instances.push_back (std::make_unique<NoctaveAudioProcessor>());
+
+    // Every instance gets its own legal settings, as in a real session
+    juce::Random random (1);
+
+    for (auto& instance : instances)
+        for (auto* parameter : instance->getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                ranged->setValueNotifyingHost (ranged->convertTo0to1 (ranged->convertFrom0to1 (random.nextFloat())));
+
+    result.binary = roundTrip (instances, [] (NoctaveAudioProcessor& instance, juce::MemoryBlock& blob)
+    {
+        instance.getStateInformation (blob);
+    });
+
+    // What getStateInformation did before the binary format; restoring goes through
+    // setStateInformation's path for old sessions
+    result.xml = roundTrip (instances, [] (NoctaveAudioProcessor& instance, juce::MemoryBlock& blob)
+    {
+        if (auto xml = instance.apvts.copyState().createXml())
+            juce::AudioProcessor::copyXmlToBinary (*xml, blob);
+    });
+
+    return result;
+}
+
+juce::String toText (const Result& result)
+{
+    const auto describe = [&result] (const juce::String& name, const Timings& timings)
+    {
+        const auto perInstance = [&result] (double milliseconds)
+        {
+            return juce::String (milliseconds * 1000.0 / juce::jmax (1, result.numInstances), 1) + " us each";
+        };
+
+        return name + "save " + juce::String (timings.saveMilliseconds, 1) + " ms (" + perInstance (timings.saveMilliseconds)
+                 + "), restore " + juce::String (timings.restoreMilliseconds, 1) + " ms (" + perInstance (timings.restoreMilliseconds)
+                 + "), " + juce::String ((juce::int64) timings.bytesPerInstance) + " bytes each, "
+                 + (timings.mismatches == 0 ? juce::String ("all parameters restored")
+                                            : juce::String (timings.mismatches) + " parameters not restored") + "\n";
+    };
+
+    return "State round trip of " + juce::String (result.numInstances) + " instances:\n"
+             + describe ("  Binary: ", result.binary)
+             + describe ("  XML:    ", result.xml);
+}
+}
@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    StateBenchmark.h
+    Times saving and restoring the state of many plugin instances.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Measures what a session with many instances costs to save and load.
+
+    Each instance is given different settings, then every instance's state is
+    saved and restored into its neighbour, once in the binary format and once
+    as the APVTS XML it replaced. Restoring through setStateInformation covers
+    the same work a host triggers, including the XML path older sessions take.
+    Every restored parameter is compared with the value that was saved.
+*/
+namespace StateBenchmark
+{
+    struct Timings
+    {
+        double saveMilliseconds = 0.0;      // For all instances
+        double restoreMilliseconds = 0.0;
+        size_t bytesPerInstance = 0;
+        int mismatches = 0;                 // Parameters that didn't come back as saved
+    };
+
+    struct Result
+    {
+        int numInstances = 0;
+        Timings binary, xml;
+    };
+
+    Result run (int numInstances);
+
+    juce::String toText (const Result& result);
+}
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command-line entry point of the streaming pipeline.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ParameterControl.h"
+#include "StreamPipeline.h"
+
+#if ! JUCE_WINDOWS
+ #include <csignal>
+#endif
+
+namespace
+{
+    // stdout carries the audio, so everything else goes to stderr
+    void printUsage()
+    {
+        std::cerr << "Usage: NoctavePipeline [options] < input > output\n\n"
+                     "Streams PCM through Noctave, from stdin (or --input) to stdout. WAV input is\n"
+                     "detected from its header; anything else is raw interleaved samples.\n\n"
+                     "  --input <file>          read a file, mapped into memory, instead of stdin\n"
+                     "  --format s16|s24|s32|f32  raw input encoding (default f32)\n"
+                     "  --rate <Hz>             raw input sample rate (default 48000)\n"
+                     "  --channels 1|2          raw input channels (default 2)\n"
+                     "  --output-format wav|s16|s24|s32|f32\n"
+                     "                          default: WAV for WAV input, else the input encoding\n"
+                     "  --block <frames>        processing block size (default 256)\n"
+                     "  --set ID=value          set a parameter before starting; can be repeated\n"
+                     "  --control <file>        apply ID=value lines from a file whenever it changes\n"
+                     "  --bpm <tempo>           run a playing transport, for tempo-synced features\n"
+                     "  --list                  list the parameters and their defaults, then exit\n";
+    }
+
+    bool fail (const juce::String& message)
+    {
+        std::cerr << message << "\n";
+        return false;
+    }
+
+    bool parseRawLayout (const juce::ArgumentList& arguments, PcmFormat::Layout& layout)
+    {
+        if (arguments.containsOption ("--format")
+             && ! PcmFormat::parseEncoding (arguments.getValueForOption ("--format"), layout.encoding))
+            return fail ("Unknown --format " + arguments.getValueForOption ("--format"));
+
+        if (arguments.containsOption ("--rate"))
+            layout.sampleRate = arguments.getValueForOption ("--rate").getDoubleValue();
+
+        if (arguments.containsOption ("--channels"))
+            layout.numChannels = arguments.getValueForOption ("--channels").getIntValue();
+
+        return true;
+    }
+
+    bool applySettings (const juce::ArgumentList& arguments, juce::AudioProcessorValueTreeState& state)
+    {
+        for (int i = 0; i + 1 < arguments.size(); ++i)
+        {
+            if (arguments[i].text != "--set")
+                continue;
+
+            juce::String error;
+
+            if (! ParameterControl::apply (state, arguments[i + 1].text, error))
+                return fail (error);
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+   #if ! JUCE_WINDOWS
+    // A reader that goes away shows up as a failed write, not a signal that kills us
+    std::signal (SIGPIPE, SIG_IGN);
+   #endif
+
+    // The processor's timer needs a message loop; samples go through on their own thread
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    NoctaveAudioProcessor processor;
+
+    if (arguments.containsOption ("--list"))
+    {
+        std::cerr << ParameterControl::describe (processor.apvts);
+        return 0;
+    }
+
+    PcmFormat::Layout rawLayout;
+
+    if (! parseRawLayout (arguments, rawLayout) || ! applySettings (arguments, processor.apvts))
+        return 1;
+
+    const int blockSize = arguments.containsOption ("--block") ? arguments.getValueForOption ("--block").getIntValue() : 256;
+
+    if (blockSize < 16 || blockSize > 8192)
+    {
+        std::cerr << "--block must be between 16 and 8192 frames\n";
+        return 1;
+    }
+
+    juce::String error;
+    auto input = arguments.containsOption ("--input")
+                   ? PcmInput::openMappedFile (arguments.getFileForOption ("--input"), rawLayout, error)
+                   : PcmInput::openStandardInput (rawLayout, error);
+
+    if (input == nullptr)
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+
+    const auto& layout = input->getLayout();
+
+    if (layout.numChannels < 1 || layout.numChannels > 2 || layout.sampleRate < 8000.0 || layout.sampleRate > 384000.0)
+    {
+        std::cerr << "Input must be mono or stereo at 8 to 384 kHz\n";
+        return 1;
+    }
+
+    StreamPipeline::Options options;
+    options.blockSize = blockSize;
+    options.outputLayout = layout;
+    options.wavOutput = input->isWav();
+    options.bpm = arguments.containsOption ("--bpm") ? arguments.getValueForOption ("--bpm").getDoubleValue() : 0.0;
+
+    if (arguments.containsOption ("--output-format"))
+    {
+        const auto outputFormat = arguments.getValueForOption ("--output-format");
+        options.wavOutput = outputFormat == "wav";
+
+        if (! options.wavOutput && ! PcmFormat::parseEncoding (outputFormat, options.outputLayout.encoding))
+        {
+            std::cerr << "Unknown --output-format " << outputFormat << "\n";
+            return 1;
+        }
+    }
+
+    // Offline, so work handed to other threads is waited for rather than dropped when
+    // it runs late: the stream goes as fast as the machine allows without glitching
+    processor.setPlayConfigDetails (layout.numChannels, layout.numChannels, layout.sampleRate, blockSize);
+    processor.setNonRealtime (true);
+    processor.prepareToPlay (layout.sampleRate, blockSize);
+
+    std::unique_ptr<ControlFile> controlFile;
+
+    if (arguments.containsOption ("--control"))
+        controlFile = std::make_unique<ControlFile> (processor.apvts, arguments.getFileForOption ("--control"));
+
+    auto& messageManager = *juce::MessageManager::getInstance();
+
+    StreamPipeline pipeline (processor, std::move (input), options);
+    pipeline.onFinished = [&messageManager] { messageManager.stopDispatchLoop(); };
+    pipeline.start();
+
+    messageManager.runDispatchLoop();
+
+    processor.releaseResources();
+    return pipeline.getExitCode();
+}
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    ParameterControl.cpp
+    Parameter changes from the command line and from a watched control file.
+
+  ==============================================================================
+*/
+
+#include "ParameterControl.h"
+
+namespace
+{
+    // Often enough that a change lands within a few blocks, rarely enough to cost nothing
+    constexpr int pollMilliseconds = 20;
+
+    bool split (const juce::String& assignment, juce::String& id, juce::String& value)
+    {
+        const auto separator = assignment.indexOfChar ('=');
+
+        if (separator <= 0)
+            return false;
+
+        id = assignment.substring (0, separator).trim();
+        value = assignment.substring (separator + 1).trim();
+        return id.isNotEmpty() && value.isNotEmpty();
+    }
+}
+
+//==============================================================================
+bool ParameterControl::apply (juce::AudioProcessorValueTreeState& state, const juce::String& assignment, juce::String& error)
+{
+    juce::String id, value;
+
+    if (! split (assignment, id, value))
+    {
+        error = "Expected ID=value, got \"" + assignment + "\"";
+        return false;
+    }
+
+    auto* parameter = state.getParameter (id);
+
+    if (parameter == nullptr)
+    {
+        error = "Unknown parameter " + id + " (--list shows them all)";
+        return false;
+    }
+
+    parameter->setValueNotifyingHost (parameter->getValueForText (value));
+    return true;
+}
+
+juce::String ParameterControl::describe (juce::AudioProcessorValueTreeState& state)
+{
+    juce::String result;
+
+    for (auto* parameter : state.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            result << ranged->getParameterID().paddedRight (' ', 22) << ranged->getName (40).paddedRight (' ', 24)
+                   << ranged->getCurrentValueAsText() << " " << ranged->getLabel() << "\n";
+
+    return result;
+}
+
+//==============================================================================
+ControlFile::ControlFile (juce::AudioProcessorValueTreeState& stateToControl, const juce::File& fileToWatch)
+    : state (stateToControl), file (fileToWatch)
+{
+    reload();
+    startTimer (pollMilliseconds);
+}
+
+void ControlFile::timerCallback()
+{
+    if (file.getLastModificationTime() != lastModified)
+        reload();
+}
+
+void ControlFile::reload()
+{
+    lastModified = file.getLastModificationTime();
+
+    juce::StringArray lines;
+    file.readLines (lines);
+
+    for (const auto& line : lines)
+    {
+        const auto assignment = line.trim();
+        juce::String id, value, error;
+
+        if (assignment.isEmpty() || assignment.startsWithChar ('#'))
+            continue;
+
+        if (! split (assignment, id, value) || appliedValues[id] == value)
+            continue;
+
+        if (ParameterControl::apply (state, assignment, error))
+            appliedValues.set (id, value);
+        else
+            std::cerr << file.getFileName() << ": " << error << std::endl;
+    }
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    ParameterControl.h
+    Parameter changes from the command line and from a watched control file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Sets the processor's parameters from "ID=value" text. Values are read the
+    way the parameter reads typed text, so numbers are in its own units
+    (semitones, ms, 0 to 1 for Mix) and choices can be given by name.
+*/
+namespace ParameterControl
+{
+    /** Applies one assignment. Returns false with error set if it can't. */
+    bool apply (juce::AudioProcessorValueTreeState& state, const juce::String& assignment, juce::String& error);
+
+    /** One line per parameter: its ID, name and current value, for --list. */
+    juce::String describe (juce::AudioProcessorValueTreeState& state);
+}
+
+//==============================================================================
+/**
+    Watches a text file of assignments, one per line, and applies them whenever
+    the file changes, so a running stream can be steered by rewriting it.
+    Blank lines and lines starting with # are skipped. Only lines that changed
+    since the last read are applied, so a parameter that's also being set some
+    other way isn't pulled back on every reload. Runs on the message thread.
+*/
+class ControlFile  : private juce::Timer
+{
+public:
+    ControlFile (juce::AudioProcessorValueTreeState& state, const juce::File& file);
+
+private:
+    void timerCallback() override;
+    void reload();
+
+    juce::AudioProcessorValueTreeState& state;
+    juce::File file;
+    juce::Time lastModified;
+    juce::StringPairArray appliedValues;
+};
@@ -0,0 +1,243 @@
+/*
+  ==============================================================================
+
+    PcmFormat.cpp
+    Raw and WAV PCM encodings read and written by the pipeline.
+
+  ==============================================================================
+*/
+
+#include "PcmFormat.h"
+
+namespace
+{
+    constexpr juce::uint16 wavePcm = 1, waveFloat = 3, waveExtensible = 0xfffe;
+
+    // Streamed WAV files mark the lengths they can't know with this
+    constexpr juce::uint32 unknownLength = 0xffffffff;
+
+    bool hasTag (const char* bytes, const char* tag) noexcept
+    {
+        return std::memcmp (bytes, tag, 4) == 0;
+    }
+
+    void appendTag (juce::MemoryOutputStream& stream, const char* tag)
+    {
+        stream.write (tag, 4);
+    }
+}
+
+//==============================================================================
+int PcmFormat::Layout::getBytesPerSample() const noexcept
+{
+    switch (encoding)
+    {
+        case Encoding::int16:   return 2;
+        case Encoding::int24:   return 3;
+        case Encoding::int32:
+        case Encoding::float32:
+        default:                return 4;
+    }
+}
+
+bool PcmFormat::parseEncoding (const juce::String& name, Encoding& result) noexcept
+{
+    static const juce::StringArray names { "s16", "s24", "s32", "f32" };
+    const auto index = names.indexOf (name.trim(), true);
+
+    if (index < 0)
+        return false;
+
+    result = static_cast<Encoding> (index);
+    return true;
+}
+
+bool PcmFormat::isWavHeader (const void* riffHeader) noexcept
+{
+    const auto* bytes = static_cast<const char*> (riffHeader);
+    return hasTag (bytes, "RIFF") && hasTag (bytes + 8, "WAVE");
+}
+
+bool PcmFormat::readWavChunks (const std::function<bool (void*, size_t)>& readBytes, Layout& layout,
+                               juce::int64& dataBytes, juce::String& error)
+{
+    bool hasFormat = false;
+
+    for (;;)
+    {
+        char chunkHeader[8];
+
+        if (! readBytes (chunkHeader, sizeof (chunkHeader)))
+        {
+            error = "WAV input ended before its sample data";
+            return false;
+        }
+
+        const auto chunkSize = juce::ByteOrder::littleEndianInt (chunkHeader + 4);
+
+        if (hasTag (chunkHeader, "data"))
+        {
+            if (! hasFormat)
+            {
+                error = "WAV input has no format chunk before its sample data";
+                return false;
+            }
+
+            dataBytes = chunkSize == unknownLength || chunkSize == 0 ? -1 : (juce::int64) chunkSize;
+            return true;
+        }
+
+        // Chunks are padded to an even length
+        juce::HeapBlock<char> body ((size_t) chunkSize + (chunkSize & 1));
+
+        if (! readBytes (body.get(), (size_t) chunkSize + (chunkSize & 1)))
+        {
+            error = "WAV input ended inside a chunk";
+            return false;
+        }
+
+        if (! hasTag (chunkHeader, "fmt ") || chunkSize < 16)
+            continue;
+
+        auto format = juce::ByteOrder::littleEndianShort (body.get());
+        const int numChannels = juce::ByteOrder::littleEndianShort (body.get() + 2);
+        const auto sampleRate = juce::ByteOrder::littleEndianInt (body.get() + 4);
+        const int bitsPerSample = juce::ByteOrder::littleEndianShort (body.get() + 14);
+
+        // The extensible format keeps the real one at the start of its sub-format GUID
+        if (format == waveExtensible && chunkSize >= 26)
+            format = juce::ByteOrder::littleEndianShort (body.get() + 24);
+
+        if (format == wavePcm && bitsPerSample == 16)       layout.encoding = Encoding::int16;
+        else if (format == wavePcm && bitsPerSample == 24)  layout.encoding = Encoding::int24;
+        else if (format == wavePcm && bitsPerSample == 32)  layout.encoding = Encoding::int32;
+        else if (format == waveFloat && bitsPerSample == 32) layout.encoding = Encoding::float32;
+        else
+        {
+            error = "Unsupported WAV encoding (format " + juce::String (format) + ", "
+                      + juce::String (bitsPerSample) + " bits); use 16, 24 or 32-bit PCM or 32-bit float";
+            return false;
+        }
+
+        layout.numChannels = numChannels;
+        layout.sampleRate = (double) sampleRate;
+        hasFormat = true;
+    }
+}
+
+juce::MemoryBlock PcmFormat::createWavHeader (const Layout& layout)
+{
+    juce::MemoryOutputStream stream;
+
+    appendTag (stream, "RIFF");
+    stream.writeInt ((int) unknownLength);
+    appendTag (stream, "WAVE");
+
+    appendTag (stream, "fmt ");
+    stream.writeInt (16);
+    stream.writeShort ((short) (layout.encoding == Encoding::float32 ? waveFloat : wavePcm));
+    stream.writeShort ((short) layout.numChannels);
+    stream.writeInt ((int) layout.sampleRate);
+    stream.writeInt ((int) layout.sampleRate * layout.getBytesPerFrame());
+    stream.writeShort ((short) layout.getBytesPerFrame());
+    stream.writeShort ((short) (layout.getBytesPerSample() * 8));
+
+    appendTag (stream, "data");
+    stream.writeInt ((int) unknownLength);
+
+    return stream.getMemoryBlock();
+}
+
+//==============================================================================
+void PcmFormat::decode (const void* source, const Layout& layout, float* const* destination, int numFrames) noexcept
+{
+    const auto* bytes = static_cast<const char*> (source);
+    const int bytesPerSample = layout.getBytesPerSample();
+    const int stride = layout.getBytesPerFrame();
+
+    for (int channel = 0; channel < layout.numChannels; ++channel)
+    {
+        const auto* in = bytes + channel * bytesPerSample;
+        auto* out = destination[channel];
+
+        switch (layout.encoding)
+        {
+            case Encoding::int16:
+                for (int i = 0; i < numFrames; ++i, in += stride)
+                    out[i] = (float) (juce::int16) juce::ByteOrder::littleEndianShort (in) * (1.0f / 32768.0f);
+                break;
+
+            case Encoding::int24:
+                for (int i = 0; i < numFrames; ++i, in += stride)
+                    out[i] = (float) juce::ByteOrder::littleEndian24Bit (in) * (1.0f / 8388608.0f);
+                break;
+
+            case Encoding::int32:
+                for (int i = 0; i < numFrames; ++i, in += stride)
+                    out[i] = (float) ((double) (juce::int32) juce::ByteOrder::littleEndianInt (in) * (1.0 / 2147483648.0));
+                break;
+
+            case Encoding::float32:
+            default:
+                for (int i = 0; i < numFrames; ++i, in += stride)
+                {
+                    const auto bits = juce::ByteOrder::littleEndianInt (in);
+                    std::memcpy (out + i, &bits, sizeof (float));
+                }
+                break;
+        }
+    }
+}
+
+void PcmFormat::encode (const float* const* source, const Layout& layout, void* destination, int numFrames) noexcept
+{
+    auto* bytes = static_cast<char*> (destination);
+    const int bytesPerSample = layout.getBytesPerSample();
+    const int stride = layout.getBytesPerFrame();
+
+    const auto toInteger = [] (float sample, double fullScale)
+    {
+        return (juce::int64) std::lround (juce::jlimit (-1.0, 1.0, (double) sample) * fullScale);
+    };
+
+    for (int channel = 0; channel < layout.numChannels; ++channel)
+    {
+        auto* out = bytes + channel * bytesPerSample;
+        const auto* in = source[channel];
+
+        switch (layout.encoding)
+        {
+            case Encoding::int16:
+                for (int i = 0; i < numFrames; ++i, out += stride)
+                {
+                    const auto value = juce::ByteOrder::swapIfBigEndian ((juce::uint16) (juce::int16) juce::jmin ((juce::int64) 32767, toInteger (in[i], 32768.0)));
+                    std::memcpy (out, &value, sizeof (value));
+                }
+                break;
+
+            case Encoding::int24:
+                for (int i = 0; i < numFrames; ++i, out += stride)
+                    juce::ByteOrder::littleEndian24BitToChars ((int) juce::jmin ((juce::int64) 8388607, toInteger (in[i], 8388608.0)), out);
+                break;
+
+            case Encoding::int32:
+                for (int i = 0; i < numFrames; ++i, out += stride)
+                {
+                    const auto value = juce::ByteOrder::swapIfBigEndian ((juce::uint32) (juce::int32) juce::jmin ((juce::int64) 2147483647, toInteger (in[i], 2147483648.0)));
+                    std::memcpy (out, &value, sizeof (value));
+                }
+                break;
+
+            case Encoding::float32:
+            default:
+                for (int i = 0; i < numFrames; ++i, out += stride)
+                {
+                    juce::uint32 bits;
+                    std::memcpy (&bits, in + i, sizeof (float));
+                    bits = juce::ByteOrder::swapIfBigEndian (bits);
+                    std::memcpy (out, &bits, sizeof (bits));
+                }
+                break;
+        }
+    }
+}
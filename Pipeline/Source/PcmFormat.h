@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    PcmFormat.h
+    Raw and WAV PCM encodings read and written by the pipeline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Interleaved little-endian PCM, as it arrives on a pipe or sits in a file.
+    WAV headers are parsed and written by hand, as a stream has no length to
+    seek back and fill in: headers written here say "unknown length", which
+    readers that stream (ffmpeg, sox) accept.
+*/
+namespace PcmFormat
+{
+    enum class Encoding
+    {
+        int16 = 0,
+        int24,
+        int32,
+        float32
+    };
+
+    struct Layout
+    {
+        Encoding encoding = Encoding::float32;
+        int numChannels = 2;
+        double sampleRate = 48000.0;
+
+        int getBytesPerSample() const noexcept;
+        int getBytesPerFrame() const noexcept     { return getBytesPerSample() * numChannels; }
+    };
+
+    /** "s16", "s24", "s32" or "f32". Returns false for anything else. */
+    bool parseEncoding (const juce::String& name, Encoding& result) noexcept;
+
+    /** Size of the RIFF header that starts a WAV file. */
+    constexpr int riffHeaderSize = 12;
+
+    /** True if the first riffHeaderSize bytes are a RIFF header of a WAVE file. */
+    bool isWavHeader (const void* riffHeader) noexcept;
+
+    /** Reads the chunks after the RIFF header up to the start of the samples, with
+        readBytes filling exactly the bytes asked for or returning false at the end.
+        dataBytes is the length of the samples, or -1 if the header doesn't say.
+    */
+    bool readWavChunks (const std::function<bool (void*, size_t)>& readBytes, Layout& layout,
+                        juce::int64& dataBytes, juce::String& error);
+
+    /** A header for a stream of unknown length in layout's encoding. */
+    juce::MemoryBlock createWavHeader (const Layout& layout);
+
+    /** Interleaved frames to one float array per channel, and back. Integer encodings clip at full scale. */
+    void decode (const void* source, const Layout& layout, float* const* destination, int numFrames) noexcept;
+    void encode (const float* const* source, const Layout& layout, void* destination, int numFrames) noexcept;
+}
@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+    PcmStreams.cpp
+    PCM input from stdin or a mapped file, and double-buffered output to stdout.
+
+  ==============================================================================
+*/
+
+#include "PcmStreams.h"
+
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+namespace
+{
+    // Pipes are binary; Windows would otherwise translate line endings
+    void setBinaryMode (FILE* stream)
+    {
+       #if JUCE_WINDOWS
+        _setmode (_fileno (stream), _O_BINARY);
+       #else
+        juce::ignoreUnused (stream);
+       #endif
+    }
+
+    //==============================================================================
+    class StandardInput  : public PcmInput
+    {
+    public:
+        bool open (const PcmFormat::Layout& rawLayout, juce::String& error)
+        {
+            setBinaryMode (stdin);
+            layout = rawLayout;
+
+            char riffHeader[PcmFormat::riffHeaderSize];
+            const auto headerBytes = std::fread (riffHeader, 1, sizeof (riffHeader), stdin);
+
+            if (headerBytes == sizeof (riffHeader) && PcmFormat::isWavHeader (riffHeader))
+            {
+                wav = true;
+
+                const auto readBytes = [] (void* destination, size_t numBytes)
+                {
+                    return std::fread (destination, 1, numBytes, stdin) == numBytes;
+                };
+
+                if (! PcmFormat::readWavChunks (readBytes, layout, remainingBytes, error))
+                    return false;
+            }
+            else
+            {
+                // Raw samples: what was read looking for a header is the start of them
+                pending.append (riffHeader, headerBytes);
+            }
+
+            return true;
+        }
+
+        int read (float* const* destination, int numFrames) override
+        {
+            const auto frameBytes = (size_t) layout.getBytesPerFrame();
+            auto wanted = (size_t) numFrames * frameBytes;
+
+            if (remainingBytes >= 0)
+                wanted = juce::jmin (wanted, (size_t) remainingBytes);
+
+            bytes.ensureSize (wanted);
+
+            const auto fromPending = juce::jmin (wanted, pending.getSize());
+            bytes.copyFrom (pending.getData(), 0, fromPending);
+            pending.removeSection (0, fromPending);
+
+            const auto numBytes = fromPending + std::fread (static_cast<char*> (bytes.getData()) + fromPending,
+                                                            1, wanted - fromPending, stdin);
+
+            if (remainingBytes >= 0)
+                remainingBytes -= (juce::int64) numBytes;
+
+            // A frame cut off by the end of the input is dropped
+            const int framesRead = (int) (numBytes / frameBytes);
+            PcmFormat::decode (bytes.getData(), layout, destination, framesRead);
+            return framesRead;
+        }
+
+    private:
+        juce::MemoryBlock pending, bytes;
+        juce::int64 remainingBytes = -1;    // -1 until the end of the stream
+    };
+
+    //==============================================================================
+    class MappedInput  : public PcmInput
+    {
+    public:
+        explicit MappedInput (const juce::File& file)
+            : mapping (file, juce::MemoryMappedFile::readOnly, false)
+        {
+        }
+
+        bool open (const PcmFormat::Layout& rawLayout, juce::String& error)
+        {
+            layout = rawLayout;
+
+            const auto* data = static_cast<const char*> (mapping.getData());
+            const auto size = mapping.getSize();
+
+            if (data == nullptr)
+            {
+                error = "Couldn't map the input file";
+                return false;
+            }
+
+            position = data;
+            end = data + size;
+
+            if (size >= (size_t) PcmFormat::riffHeaderSize && PcmFormat::isWavHeader (data))
+            {
+                wav = true;
+                position += PcmFormat::riffHeaderSize;
+
+                const auto readBytes = [this] (void* destination, size_t numBytes)
+                {
+                    if ((size_t) (end - position) < numBytes)
+                        return false;
+
+                    std::memcpy (destination, position, numBytes);
+                    position += numBytes;
+                    return true;
+                };
+
+                juce::int64 dataBytes = -1;
+
+                if (! PcmFormat::readWavChunks (readBytes, layout, dataBytes, error))
+                    return false;
+
+                if (dataBytes >= 0 && dataBytes < end - position)
+                    end = position + dataBytes;
+            }
+
+            return true;
+        }
+
+        int read (float* const* destination, int numFrames) override
+        {
+            const auto frameBytes = layout.getBytesPerFrame();
+            const int framesRead = (int) juce::jmin ((juce::int64) numFrames, (juce::int64) (end - position) / frameBytes);
+
+            PcmFormat::decode (position, layout, destination, framesRead);
+            position += (size_t) framesRead * (size_t) frameBytes;
+            return framesRead;
+        }
+
+    private:
+        juce::MemoryMappedFile mapping;
+        const char* position = nullptr;
+        const char* end = nullptr;
+    };
+}
+
+//==============================================================================
+std::unique_ptr<PcmInput> PcmInput::openStandardInput (const PcmFormat::Layout& rawLayout, juce::String& error)
+{
+    auto input = std::make_unique<StandardInput>();
+
+    if (! input->open (rawLayout, error))
+        return {};
+
+    return input;
+}
+
+std::unique_ptr<PcmInput> PcmInput::openMappedFile (const juce::File& file, const PcmFormat::Layout& rawLayout,
+                                                    juce::String& error)
+{
+    auto input = std::make_unique<MappedInput> (file);
+
+    if (! input->open (rawLayout, error))
+        return {};
+
+    return input;
+}
+
+//==============================================================================
+DoubleBufferedOutput::DoubleBufferedOutput (size_t bufferBytes)
+    : juce::Thread ("Noctave output")
+{
+    setBinaryMode (stdout);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        buffers[(size_t) i].malloc (bufferBytes);
+        emptied[(size_t) i].signal();
+    }
+
+    startThread();
+}
+
+DoubleBufferedOutput::~DoubleBufferedOutput()
+{
+    finish();
+}
+
+char* DoubleBufferedOutput::acquire()
+{
+    jassert (! finished);
+
+    emptied[(size_t) fillIndex].wait();
+    return buffers[(size_t) fillIndex].get();
+}
+
+bool DoubleBufferedOutput::submit (size_t numBytes)
+{
+    sizes[(size_t) fillIndex] = (juce::int64) numBytes;
+    filled[(size_t) fillIndex].signal();
+    fillIndex ^= 1;
+
+    return ! failed.load();
+}
+
+bool DoubleBufferedOutput::finish()
+{
+    if (! std::exchange (finished, true))
+    {
+        emptied[(size_t) fillIndex].wait();
+        sizes[(size_t) fillIndex] = endOfStream;
+        filled[(size_t) fillIndex].signal();
+
+        waitForThreadToExit (-1);
+    }
+
+    return ! failed.load();
+}
+
+void DoubleBufferedOutput::run()
+{
+    for (int writeIndex = 0;; writeIndex ^= 1)
+    {
+        filled[(size_t) writeIndex].wait();
+
+        const auto size = sizes[(size_t) writeIndex];
+
+        if (size == endOfStream)
+            return;
+
+        // Flushed block by block, so the next stage hears each one as soon as it's ready
+        if (! failed.load()
+             && (std::fwrite (buffers[(size_t) writeIndex].get(), 1, (size_t) size, stdout) != (size_t) size
+                  || std::fflush (stdout) != 0))
+            failed.store (true);
+
+        emptied[(size_t) writeIndex].signal();
+    }
+}
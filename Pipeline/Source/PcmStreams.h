@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    PcmStreams.h
+    PCM input from stdin or a mapped file, and double-buffered output to stdout.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PcmFormat.h"
+
+//==============================================================================
+/**
+    Where the pipeline's samples come from. Either source can start with a WAV
+    header, which then overrides the raw layout given for it.
+*/
+class PcmInput
+{
+public:
+    /** Standard input, read as it arrives. */
+    static std::unique_ptr<PcmInput> openStandardInput (const PcmFormat::Layout& rawLayout, juce::String& error);
+
+    /** A file mapped into memory, decoded straight from the mapping with no copy. */
+    static std::unique_ptr<PcmInput> openMappedFile (const juce::File& file, const PcmFormat::Layout& rawLayout,
+                                                     juce::String& error);
+
+    virtual ~PcmInput() = default;
+
+    const PcmFormat::Layout& getLayout() const noexcept     { return layout; }
+    bool isWav() const noexcept                             { return wav; }
+
+    /** Decodes up to numFrames frames into one array per channel. Returns how many
+        it decoded, which is only short of numFrames at the end of the input.
+    */
+    virtual int read (float* const* destination, int numFrames) = 0;
+
+protected:
+    PcmFormat::Layout layout;
+    bool wav = false;
+};
+
+//==============================================================================
+/**
+    Writes to stdout from its own thread, so encoding the next block overlaps
+    writing the last one.
+
+    There are two buffers. The processing thread fills one while the writer
+    thread writes and flushes the other, and each side only waits when it
+    catches up with the other. A write that fails (say, the reader closed the
+    pipe) is remembered, and later blocks are dropped rather than blocking.
+*/
+class DoubleBufferedOutput  : private juce::Thread
+{
+public:
+    explicit DoubleBufferedOutput (size_t bufferBytes);
+
+    /** Waits for everything submitted to be written. */
+    ~DoubleBufferedOutput() override;
+
+    /** The buffer to fill next, bufferBytes long. Waits until the writer is done with it. */
+    char* acquire();
+
+    /** Queues the first numBytes of the acquired buffer. Returns false once a write has failed. */
+    bool submit (size_t numBytes);
+
+    /** Writes whatever is queued and stops the writer. Returns false if any write failed. */
+    bool finish();
+
+private:
+    void run() override;
+
+    static constexpr juce::int64 endOfStream = -1;
+
+    std::array<juce::HeapBlock<char>, 2> buffers;
+    std::array<juce::int64, 2> sizes {};
+    std::array<juce::WaitableEvent, 2> filled, emptied;
+    int fillIndex = 0;
+    bool finished = false;
+    std::atomic<bool> failed { false };
+};
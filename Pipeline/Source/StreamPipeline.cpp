@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    StreamPipeline.cpp
+    Runs the processor over a PCM stream on its own thread.
+
+  ==============================================================================
+*/
+
+#include "StreamPipeline.h"
+
+//==============================================================================
+StreamPipeline::StreamPipeline (NoctaveAudioProcessor& processorToRun, std::unique_ptr<PcmInput> inputToRead,
+                                const Options& pipelineOptions)
+    : juce::Thread ("Noctave pipeline"),
+      processor (processorToRun),
+      input (std::move (inputToRead)),
+      options (pipelineOptions)
+{
+    jassert (input != nullptr && input->getLayout().numChannels == options.outputLayout.numChannels);
+
+    if (options.bpm > 0.0)
+    {
+        playHead.bpm = options.bpm;
+        playHead.sampleRate = input->getLayout().sampleRate;
+        processor.setPlayHead (&playHead);
+    }
+}
+
+StreamPipeline::~StreamPipeline()
+{
+    stopThread (-1);
+    processor.setPlayHead (nullptr);
+}
+
+void StreamPipeline::start()
+{
+    startThread (juce::Thread::Priority::high);
+}
+
+//==============================================================================
+void StreamPipeline::run()
+{
+    const int blockSize = options.blockSize;
+    const auto& outputLayout = options.outputLayout;
+    const int numChannels = outputLayout.numChannels;
+
+    juce::AudioBuffer<float> block (numChannels, blockSize);
+    std::vector<const float*> channels ((size_t) numChannels);
+    juce::MidiBuffer noMidi;
+
+    const auto header = options.wavOutput ? PcmFormat::createWavHeader (outputLayout) : juce::MemoryBlock();
+    DoubleBufferedOutput output (juce::jmax ((size_t) (blockSize * outputLayout.getBytesPerFrame()), header.getSize()));
+
+    if (! header.isEmpty())
+    {
+        std::memcpy (output.acquire(), header.getData(), header.getSize());
+        output.submit (header.getSize());
+    }
+
+    // The first latency samples out are the processor filling up, not the input
+    int compensatedLatency = processor.getLatencySamples();
+    juce::int64 framesToSkip = compensatedLatency;
+    juce::int64 framesIn = 0, framesOut = 0, framesProcessed = 0;
+    bool inputEnded = false;
+
+    while (! threadShouldExit() && (! inputEnded || framesOut < framesIn))
+    {
+        int numRead = 0;
+
+        if (! inputEnded)
+        {
+            numRead = input->read (block.getArrayOfWritePointers(), blockSize);
+            inputEnded = numRead < blockSize;
+            framesIn += numRead;
+        }
+
+        // Blocks are always full, padded with silence once the input runs out
+        for (int channel = 0; channel < numChannels; ++channel)
+            block.clear (channel, numRead, blockSize - numRead);
+
+        playHead.timeInSamples = framesProcessed;
+        processor.processBlock (block, noMidi);
+        framesProcessed += blockSize;
+
+        // A parameter change that adds latency (say, a longer transient lookahead) delays
+        // everything after it, so that much more is skipped to stay aligned with the input
+        const int latency = processor.getLatencySamples();
+
+        if (latency > compensatedLatency)
+            framesToSkip += latency - compensatedLatency;
+
+        compensatedLatency = latency;
+
+        const int skipped = (int) juce::jmin ((juce::int64) blockSize, framesToSkip);
+        const int numOut = (int) juce::jmin ((juce::int64) (blockSize - skipped), framesIn - framesOut);
+        framesToSkip -= skipped;
+
+        if (numOut <= 0)
+            continue;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[(size_t) channel] = block.getReadPointer (channel, skipped);
+
+        PcmFormat::encode (channels.data(), outputLayout, output.acquire(), numOut);
+        framesOut += numOut;
+
+        if (! output.submit ((size_t) numOut * (size_t) outputLayout.getBytesPerFrame()))
+            break;
+    }
+
+    exitCode.store (output.finish() ? 0 : 1);
+
+    juce::MessageManager::callAsync ([this] { if (onFinished != nullptr) onFinished(); });
+}
+
+//==============================================================================
+juce::Optional<juce::AudioPlayHead::PositionInfo> StreamPipeline::FixedTempoPlayHead::getPosition() const
+{
+    PositionInfo position;
+    position.setBpm (bpm);
+    position.setTimeSignature (TimeSignature {});
+    position.setTimeInSamples (timeInSamples);
+    position.setTimeInSeconds ((double) timeInSamples / sampleRate);
+    position.setPpqPosition ((double) timeInSamples / sampleRate * bpm / 60.0);
+    position.setIsPlaying (true);
+    return position;
+}
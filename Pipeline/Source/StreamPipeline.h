@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    StreamPipeline.h
+    Runs the processor over a PCM stream on its own thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PcmStreams.h"
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+/**
+    Reads blocks from the input, processes them and writes them out, until the
+    input ends. The processor's latency is taken off the front of the output and
+    the tail it holds back is flushed with silence at the end, so the output is
+    exactly as long as the input and lines up with it sample for sample.
+
+    The message thread stays free for the processor's timer and the control
+    file; onFinished is called from there once the last block is written.
+*/
+class StreamPipeline  : private juce::Thread
+{
+public:
+    struct Options
+    {
+        int blockSize = 256;
+        PcmFormat::Layout outputLayout;
+        bool wavOutput = false;
+        double bpm = 0.0;       // 0 leaves the processor with no transport
+    };
+
+    StreamPipeline (NoctaveAudioProcessor& processor, std::unique_ptr<PcmInput> input, const Options& options);
+    ~StreamPipeline() override;
+
+    void start();
+
+    /** 0 once everything was written, 1 if the output failed. */
+    int getExitCode() const noexcept    { return exitCode.load(); }
+
+    std::function<void()> onFinished;
+
+private:
+    void run() override;
+
+    //==============================================================================
+    /** A transport that's always playing at a fixed tempo, so synced features run. */
+    class FixedTempoPlayHead  : public juce::AudioPlayHead
+    {
+    public:
+        double bpm = 120.0;
+        double sampleRate = 48000.0;
+        juce::int64 timeInSamples = 0;
+
+        juce::Optional<PositionInfo> getPosition() const override;
+    };
+
+    NoctaveAudioProcessor& processor;
+    std::unique_ptr<PcmInput> input;
+    const Options options;
+    FixedTempoPlayHead playHead;
+    std::atomic<int> exitCode { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamPipeline)
+};
@@ -0,0 +1,361 @@
+/*
+  ==============================================================================
+
+    ARADocumentController.cpp
+    ARA document controller: background analysis and pre-rendering of clips.
+
+  ==============================================================================
+*/
+
+#include "ARADocumentController.h"
+
+#if JucePlugin_Enable_ARA
+
+#include "ARAPlaybackRenderer.h"
+#include "ClipShifter.h"
+
+namespace
+{
+    constexpr int archiveVersion = 1;
+    constexpr int readBlockSize = 1 << 16;
+}
+
+//==============================================================================
+void NoctaveAudioSource::publish (std::unique_ptr<Rendering> newRendering)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock (renderingLock);
+        std::swap (rendering, newRendering);
+    }
+
+    // newRendering now holds the old one, freed here rather than on the audio thread
+}
+
+std::shared_ptr<const juce::AudioBuffer<float>> NoctaveAudioSource::getAudio() const
+{
+    const juce::SpinLock::ScopedLockType lock (renderingLock);
+    return rendering != nullptr ? rendering->audio : nullptr;
+}
+
+std::shared_ptr<const SourceAnalysis> NoctaveAudioSource::getAnalysis() const
+{
+    const juce::SpinLock::ScopedLockType lock (renderingLock);
+    return rendering != nullptr ? rendering->analysis : nullptr;
+}
+
+float NoctaveAudioSource::getRenderedSemitones() const
+{
+    const juce::SpinLock::ScopedLockType lock (renderingLock);
+    return rendering != nullptr ? rendering->semitones : 0.0f;
+}
+
+//==============================================================================
+/**
+    Reads a source from the host (if given a reader), analyses every chunk the
+    cache doesn't already hold, renders the shift and publishes the result.
+*/
+class NoctaveDocumentController::SourceJob  : public juce::ThreadPoolJob
+{
+public:
+    SourceJob (NoctaveDocumentController& ownerIn, NoctaveAudioSource& sourceIn,
+               std::unique_ptr<juce::ARAAudioSourceReader> readerIn, float semitonesIn)
+        : juce::ThreadPoolJob ("Noctave source analysis"),
+          owner (ownerIn), source (sourceIn), reader (std::move (readerIn)), semitones (semitonesIn)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto audio = source.getAudio();
+        auto analysis = source.getAnalysis();
+
+        if (reader != nullptr)
+        {
+            audio = readSamples();
+
+            if (audio == nullptr)
+                return jobHasFinished;
+
+            // Let the source's regions play dry while the new audio is analysed
+            auto dryOnly = std::make_unique<NoctaveAudioSource::Rendering>();
+            dryOnly->audio = audio;
+            dryOnly->semitones = semitones;
+            source.publish (std::move (dryOnly));
+
+            analysis = analyse (*audio);
+        }
+
+        if (audio == nullptr || analysis == nullptr || shouldExit())
+            return jobHasFinished;
+
+        auto rendering = std::make_unique<NoctaveAudioSource::Rendering>();
+        rendering->audio = audio;
+        rendering->analysis = analysis;
+        rendering->semitones = semitones;
+
+        if (ClipShifter::render (*audio, rendering->shifted, *analysis,
+                                 std::pow (2.0f, semitones / 12.0f), [this] { return shouldExit(); }))
+            source.publish (std::move (rendering));
+
+        return jobHasFinished;
+    }
+
+private:
+    std::shared_ptr<const juce::AudioBuffer<float>> readSamples()
+    {
+        const auto numSamples = source.getSampleCount();
+        const auto numChannels = source.getChannelCount();
+
+        if (numChannels <= 0 || numSamples <= 0 || numSamples > std::numeric_limits<int>::max())
+            return nullptr;
+
+        auto audio = std::make_shared<juce::AudioBuffer<float>> (numChannels, (int) numSamples);
+        std::vector<float*> destinations ((size_t) numChannels);
+
+        for (int start = 0; start < (int) numSamples; start += readBlockSize)
+        {
+            if (shouldExit())
+                return nullptr;
+
+            const int num = juce::jmin (readBlockSize, (int) numSamples - start);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                destinations[(size_t) channel] = audio->getWritePointer (channel, start);
+
+            if (! reader->read (destinations.data(), numChannels, start, num))
+                return nullptr;
+        }
+
+        return audio;
+    }
+
+    std::shared_ptr<const SourceAnalysis> analyse (const juce::AudioBuffer<float>& audio)
+    {
+        auto analysis = std::make_shared<SourceAnalysis>();
+        analysis->sampleRate = source.getSampleRate();
+        analysis->numSamples = audio.getNumSamples();
+
+        SourceAnalyser analyser (analysis->sampleRate);
+        std::vector<float> input ((size_t) (SourceAnalysis::chunkSize + 2 * SourceAnalysis::chunkMargin));
+        int numReused = 0;
+
+        for (int chunkIndex = 0; chunkIndex < SourceAnalysis::getNumChunks (analysis->numSamples); ++chunkIndex)
+        {
+            if (shouldExit())
+                return nullptr;
+
+            SourceAnalysis::getChunkInput (audio, chunkIndex, input.data());
+            const auto hash = SourceAnalysis::hashChunkInput (input.data(), analysis->sampleRate);
+
+            auto chunk = owner.analysisCache.find (hash);
+
+            if (chunk != nullptr)
+            {
+                ++numReused;
+            }
+            else
+            {
+                chunk = analyser.analyseChunk (input.data());
+                owner.analysisCache.add (hash, chunk);
+            }
+
+            analysis->chunkHashes.push_back (hash);
+            analysis->chunks.push_back (std::move (chunk));
+        }
+
+        DBG ("Noctave analysed " << source.getName() << ": " << numReused << " of "
+              << (int) analysis->chunks.size() << " chunks from the cache");
+
+        return analysis;
+    }
+
+    NoctaveDocumentController& owner;
+    NoctaveAudioSource& source;
+    std::unique_ptr<juce::ARAAudioSourceReader> reader;
+    const float semitones;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SourceJob)
+};
+
+//==============================================================================
+NoctaveDocumentController::NoctaveDocumentController (const ARA::PlugIn::PlugInEntry* entry,
+                                                      const ARA::ARADocumentControllerHostInstance* instance)
+    : juce::ARADocumentControllerSpecialisation (entry, instance),
+      pool (juce::ThreadPoolOptions{}
+              .withThreadName ("Noctave analysis")
+              .withNumberOfThreads (juce::jlimit (1, 4, juce::SystemStats::getNumCpus() - 1))
+              .withDesiredThreadPriority (juce::Thread::Priority::background))
+{
+    // Pitch changes from the renderers are picked up here, once they stop moving
+    startTimerHz (10);
+}
+
+NoctaveDocumentController::~NoctaveDocumentController()
+{
+    stopTimer();
+    pool.removeAllJobs (true, -1);
+    jobs.clear();
+}
+
+juce::ARAAudioSource* NoctaveDocumentController::doCreateAudioSource (juce::ARADocument* document, ARA::ARAAudioSourceHostRef hostRef)
+{
+    auto* source = new NoctaveAudioSource (document, hostRef);
+    source->addListener (this);
+    return source;
+}
+
+juce::ARAPlaybackRenderer* NoctaveDocumentController::doCreatePlaybackRenderer() noexcept
+{
+    return new NoctavePlaybackRenderer (getDocumentController());
+}
+
+//==============================================================================
+void NoctaveDocumentController::doUpdateAudioSourceContent (juce::ARAAudioSource* audioSource, juce::ARAContentUpdateScopes scopeFlags)
+{
+    if (scopeFlags.affectSamples() && audioSource->isSampleAccessEnabled())
+        startJob (*static_cast<NoctaveAudioSource*> (audioSource), true);
+}
+
+void NoctaveDocumentController::willEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable)
+{
+    // Nothing may read the host's samples once access is withdrawn
+    if (! enable)
+        cancelJob (audioSource);
+}
+
+void NoctaveDocumentController::didEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable)
+{
+    if (enable)
+        startJob (*static_cast<NoctaveAudioSource*> (audioSource), true);
+}
+
+void NoctaveDocumentController::willDestroyAudioSource (juce::ARAAudioSource* audioSource)
+{
+    cancelJob (audioSource);
+    audioSource->removeListener (this);
+}
+
+void NoctaveDocumentController::timerCallback()
+{
+    const auto semitones = targetSemitones.load();
+    const bool hasSettled = semitones == lastSeenSemitones;
+    lastSeenSemitones = semitones;
+
+    if (! hasSettled)
+        return;
+
+    for (auto* source : getDocument()->getAudioSources<NoctaveAudioSource>())
+    {
+        // A source still being read renders at the old pitch, and is caught on a later tick
+        if (auto it = jobs.find (source); it != jobs.end() && pool.contains (it->second.get()))
+            continue;
+
+        if (source->getAudio() != nullptr && source->getRenderedSemitones() != semitones)
+            startJob (*source, false);
+    }
+}
+
+//==============================================================================
+void NoctaveDocumentController::startJob (NoctaveAudioSource& source, bool readSamples)
+{
+    cancelJob (&source);
+
+    std::unique_ptr<juce::ARAAudioSourceReader> reader;
+
+    if (readSamples)
+    {
+        if (! source.isSampleAccessEnabled())
+            return;
+
+        reader = std::make_unique<juce::ARAAudioSourceReader> (&source);
+
+        if (! reader->isValid())
+            return;
+    }
+
+    auto job = std::make_unique<SourceJob> (*this, source, std::move (reader), targetSemitones.load());
+    pool.addJob (job.get(), false);
+    jobs[&source] = std::move (job);
+}
+
+void NoctaveDocumentController::cancelJob (juce::ARAAudioSource* source)
+{
+    auto it = jobs.find (source);
+
+    if (it == jobs.end())
+        return;
+
+    // Jobs check shouldExit() every block or chunk, so this wait is short; it
+    // has to finish before the job (and possibly its source) can be deleted
+    pool.removeJob (it->second.get(), true, -1);
+    jobs.erase (it);
+}
+
+//==============================================================================
+bool NoctaveDocumentController::doRestoreObjectsFromStream (juce::ARAInputStream& input,
+                                                            const juce::ARARestoreObjectsFilter* filter) noexcept
+{
+    // Archives from a newer build are skipped; the sources are simply analysed again
+    if (input.readInt() != archiveVersion)
+        return true;
+
+    const auto numSources = input.readInt();
+
+    for (int i = 0; i < numSources && ! input.failed(); ++i)
+    {
+        const auto persistentID = input.readString();
+        const auto numChunks = input.readInt();
+
+        const bool shouldRestore = filter == nullptr
+                                || filter->getAudioSourceToRestoreStateWithID<NoctaveAudioSource> (persistentID.toRawUTF8()) != nullptr;
+
+        for (int chunkIndex = 0; chunkIndex < numChunks && ! input.failed(); ++chunkIndex)
+        {
+            const auto hash = (juce::uint64) input.readInt64();
+            auto chunk = SourceAnalysis::Chunk::readFrom (input);
+
+            if (chunk == nullptr)
+                return false;
+
+            // Seeding the cache is enough: the source's first read finds every chunk there
+            if (shouldRestore)
+                analysisCache.add (hash, std::move (chunk));
+        }
+    }
+
+    return ! input.failed();
+}
+
+bool NoctaveDocumentController::doStoreObjectsToStream (juce::ARAOutputStream& output,
+                                                        const juce::ARAStoreObjectsFilter* filter) noexcept
+{
+    std::vector<std::pair<juce::String, std::shared_ptr<const SourceAnalysis>>> toStore;
+
+    for (auto* source : getDocument()->getAudioSources<NoctaveAudioSource>())
+        if (filter == nullptr || filter->shouldStoreAudioSource (source))
+            if (auto analysis = source->getAnalysis())
+                toStore.emplace_back (juce::String (source->getPersistentID()), std::move (analysis));
+
+    bool success = output.writeInt (archiveVersion)
+                && output.writeInt ((int) toStore.size());
+
+    for (const auto& [persistentID, analysis] : toStore)
+    {
+        success = success && output.writeString (persistentID)
+                          && output.writeInt ((int) analysis->chunks.size());
+
+        for (size_t i = 0; i < analysis->chunks.size() && success; ++i)
+            success = output.writeInt64 ((juce::int64) analysis->chunkHashes[i])
+                   && analysis->chunks[i]->writeTo (output);
+    }
+
+    return success;
+}
+
+//==============================================================================
+const ARA::ARAFactory* JUCE_CALLTYPE createARAFactory()
+{
+    return juce::ARADocumentControllerSpecialisation::createARAFactory<NoctaveDocumentController>();
+}
+
+#endif
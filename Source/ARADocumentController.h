@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    ARADocumentController.h
+    ARA document controller: background analysis and pre-rendering of clips.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JucePlugin_Enable_ARA
+
+#include "SourceAnalysis.h"
+
+//==============================================================================
+/**
+    An audio source plus what the background jobs have made of it: a copy of
+    its samples, their analysis and the shifted render. The three are
+    published together and swapped under a spin lock that the playback
+    renderer only ever tries, so the audio thread never waits or frees memory.
+*/
+class NoctaveAudioSource  : public juce::ARAAudioSource
+{
+public:
+    using juce::ARAAudioSource::ARAAudioSource;
+
+    struct Rendering
+    {
+        std::shared_ptr<const juce::AudioBuffer<float>> audio;
+        std::shared_ptr<const SourceAnalysis> analysis;
+        juce::AudioBuffer<float> shifted;
+        float semitones = 0.0f;
+    };
+
+    /** Audio thread: calls back with the current rendering if there is one and
+        nobody is swapping it right now. Returns false otherwise.
+    */
+    template <typename Callback>
+    bool tryUseRendering (Callback&& callback) const noexcept
+    {
+        const juce::SpinLock::ScopedTryLockType lock (renderingLock);
+
+        if (! lock.isLocked() || rendering == nullptr)
+            return false;
+
+        callback (*rendering);
+        return true;
+    }
+
+    /** Worker threads: replaces the rendering. The old one is destroyed by the caller's thread. */
+    void publish (std::unique_ptr<Rendering> newRendering);
+
+    std::shared_ptr<const juce::AudioBuffer<float>> getAudio() const;
+    std::shared_ptr<const SourceAnalysis> getAnalysis() const;
+    float getRenderedSemitones() const;
+
+private:
+    mutable juce::SpinLock renderingLock;
+    std::unique_ptr<Rendering> rendering;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoctaveAudioSource)
+};
+
+//==============================================================================
+/**
+    Analyses each audio source once on worker threads, caches the analysis
+    by content hash and renders the shifted version of every source ahead of
+    playback, so the playback renderer only has to copy samples.
+
+    A source is read again when the host edits its samples; chunks whose
+    content didn't change come straight from the cache, so only the edited
+    part is analysed again. Changing the pitch shift re-renders from the
+    cached analysis without touching the host's samples. Analysis is stored
+    in the ARA archive, so reopening a session doesn't analyse anything.
+*/
+class NoctaveDocumentController  : public juce::ARADocumentControllerSpecialisation,
+                                   private juce::ARAAudioSource::Listener,
+                                   private juce::Timer
+{
+public:
+    NoctaveDocumentController (const ARA::PlugIn::PlugInEntry* entry,
+                               const ARA::ARADocumentControllerHostInstance* instance);
+    ~NoctaveDocumentController() override;
+
+    /** Called by playback renderers with their processor's pitch shift. Sources are
+        re-rendered once the value has settled.
+    */
+    void setTargetSemitones (float semitones) noexcept    { targetSemitones.store (semitones); }
+
+    AnalysisCache& getAnalysisCache() noexcept             { return analysisCache; }
+
+protected:
+    juce::ARAAudioSource* doCreateAudioSource (juce::ARADocument* document, ARA::ARAAudioSourceHostRef hostRef) override;
+    juce::ARAPlaybackRenderer* doCreatePlaybackRenderer() noexcept override;
+
+    bool doRestoreObjectsFromStream (juce::ARAInputStream& input, const juce::ARARestoreObjectsFilter* filter) noexcept override;
+    bool doStoreObjectsToStream (juce::ARAOutputStream& output, const juce::ARAStoreObjectsFilter* filter) noexcept override;
+
+private:
+    class SourceJob;
+
+    // ARAAudioSource::Listener
+    void doUpdateAudioSourceContent (juce::ARAAudioSource* audioSource, juce::ARAContentUpdateScopes scopeFlags) override;
+    void willEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable) override;
+    void didEnableAudioSourceSamplesAccess (juce::ARAAudioSource* audioSource, bool enable) override;
+    void willDestroyAudioSource (juce::ARAAudioSource* audioSource) override;
+
+    void timerCallback() override;
+
+    /** Starts a job for the source, replacing any still running. With readSamples
+        false it only re-renders from the audio and analysis already held.
+    */
+    void startJob (NoctaveAudioSource& source, bool readSamples);
+    void cancelJob (juce::ARAAudioSource* source);
+
+    juce::ThreadPool pool;
+    AnalysisCache analysisCache;
+    std::map<juce::ARAAudioSource*, std::unique_ptr<SourceJob>> jobs;
+
+    std::atomic<float> targetSemitones { 0.0f };
+    float lastSeenSemitones = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoctaveDocumentController)
+};
+
+#endif
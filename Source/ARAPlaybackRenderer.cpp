@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    ARAPlaybackRenderer.cpp
+    Plays back ARA playback regions from their pre-rendered shifted sources.
+
+  ==============================================================================
+*/
+
+#include "ARAPlaybackRenderer.h"
+
+#if JucePlugin_Enable_ARA
+
+#include "ARADocumentController.h"
+
+//==============================================================================
+void NoctavePlaybackRenderer::prepareToPlay (double newSampleRate, int maximumSamplesPerBlock, int newNumChannels,
+                                             juce::AudioProcessor::ProcessingPrecision precision,
+                                             AlwaysNonRealtime alwaysNonRealtime)
+{
+    juce::ignoreUnused (precision, alwaysNonRealtime);
+
+    sampleRate = newSampleRate;
+    numChannels = newNumChannels;
+    regionBuffer.setSize (numChannels, maximumSamplesPerBlock);
+    kernels = &DspKernels::getActive();
+}
+
+void NoctavePlaybackRenderer::releaseResources()
+{
+    regionBuffer.setSize (0, 0);
+}
+
+void NoctavePlaybackRenderer::setParameters (float semitones, float mix) noexcept
+{
+    mixAmount.store (mix);
+
+    if (auto* controller = juce::ARADocumentControllerSpecialisation::getSpecialisedDocumentController<NoctaveDocumentController> (getDocumentController()))
+        controller->setTargetSemitones (semitones);
+}
+
+bool NoctavePlaybackRenderer::processBlock (juce::AudioBuffer<float>& buffer,
+                                            juce::AudioProcessor::Realtime realtime,
+                                            const juce::AudioPlayHead::PositionInfo& positionInfo) noexcept
+{
+    juce::ignoreUnused (realtime);
+
+    const int numSamples = buffer.getNumSamples();
+    buffer.clear();
+
+    if (! positionInfo.getIsPlaying() || numSamples > regionBuffer.getNumSamples())
+        return true;
+
+    // Same unity-gain crossfade as the live shifter, so switching a track to ARA keeps its balance.
+    // The processor's output limiter runs on the result.
+    const float mix = mixAmount.load();
+    const float wetGain = mix;
+    const float dryGain = 1.0f - mix;
+
+    const auto blockRange = juce::Range<juce::int64>::withStartAndLength (positionInfo.getTimeInSamples().orFallback (0), numSamples);
+    bool success = true;
+
+    for (const auto& playbackRegion : getPlaybackRegions())
+    {
+        // Region borders in song time, then clipped to the part the modification covers
+        const auto playbackSampleRange = playbackRegion->getSampleRange (sampleRate, juce::ARAPlaybackRegion::IncludeHeadAndTail::no);
+        auto renderRange = blockRange.getIntersectionWith (playbackSampleRange);
+
+        const juce::Range<juce::int64> modificationSampleRange { playbackRegion->getStartInAudioModificationSamples(),
+                                                                 playbackRegion->getEndInAudioModificationSamples() };
+        const auto modificationSampleOffset = modificationSampleRange.getStart() - playbackSampleRange.getStart();
+        renderRange = renderRange.getIntersectionWith (modificationSampleRange.movedToStartAt (playbackSampleRange.getStart()));
+
+        if (renderRange.isEmpty())
+            continue;
+
+        auto* source = static_cast<NoctaveAudioSource*> (playbackRegion->getAudioModification()->getAudioSource());
+
+        // Sources are rendered at their own rate; converting is left to the host
+        if (source->getSampleRate() != sampleRate)
+        {
+            success = false;
+            continue;
+        }
+
+        const int startInBuffer = (int) (renderRange.getStart() - blockRange.getStart());
+        const auto startInSource = renderRange.getStart() + modificationSampleOffset;
+
+        const bool rendered = source->tryUseRendering ([&] (const NoctaveAudioSource::Rendering& rendering)
+        {
+            const auto& dry = *rendering.audio;
+            const auto& wet = rendering.shifted;
+            const int num = (int) juce::jmin (renderRange.getLength(), (juce::int64) dry.getNumSamples() - startInSource);
+
+            if (startInSource < 0 || num <= 0 || dry.getNumChannels() == 0)
+                return;
+
+            for (int channel = 0; channel < numChannels && channel < buffer.getNumChannels(); ++channel)
+            {
+                const int sourceChannel = channel % dry.getNumChannels();
+                const auto* drySamples = dry.getReadPointer (sourceChannel, (int) startInSource);
+
+                // Still being analysed: play the source as it is
+                if (wet.getNumSamples() != dry.getNumSamples())
+                {
+                    buffer.addFrom (channel, startInBuffer, drySamples, num);
+                    continue;
+                }
+
+                auto* regionSamples = regionBuffer.getWritePointer (channel);
+                kernels->mix (regionSamples, drySamples, wet.getReadPointer (sourceChannel, (int) startInSource),
+                              dryGain, wetGain, num);
+                buffer.addFrom (channel, startInBuffer, regionSamples, num);
+            }
+        });
+
+        success = success && rendered;
+    }
+
+    return success;
+}
+
+#endif
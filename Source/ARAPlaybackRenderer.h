@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    ARAPlaybackRenderer.h
+    Plays back ARA playback regions from their pre-rendered shifted sources.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JucePlugin_Enable_ARA
+
+#include "DspKernels.h"
+
+//==============================================================================
+/**
+    Renders the playback regions assigned to one plugin instance by copying
+    from the shifted sources the document controller prepared in the
+    background, blended with the original by the Mix parameter. Nothing is
+    estimated or shifted here, so there is no latency and no lookahead to pay
+    for on the audio thread.
+
+    Until a source's render is ready its region plays dry; if it's mid-swap
+    the block is skipped rather than waiting.
+*/
+class NoctavePlaybackRenderer  : public juce::ARAPlaybackRenderer
+{
+public:
+    using juce::ARAPlaybackRenderer::ARAPlaybackRenderer;
+
+    void prepareToPlay (double sampleRate, int maximumSamplesPerBlock, int numChannels,
+                        juce::AudioProcessor::ProcessingPrecision precision,
+                        AlwaysNonRealtime alwaysNonRealtime) override;
+    void releaseResources() override;
+
+    bool processBlock (juce::AudioBuffer<float>& buffer,
+                       juce::AudioProcessor::Realtime realtime,
+                       const juce::AudioPlayHead::PositionInfo& positionInfo) noexcept override;
+
+    /** Called by the processor each block with its current settings. */
+    void setParameters (float semitones, float mix) noexcept;
+
+private:
+    double sampleRate = 44100.0;
+    int numChannels = 2;
+    juce::AudioBuffer<float> regionBuffer;
+    const DspKernels::Table* kernels = &DspKernels::getActive();
+
+    std::atomic<float> mixAmount { 1.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoctavePlaybackRenderer)
+};
+
+#endif
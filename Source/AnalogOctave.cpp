@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    AnalogOctave.cpp
+    Zero-latency octave divider and rectifier, after classic analog pedals.
+
+  ==============================================================================
+*/
+
+#include "AnalogOctave.h"
+#include "ModulationEngine.h"
+#include "RealtimeChecks.h"
+
+namespace
+{
+    // Keeps mostly the fundamental, so the comparator sees one crossing per cycle
+    constexpr double detectorCutoffHz = 350.0;
+    constexpr double toneCutoffHz = 1800.0;
+    constexpr double dcBlockerCutoffHz = 20.0;
+
+    constexpr double envelopeAttackSeconds = 0.001;
+    constexpr double envelopeReleaseSeconds = 0.05;
+    constexpr double gateSeconds = 0.01;
+
+    // Comparator hysteresis, as a fraction of the detector envelope
+    constexpr float hysteresis = 0.2f;
+
+    // About -54 dBFS at the detector
+    constexpr float gateThreshold = 0.002f;
+
+    // A rectified sine's second harmonic is about 0.42 of the original's level
+    constexpr float rectifierGain = 2.0f;
+
+    float coefficientForTime (double sampleRate, double seconds)
+    {
+        return (float) (1.0 - std::exp (-1.0 / (seconds * sampleRate)));
+    }
+}
+
+//==============================================================================
+void AnalogOctave::OnePole::setCutoff (double sampleRate, double frequency) noexcept
+{
+    coefficient = (float) (1.0 - std::exp (-juce::MathConstants<double>::twoPi * frequency / sampleRate));
+}
+
+void AnalogOctave::prepare (double sampleRate)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    for (auto& filter : detectorFilter)
+        filter.setCutoff (sampleRate, detectorCutoffHz);
+
+    toneFilter.setCutoff (sampleRate, toneCutoffHz);
+
+    for (auto& blocker : dcBlockers)
+        blocker.pole = (float) std::exp (-juce::MathConstants<double>::twoPi * dcBlockerCutoffHz / sampleRate);
+
+    attackCoefficient = coefficientForTime (sampleRate, envelopeAttackSeconds);
+    releaseCoefficient = coefficientForTime (sampleRate, envelopeReleaseSeconds);
+    gateCoefficient = coefficientForTime (sampleRate, gateSeconds);
+
+    defaultMixGlide = (int) std::floor (sampleRate * 0.02);
+    mixGlide = 0;
+    mixAmount.reset (defaultMixGlide);
+    reset();
+}
+
+void AnalogOctave::setMixGlide (int numSamples) noexcept
+{
+    if (numSamples == mixGlide)
+        return;
+
+    mixGlide = numSamples;
+    ModulationEngine::setRampLength (mixAmount, numSamples > 0 ? numSamples : defaultMixGlide);
+}
+
+void AnalogOctave::reset()
+{
+    for (auto& filter : detectorFilter)
+        filter.state = 0.0f;
+
+    toneFilter.state = 0.0f;
+
+    for (auto& blocker : dcBlockers)
+        blocker.previousInput = blocker.previousOutput = 0.0f;
+
+    envelope = gate = 0.0f;
+    comparatorHigh = firstDivider = secondDivider = false;
+    snapToTargets = true;
+}
+
+//==============================================================================
+float AnalogOctave::divide (float input, int octaves) noexcept
+{
+    const float filtered = detectorFilter[1].processLowPass (detectorFilter[0].processLowPass (input));
+
+    const float level = std::abs (filtered);
+    envelope += (level > envelope ? attackCoefficient : releaseCoefficient) * (level - envelope);
+
+    // Schmitt trigger: a rising crossing clocks the dividers
+    const float threshold = envelope * hysteresis;
+
+    if (! comparatorHigh && filtered > threshold)
+    {
+        comparatorHigh = true;
+        firstDivider = ! firstDivider;
+
+        if (firstDivider)
+            secondDivider = ! secondDivider;
+    }
+    else if (comparatorHigh && filtered < -threshold)
+    {
+        comparatorHigh = false;
+    }
+
+    gate += gateCoefficient * ((envelope > gateThreshold ? 1.0f : 0.0f) - gate);
+
+    const bool divider = octaves <= -2 ? secondDivider : firstDivider;
+    return (divider ? filtered : -filtered) * gate;
+}
+
+float AnalogOctave::multiply (float input, int octaves) noexcept
+{
+    float output = dcBlockers[0].process (std::abs (input)) * rectifierGain;
+
+    if (octaves >= 2)
+        output = dcBlockers[1].process (std::abs (output)) * rectifierGain;
+
+    return output;
+}
+
+void AnalogOctave::process (float* samples, int numSamples, int octaves, float mix) noexcept
+{
+    if (snapToTargets)
+    {
+        mixAmount.setCurrentAndTargetValue (mix);
+        snapToTargets = false;
+    }
+    else
+    {
+        mixAmount.setTargetValue (mix);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Same unity-gain crossfade as the delay-line shifter, so switching engines keeps the level
+        const float dry = samples[i];
+
+        float wet = dry;
+
+        if (octaves < 0)
+            wet = toneFilter.processLowPass (divide (dry, octaves));
+        else if (octaves > 0)
+            wet = toneFilter.processLowPass (multiply (dry, octaves));
+
+        const float currentMix = mixAmount.getNextValue();
+        samples[i] = dry * (1.0f - currentMix) + wet * currentMix;
+    }
+}
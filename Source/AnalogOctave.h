@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    AnalogOctave.h
+    Zero-latency octave divider and rectifier, after classic analog pedals.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Octave effect with no delay line, for live playing where any latency or
+    read-head drift is too much. Each output sample depends only on the input
+    up to that sample.
+
+    Octaves down come from a flip-flop divider: the input is low-passed, a
+    comparator with hysteresis that follows the signal's envelope finds each
+    cycle, and every rising crossing toggles a flip-flop (a second one divides
+    again for two octaves). The flip-flops switch the polarity of the filtered
+    input, the way an OC-2 does, so the sub keeps the note's dynamics. An
+    envelope gate mutes the divider below the noise floor, where it would
+    otherwise chatter.
+
+    Octaves up come from full-wave rectification with the DC removed, applied
+    twice for two octaves. Both are smoothed by a tone filter before the mix.
+*/
+class AnalogOctave
+{
+public:
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Samples the mix takes to glide to a new setting. Zero keeps the default glide. */
+    void setMixGlide (int numSamples) noexcept;
+
+    /** Processes samples in place. octaves is -2 to 2; 0 passes the input through as the wet signal. */
+    void process (float* samples, int numSamples, int octaves, float mix) noexcept;
+
+private:
+    struct OnePole
+    {
+        float coefficient = 0.0f;
+        float state = 0.0f;
+
+        void setCutoff (double sampleRate, double frequency) noexcept;
+        float processLowPass (float input) noexcept    { return state += coefficient * (input - state); }
+    };
+
+    struct DCBlocker
+    {
+        float pole = 0.995f;
+        float previousInput = 0.0f, previousOutput = 0.0f;
+
+        float process (float input) noexcept
+        {
+            previousOutput = input - previousInput + pole * previousOutput;
+            previousInput = input;
+            return previousOutput;
+        }
+    };
+
+    float divide (float input, int octaves) noexcept;
+    float multiply (float input, int octaves) noexcept;
+
+    OnePole detectorFilter[2], toneFilter;
+    DCBlocker dcBlockers[2];
+
+    float envelope = 0.0f, gate = 0.0f;
+    float attackCoefficient = 0.0f, releaseCoefficient = 0.0f, gateCoefficient = 0.0f;
+    bool comparatorHigh = false, firstDivider = false, secondDivider = false;
+
+    juce::SmoothedValue<float> mixAmount;
+    int defaultMixGlide = 0, mixGlide = 0;
+    bool snapToTargets = true;
+};
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    ChunkRenderer.cpp
+    Renders one long file in chunks on separate cores.
+
+  ==============================================================================
+*/
+
+#include "ChunkRenderer.h"
+
+//==============================================================================
+double ChunkRenderer::Report::getSpeed (double audioSeconds) const noexcept
+{
+    return secondsTaken > 0.0 ? audioSeconds / secondsTaken : 0.0;
+}
+
+juce::String ChunkRenderer::Report::toString (double audioSeconds) const
+{
+    juce::String text;
+    text << "Rendered " << juce::String (audioSeconds, 1) << " s of audio in " << numChunks << " chunks at "
+         << juce::String (getSpeed (audioSeconds), 1) << "x realtime.";
+
+    if (serialSecondsTaken > 0.0)
+    {
+        text << "\nA single pass ran at " << juce::String (audioSeconds / serialSecondsTaken, 1) << "x realtime ("
+             << juce::String (serialSecondsTaken / juce::jmax (secondsTaken, 1.0e-9), 2) << "x speedup).";
+
+        if (numDifferentSamples == 0)
+            text << "\nThe chunks match the single pass exactly.";
+        else
+            text << "\n" << numDifferentSamples << " samples differ from the single pass, by up to "
+                 << juce::String (juce::Decibels::gainToDecibels ((float) maxDeviation), 1) << " dBFS.";
+    }
+
+    return text;
+}
+
+//==============================================================================
+ChunkRenderer::ChunkRenderer (const juce::MemoryBlock& state, double sampleRate, int numChannels)
+{
+    // The calling thread renders chunks too
+    const int numInstances = workerPool->getNumThreads() + 1;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        auto* instance = instances.add (new NoctaveAudioProcessor());
+        instance->setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+        instance->setNonRealtime (true);
+        instance->setStateInformation (state.getData(), (int) state.getSize());
+        instance->prepareToPlay (sampleRate, blockSize);
+    }
+}
+
+ChunkRenderer::~ChunkRenderer()
+{
+    for (auto* instance : instances)
+        instance->releaseResources();
+}
+
+ChunkRenderer::Report ChunkRenderer::render (juce::AudioBuffer<float>& audio, bool compareWithSerial,
+                                             std::function<bool (double)> progress)
+{
+    Report report;
+    const juce::int64 length = audio.getNumSamples();
+
+    if (length == 0 || instances.isEmpty())
+        return report;
+
+    // Pre-rolls read the original audio, which earlier chunks have already overwritten
+    juce::AudioBuffer<float> input;
+    input.makeCopyOf (audio);
+
+    std::atomic<bool> cancelled { false };
+    juce::AudioBuffer<float> serial;
+
+    if (compareWithSerial)
+    {
+        serial.setSize (audio.getNumChannels(), audio.getNumSamples());
+
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+        renderRange (*instances.getFirst(), input, serial, 0, length, cancelled);
+        report.serialSecondsTaken = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    }
+
+    // Long enough that the pre-roll is a small part of each chunk, short enough to balance across cores
+    const juce::int64 warmUp = instances.getFirst()->getRestartWarmUpSamples();
+    const auto chunkLength = juce::jmax (warmUp * 4, length / (instances.size() * 2) + 1);
+    report.numChunks = (int) ((length + chunkLength - 1) / chunkLength);
+
+    std::atomic<int> nextChunk { 0 };
+    std::atomic<int> chunksDone { 0 };
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    // One task per instance, each taking chunks until there are none left
+    workerPool->run (instances.size(), [&] (int index)
+    {
+        for (int chunk = nextChunk++; chunk < report.numChunks && ! cancelled; chunk = nextChunk++)
+        {
+            const auto start = chunk * chunkLength;
+            renderRange (*instances[index], input, audio, start, juce::jmin (length, start + chunkLength), cancelled);
+
+            if (progress && ! progress ((double) ++chunksDone / report.numChunks))
+                cancelled = true;
+        }
+    });
+
+    report.secondsTaken = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+    if (compareWithSerial && ! cancelled)
+    {
+        for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+        {
+            const auto* chunked = audio.getReadPointer (channel);
+            const auto* single = serial.getReadPointer (channel);
+
+            for (int i = 0; i < audio.getNumSamples(); ++i)
+            {
+                const auto deviation = std::abs ((double) chunked[i] - (double) single[i]);
+
+                if (deviation > 0.0)
+                {
+                    ++report.numDifferentSamples;
+                    report.maxDeviation = juce::jmax (report.maxDeviation, deviation);
+                }
+            }
+        }
+    }
+
+    return report;
+}
+
+void ChunkRenderer::renderRange (NoctaveAudioProcessor& instance, const juce::AudioBuffer<float>& input,
+                                 juce::AudioBuffer<float>& output, juce::int64 start, juce::int64 end,
+                                 const std::atomic<bool>& cancelled)
+{
+    const auto preRollStart = juce::jmax ((juce::int64) 0, start - instance.getRestartWarmUpSamples());
+    instance.restartAt (preRollStart);
+
+    // The limiter delays the output, so run on past the end, feeding silence after the
+    // input runs out, and line what comes out back up with the input
+    const juce::int64 latency = instance.getLatencySamples();
+    const juce::int64 inputLength = input.getNumSamples();
+
+    const int numChannels = input.getNumChannels();
+    juce::AudioBuffer<float> block (numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    for (auto position = preRollStart; position < end + latency && ! cancelled; position += blockSize)
+    {
+        const int numSamples = (int) juce::jmin ((juce::int64) blockSize, end + latency - position);
+        const int numInput = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, inputLength - position);
+        block.setSize (numChannels, numSamples, false, false, true);
+
+        if (numInput < numSamples)
+            block.clear();
+
+        if (numInput > 0)
+            for (int channel = 0; channel < numChannels; ++channel)
+                block.copyFrom (channel, 0, input, channel, (int) position, numInput);
+
+        instance.processBlock (block, midi);
+
+        // Only what's past the pre-roll is kept
+        const auto keepFrom = juce::jmax (position, start + latency);
+        const auto numToKeep = (int) (position + numSamples - keepFrom);
+
+        if (numToKeep > 0)
+            for (int channel = 0; channel < numChannels; ++channel)
+                output.copyFrom (channel, (int) (keepFrom - latency), block, channel, (int) (keepFrom - position), numToKeep);
+    }
+}
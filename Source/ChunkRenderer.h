@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    ChunkRenderer.h
+    Renders one long file in chunks on separate cores.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "WorkerPool.h"
+
+//==============================================================================
+/**
+    Splits a file into chunks and renders them in parallel, each on its own
+    processor instance set up from the same saved state. Every chunk restarts
+    its instance at the chunk's position and pre-rolls the audio before it,
+    so the delay lines hold what a single pass would have left in them, and
+    the chunks join into exactly the serial result.
+
+    The instances render offline, just as a host bounce would, so the output
+    never depends on timers or on how busy the realtime workers are. Their own
+    voices run inline, since the chunks already keep every worker busy.
+*/
+class ChunkRenderer
+{
+public:
+    struct Report
+    {
+        int numChunks = 0;
+        double secondsTaken = 0.0;
+        double serialSecondsTaken = 0.0;    // 0 unless compared with a serial render
+        double maxDeviation = 0.0;          // Largest difference from the serial render
+        juce::int64 numDifferentSamples = 0;
+
+        /** Seconds of audio rendered per second. */
+        double getSpeed (double audioSeconds) const noexcept;
+        juce::String toString (double audioSeconds) const;
+    };
+
+    /** Creates one instance per worker from a state saved by getStateInformation().
+        Create and delete it on the message thread, which owns the instances' timers.
+    */
+    ChunkRenderer (const juce::MemoryBlock& state, double sampleRate, int numChannels);
+    ~ChunkRenderer();
+
+    /** Renders audio in place. With compareWithSerial it's also rendered in one pass on one
+        instance, to time that and check the chunks against it. progress gets the fraction
+        done from whichever thread finished a chunk, and can return false to cancel.
+    */
+    Report render (juce::AudioBuffer<float>& audio, bool compareWithSerial,
+                   std::function<bool (double)> progress = {});
+
+private:
+    static constexpr int blockSize = 4096;
+
+    void renderRange (NoctaveAudioProcessor& instance, const juce::AudioBuffer<float>& input,
+                      juce::AudioBuffer<float>& output, juce::int64 start, juce::int64 end,
+                      const std::atomic<bool>& cancelled);
+
+    juce::SharedResourcePointer<WorkerPool> workerPool;
+    juce::OwnedArray<NoctaveAudioProcessor> instances;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChunkRenderer)
+};
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    ClipShifter.cpp
+    Offline pitch-synchronous shifting of whole clips from their analysis.
+
+  ==============================================================================
+*/
+
+#include "ClipShifter.h"
+
+namespace
+{
+    // Grain spacing where the analysis found no pitch
+    constexpr double unvoicedPeriodSeconds = 0.01;
+}
+
+//==============================================================================
+std::vector<ClipShifter::Mark> ClipShifter::findMarks (const juce::AudioBuffer<float>& input, const SourceAnalysis& analysis)
+{
+    const int numSamples = input.getNumSamples();
+    const int unvoicedPeriod = juce::jmax (16, juce::roundToInt (analysis.sampleRate * unvoicedPeriodSeconds));
+
+    std::vector<juce::int64> onsets;
+    analysis.getOnsets (0, numSamples, onsets);
+
+    auto sumAt = [&input] (int sample)
+    {
+        float sum = 0.0f;
+
+        for (int channel = 0; channel < input.getNumChannels(); ++channel)
+            sum += input.getSample (channel, sample);
+
+        return sum;
+    };
+
+    std::vector<Mark> marks;
+    marks.reserve ((size_t) (numSamples / unvoicedPeriod) * 4 + 1);
+
+    size_t nextOnset = 0;
+    int position = 0;
+    bool isOnset = false;
+
+    while (position < numSamples)
+    {
+        const float pitch = analysis.getPitchAt (position);
+        const bool isVoiced = pitch > 0.0f;
+        const int period = isVoiced ? juce::jmax (16, juce::roundToInt (analysis.sampleRate / pitch)) : unvoicedPeriod;
+
+        marks.push_back ({ position, period, isVoiced, isOnset });
+
+        while (nextOnset < onsets.size() && onsets[nextOnset] <= position)
+            ++nextOnset;
+
+        int next = position + period;
+
+        // Keep voiced marks on the same point of each cycle by following the waveform's peak
+        if (isVoiced)
+        {
+            const int searchStart = juce::jmax (position + 1, next - period / 4);
+            const int searchEnd = juce::jmin (numSamples, next + period / 4 + 1);
+
+            if (searchStart < searchEnd)
+            {
+                next = searchStart;
+                float peak = sumAt (next);
+
+                for (int i = searchStart + 1; i < searchEnd; ++i)
+                {
+                    const float value = sumAt (i);
+
+                    if (value > peak)
+                    {
+                        peak = value;
+                        next = i;
+                    }
+                }
+            }
+        }
+
+        // An onset within reach becomes the next mark, so a grain starts exactly on it
+        isOnset = nextOnset < onsets.size() && onsets[nextOnset] <= next + period / 4;
+
+        if (isOnset)
+            next = (int) onsets[nextOnset++];
+
+        position = next;
+    }
+
+    return marks;
+}
+
+bool ClipShifter::render (const juce::AudioBuffer<float>& input,
+                          juce::AudioBuffer<float>& output,
+                          const SourceAnalysis& analysis,
+                          float pitchRatio,
+                          const std::function<bool()>& shouldExit)
+{
+    const int numChannels = input.getNumChannels();
+    const int numSamples = input.getNumSamples();
+
+    if (std::abs (pitchRatio - 1.0f) < 1.0e-4f)
+    {
+        output.makeCopyOf (input);
+        return true;
+    }
+
+    output.setSize (numChannels, numSamples, false, false, true);
+    output.clear();
+
+    const auto marks = findMarks (input, analysis);
+
+    if (marks.empty())
+        return true;
+
+    std::vector<float> weight ((size_t) numSamples, 0.0f);
+    std::vector<float> window;
+
+    size_t nextOnsetMark = 1;
+
+    while (nextOnsetMark < marks.size() && ! marks[nextOnsetMark].isOnset)
+        ++nextOnsetMark;
+
+    double time = marks.front().position;
+    size_t markIndex = 0;
+    int grainCount = 0;
+
+    while (time < numSamples)
+    {
+        if ((++grainCount & 255) == 0 && shouldExit())
+            return false;
+
+        if (nextOnsetMark < marks.size() && marks[nextOnsetMark].position <= time)
+        {
+            // Reached an onset: pin a grain to it, at its original time
+            markIndex = nextOnsetMark;
+            time = marks[markIndex].position;
+
+            do { ++nextOnsetMark; }
+            while (nextOnsetMark < marks.size() && ! marks[nextOnsetMark].isOnset);
+        }
+        else
+        {
+            while (markIndex + 1 < marks.size()
+                    && std::abs (marks[markIndex + 1].position - time) <= std::abs (marks[markIndex].position - time))
+                ++markIndex;
+
+            // An onset's grain is only ever used when pinned: before that it would
+            // pre-echo the attack, and after it, double it
+            if (marks[markIndex].isOnset)
+            {
+                if (markIndex >= nextOnsetMark)
+                    markIndex = markIndex > 0 ? markIndex - 1 : markIndex;
+                else if (markIndex + 1 < marks.size())
+                    ++markIndex;
+            }
+        }
+
+        const auto& mark = marks[markIndex];
+        const double step = mark.isVoiced ? (double) mark.period / pitchRatio : (double) mark.period;
+        const int at = (int) time;
+        const int half = mark.period;
+        const int first = juce::jmax (-half, juce::jmax (-mark.position, -at));
+        const int last = juce::jmin (half, juce::jmin (numSamples - mark.position, numSamples - at));
+
+        if (last > first)
+        {
+            window.resize ((size_t) (last - first));
+
+            for (int j = first; j < last; ++j)
+                window[(size_t) (j - first)] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::pi * (float) (j + half) / (float) half);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::addWithMultiply (output.getWritePointer (channel, at + first),
+                                                              input.getReadPointer (channel, mark.position + first),
+                                                              window.data(), last - first);
+
+            // Evenly spaced grains overlap to about one once scaled by their spacing
+            juce::FloatVectorOperations::addWithMultiply (weight.data() + at + first, window.data(),
+                                                          (float) (step / half), last - first);
+        }
+
+        time += step;
+    }
+
+    // Where grains bunch up (around pinned onsets) bring the level back down, but
+    // leave the gaps between sparse grains on downward shifts alone
+    for (auto& w : weight)
+        w = 1.0f / juce::jmax (1.0f, w);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::multiply (output.getWritePointer (channel), weight.data(), numSamples);
+
+    return true;
+}
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    ClipShifter.h
+    Offline pitch-synchronous shifting of whole clips from their analysis.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SourceAnalysis.h"
+
+//==============================================================================
+/**
+    Renders a pitch-shifted copy of a whole source, using its SourceAnalysis
+    instead of estimating anything in real time.
+
+    This is pitch-synchronous overlap-add: analysis marks sit one detected
+    period apart on the waveform's peaks, and two-period Hann grains taken
+    from them are laid down one shifted period apart, so the duration is kept
+    and the pitch moves. Unvoiced stretches pass through at their own spacing,
+    and a grain is pinned to every onset and never repeated, so attacks keep
+    their timing and aren't doubled. Because the whole source is available,
+    every grain can look ahead as far as it needs.
+*/
+class ClipShifter
+{
+public:
+    /** Writes the shifted source into output, which is resized to match. Returns
+        false if shouldExit() asked it to stop part way.
+    */
+    static bool render (const juce::AudioBuffer<float>& input,
+                        juce::AudioBuffer<float>& output,
+                        const SourceAnalysis& analysis,
+                        float pitchRatio,
+                        const std::function<bool()>& shouldExit);
+
+private:
+    struct Mark
+    {
+        int position;
+        int period;
+        bool isVoiced;
+        bool isOnset;
+    };
+
+    static std::vector<Mark> findMarks (const juce::AudioBuffer<float>& input, const SourceAnalysis& analysis);
+};
@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    DspKernels.cpp
+    Hot inner loops built for several instruction sets and picked at runtime.
+
+  ==============================================================================
+*/
+
+#include "DspKernels.h"
+#include "Interpolation.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+ #define NOCTAVE_HAS_X86_KERNELS 1
+#else
+ #define NOCTAVE_HAS_X86_KERNELS 0
+#endif
+
+#if JUCE_ARM && (defined (__aarch64__) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define NOCTAVE_HAS_NEON_KERNELS 1
+#else
+ #define NOCTAVE_HAS_NEON_KERNELS 0
+#endif
+
+// The x86 variants are compiled for their own target inside an otherwise
+// baseline translation unit. MSVC exposes every intrinsic without flags.
+#if defined (__clang__)
+ #define NOCTAVE_BEGIN_TARGET_SSE2   _Pragma ("clang attribute push (__attribute__ ((target (\"sse2\"))), apply_to = function)")
+ #define NOCTAVE_BEGIN_TARGET_AVX2   _Pragma ("clang attribute push (__attribute__ ((target (\"avx2\"))), apply_to = function)")
+ #define NOCTAVE_BEGIN_TARGET_AVX512 _Pragma ("clang attribute push (__attribute__ ((target (\"avx512f\"))), apply_to = function)")
+ #define NOCTAVE_END_TARGET          _Pragma ("clang attribute pop")
+#elif defined (__GNUC__)
+ #define NOCTAVE_BEGIN_TARGET_SSE2   _Pragma ("GCC push_options") _Pragma ("GCC target (\"sse2\")")
+ #define NOCTAVE_BEGIN_TARGET_AVX2   _Pragma ("GCC push_options") _Pragma ("GCC target (\"avx2\")")
+ #define NOCTAVE_BEGIN_TARGET_AVX512 _Pragma ("GCC push_options") _Pragma ("GCC target (\"avx512f\")")
+ #define NOCTAVE_END_TARGET          _Pragma ("GCC pop_options")
+#else
+ #define NOCTAVE_BEGIN_TARGET_SSE2
+ #define NOCTAVE_BEGIN_TARGET_AVX2
+ #define NOCTAVE_BEGIN_TARGET_AVX512
+ #define NOCTAVE_END_TARGET
+#endif
+
+namespace DspKernels
+{
+namespace detail
+{
+    // One lane, plain C++: this is the reference every other variant must match,
+    // and the tail loop for block lengths that aren't a multiple of the width.
+    struct ScalarVec
+    {
+        static constexpr int width = 1;
+        using Reg = float;
+        using Mask = bool;
+
+        static Reg load (const float* p) noexcept                         { return *p; }
+        static void store (float* p, Reg v) noexcept                      { *p = v; }
+        static Reg set1 (float v) noexcept                                { return v; }
+        static Reg zero() noexcept                                        { return 0.0f; }
+        static Reg add (Reg a, Reg b) noexcept                            { return a + b; }
+        static Reg sub (Reg a, Reg b) noexcept                            { return a - b; }
+        static Reg mul (Reg a, Reg b) noexcept                            { return a * b; }
+        static Reg div (Reg a, Reg b) noexcept                            { return a / b; }
+        static Reg min (Reg a, Reg b) noexcept                            { return a < b ? a : b; }
+        static Reg max (Reg a, Reg b) noexcept                            { return a > b ? a : b; }
+        static Reg abs (Reg v) noexcept                                   { return std::abs (v); }
+        static Reg copySign (Reg magnitude, Reg sign) noexcept            { return std::copysign (magnitude, sign); }
+        static Mask greaterThan (Reg a, Reg b) noexcept                   { return a > b; }
+        static Reg select (Mask m, Reg a, Reg b) noexcept                 { return m ? a : b; }
+        static Reg gather (const float* base, const int* index) noexcept  { return base[index[0]]; }
+    };
+}
+
+//==============================================================================
+namespace scalar
+{
+    static constexpr auto instructionSet = InstructionSet::scalar;
+    using Vec = detail::ScalarVec;
+
+    #include "DspKernelsImpl.h"
+}
+
+//==============================================================================
+#if NOCTAVE_HAS_X86_KERNELS
+NOCTAVE_BEGIN_TARGET_SSE2
+namespace sse2
+{
+    static constexpr auto instructionSet = InstructionSet::sse2;
+
+    struct Vec
+    {
+        static constexpr int width = 4;
+        using Reg = __m128;
+        using Mask = __m128;
+
+        static Reg load (const float* p) noexcept                 { return _mm_loadu_ps (p); }
+        static void store (float* p, Reg v) noexcept              { _mm_storeu_ps (p, v); }
+        static Reg set1 (float v) noexcept                        { return _mm_set1_ps (v); }
+        static Reg zero() noexcept                                { return _mm_setzero_ps(); }
+        static Reg add (Reg a, Reg b) noexcept                    { return _mm_add_ps (a, b); }
+        static Reg sub (Reg a, Reg b) noexcept                    { return _mm_sub_ps (a, b); }
+        static Reg mul (Reg a, Reg b) noexcept                    { return _mm_mul_ps (a, b); }
+        static Reg div (Reg a, Reg b) noexcept                    { return _mm_div_ps (a, b); }
+        static Reg min (Reg a, Reg b) noexcept                    { return _mm_min_ps (a, b); }
+        static Reg max (Reg a, Reg b) noexcept                    { return _mm_max_ps (a, b); }
+        static Reg abs (Reg v) noexcept                           { return _mm_andnot_ps (_mm_set1_ps (-0.0f), v); }
+        static Mask greaterThan (Reg a, Reg b) noexcept           { return _mm_cmpgt_ps (a, b); }
+        static Reg select (Mask m, Reg a, Reg b) noexcept         { return _mm_or_ps (_mm_and_ps (m, a), _mm_andnot_ps (m, b)); }
+
+        static Reg copySign (Reg magnitude, Reg sign) noexcept
+        {
+            const auto signBit = _mm_set1_ps (-0.0f);
+            return _mm_or_ps (_mm_andnot_ps (signBit, magnitude), _mm_and_ps (signBit, sign));
+        }
+
+        static Reg gather (const float* base, const int* index) noexcept
+        {
+            return _mm_setr_ps (base[index[0]], base[index[1]], base[index[2]], base[index[3]]);
+        }
+    };
+
+    #include "DspKernelsImpl.h"
+}
+NOCTAVE_END_TARGET
+
+//==============================================================================
+NOCTAVE_BEGIN_TARGET_AVX2
+namespace avx2
+{
+    static constexpr auto instructionSet = InstructionSet::avx2;
+
+    struct Vec
+    {
+        static constexpr int width = 8;
+        using Reg = __m256;
+        using Mask = __m256;
+
+        static Reg load (const float* p) noexcept                 { return _mm256_loadu_ps (p); }
+        static void store (float* p, Reg v) noexcept              { _mm256_storeu_ps (p, v); }
+        static Reg set1 (float v) noexcept                        { return _mm256_set1_ps (v); }
+        static Reg zero() noexcept                                { return _mm256_setzero_ps(); }
+        static Reg add (Reg a, Reg b) noexcept                    { return _mm256_add_ps (a, b); }
+        static Reg sub (Reg a, Reg b) noexcept                    { return _mm256_sub_ps (a, b); }
+        static Reg mul (Reg a, Reg b) noexcept                    { return _mm256_mul_ps (a, b); }
+        static Reg div (Reg a, Reg b) noexcept                    { return _mm256_div_ps (a, b); }
+        static Reg min (Reg a, Reg b) noexcept                    { return _mm256_min_ps (a, b); }
+        static Reg max (Reg a, Reg b) noexcept                    { return _mm256_max_ps (a, b); }
+        static Reg abs (Reg v) noexcept                           { return _mm256_andnot_ps (_mm256_set1_ps (-0.0f), v); }
+        static Mask greaterThan (Reg a, Reg b) noexcept           { return _mm256_cmp_ps (a, b, _CMP_GT_OQ); }
+        static Reg select (Mask m, Reg a, Reg b) noexcept         { return _mm256_blendv_ps (b, a, m); }
+
+        static Reg copySign (Reg magnitude, Reg sign) noexcept
+        {
+            const auto signBit = _mm256_set1_ps (-0.0f);
+            return _mm256_or_ps (_mm256_andnot_ps (signBit, magnitude), _mm256_and_ps (signBit, sign));
+        }
+
+        static Reg gather (const float* base, const int* index) noexcept
+        {
+            return _mm256_i32gather_ps (base, _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (index)), 4);
+        }
+    };
+
+    #include "DspKernelsImpl.h"
+}
+NOCTAVE_END_TARGET
+
+//==============================================================================
+NOCTAVE_BEGIN_TARGET_AVX512
+namespace avx512
+{
+    static constexpr auto instructionSet = InstructionSet::avx512;
+
+    struct Vec
+    {
+        static constexpr int width = 16;
+        using Reg = __m512;
+        using Mask = __mmask16;
+
+        static Reg load (const float* p) noexcept                 { return _mm512_loadu_ps (p); }
+        static void store (float* p, Reg v) noexcept              { _mm512_storeu_ps (p, v); }
+        static Reg set1 (float v) noexcept                        { return _mm512_set1_ps (v); }
+        static Reg zero() noexcept                                { return _mm512_setzero_ps(); }
+        static Reg add (Reg a, Reg b) noexcept                    { return _mm512_add_ps (a, b); }
+        static Reg sub (Reg a, Reg b) noexcept                    { return _mm512_sub_ps (a, b); }
+        static Reg mul (Reg a, Reg b) noexcept                    { return _mm512_mul_ps (a, b); }
+        static Reg div (Reg a, Reg b) noexcept                    { return _mm512_div_ps (a, b); }
+        static Reg min (Reg a, Reg b) noexcept                    { return _mm512_min_ps (a, b); }
+        static Reg max (Reg a, Reg b) noexcept                    { return _mm512_max_ps (a, b); }
+        static Reg abs (Reg v) noexcept                           { return _mm512_abs_ps (v); }
+        static Mask greaterThan (Reg a, Reg b) noexcept           { return _mm512_cmp_ps_mask (a, b, _CMP_GT_OQ); }
+        static Reg select (Mask m, Reg a, Reg b) noexcept         { return _mm512_mask_blend_ps (m, b, a); }
+
+        static Reg copySign (Reg magnitude, Reg sign) noexcept
+        {
+            const auto signBit = _mm512_set1_epi32 ((int) 0x80000000);
+            return _mm512_castsi512_ps (_mm512_or_si512 (_mm512_andnot_si512 (signBit, _mm512_castps_si512 (magnitude)),
+                                                         _mm512_and_si512 (signBit, _mm512_castps_si512 (sign))));
+        }
+
+        static Reg gather (const float* base, const int* index) noexcept
+        {
+            return _mm512_i32gather_ps (_mm512_loadu_si512 (index), base, 4);
+        }
+    };
+
+    #include "DspKernelsImpl.h"
+}
+NOCTAVE_END_TARGET
+#endif
+
+//==============================================================================
+#if NOCTAVE_HAS_NEON_KERNELS
+namespace neon
+{
+    static constexpr auto instructionSet = InstructionSet::neon;
+
+    struct Vec
+    {
+        static constexpr int width = 4;
+        using Reg = float32x4_t;
+        using Mask = uint32x4_t;
+
+        static Reg load (const float* p) noexcept                 { return vld1q_f32 (p); }
+        static void store (float* p, Reg v) noexcept              { vst1q_f32 (p, v); }
+        static Reg set1 (float v) noexcept                        { return vdupq_n_f32 (v); }
+        static Reg zero() noexcept                                { return vdupq_n_f32 (0.0f); }
+        static Reg add (Reg a, Reg b) noexcept                    { return vaddq_f32 (a, b); }
+        static Reg sub (Reg a, Reg b) noexcept                    { return vsubq_f32 (a, b); }
+        static Reg mul (Reg a, Reg b) noexcept                    { return vmulq_f32 (a, b); }
+        static Reg div (Reg a, Reg b) noexcept                    { return vdivq_f32 (a, b); }
+        static Reg min (Reg a, Reg b) noexcept                    { return vbslq_f32 (vcltq_f32 (a, b), a, b); }
+        static Reg max (Reg a, Reg b) noexcept                    { return vbslq_f32 (vcgtq_f32 (a, b), a, b); }
+        static Reg abs (Reg v) noexcept                           { return vabsq_f32 (v); }
+        static Mask greaterThan (Reg a, Reg b) noexcept           { return vcgtq_f32 (a, b); }
+        static Reg select (Mask m, Reg a, Reg b) noexcept         { return vbslq_f32 (m, a, b); }
+
+        static Reg copySign (Reg magnitude, Reg sign) noexcept
+        {
+            return vbslq_f32 (vdupq_n_u32 (0x80000000u), sign, magnitude);
+        }
+
+        static Reg gather (const float* base, const int* index) noexcept
+        {
+            const float lanes[4] = { base[index[0]], base[index[1]], base[index[2]], base[index[3]] };
+            return vld1q_f32 (lanes);
+        }
+    };
+
+    #include "DspKernelsImpl.h"
+}
+#endif
+
+//==============================================================================
+namespace
+{
+    std::atomic<const Table*> activeTable { &scalar::table };
+    std::atomic<int> forcedInstructionSet { -1 };
+
+    const Table& getTable (InstructionSet instructionSet) noexcept
+    {
+        switch (instructionSet)
+        {
+           #if NOCTAVE_HAS_X86_KERNELS
+            case InstructionSet::sse2:    return sse2::table;
+            case InstructionSet::avx2:    return avx2::table;
+            case InstructionSet::avx512:  return avx512::table;
+           #endif
+           #if NOCTAVE_HAS_NEON_KERNELS
+            case InstructionSet::neon:    return neon::table;
+           #endif
+            case InstructionSet::scalar:
+            default:                      return scalar::table;
+        }
+    }
+
+    int parseInstructionSet (const juce::String& name)
+    {
+        for (auto isa : { InstructionSet::scalar, InstructionSet::sse2, InstructionSet::avx2,
+                          InstructionSet::avx512, InstructionSet::neon })
+            if (name.trim().equalsIgnoreCase (getName (isa)))
+                return (int) isa;
+
+        return -1;
+    }
+}
+
+bool isSupported (InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::scalar:  return true;
+       #if NOCTAVE_HAS_X86_KERNELS
+        case InstructionSet::sse2:    return juce::SystemStats::hasSSE2();
+        case InstructionSet::avx2:    return juce::SystemStats::hasAVX2();
+        case InstructionSet::avx512:  return juce::SystemStats::hasAVX512F();
+       #endif
+       #if NOCTAVE_HAS_NEON_KERNELS
+        case InstructionSet::neon:    return true;
+       #endif
+        default:                      return false;
+    }
+}
+
+InstructionSet detectInstructionSet()
+{
+    for (auto isa : { InstructionSet::avx512, InstructionSet::avx2, InstructionSet::neon, InstructionSet::sse2 })
+        if (isSupported (isa))
+            return isa;
+
+    return InstructionSet::scalar;
+}
+
+void forceInstructionSet (int instructionSetOrMinusOne)
+{
+    forcedInstructionSet.store (instructionSetOrMinusOne);
+}
+
+const Table& select()
+{
+    auto forced = forcedInstructionSet.load();
+
+    if (forced < 0)
+        forced = parseInstructionSet (juce::SystemStats::getEnvironmentVariable ("NOCTAVE_SIMD", {}));
+
+    // A forced choice the CPU can't run falls back to detection rather than crashing
+    const auto chosen = (forced >= 0 && isSupported ((InstructionSet) forced)) ? (InstructionSet) forced
+                                                                             : detectInstructionSet();
+
+    activeTable.store (&getTable (chosen));
+    return *activeTable.load();
+}
+
+const Table& getActive() noexcept
+{
+    return *activeTable.load (std::memory_order_relaxed);
+}
+
+const char* getName (InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::sse2:    return "sse2";
+        case InstructionSet::avx2:    return "avx2";
+        case InstructionSet::avx512:  return "avx512";
+        case InstructionSet::neon:    return "neon";
+        case InstructionSet::scalar:
+        default:                      return "scalar";
+    }
+}
+}
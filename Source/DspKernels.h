@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    DspKernels.h
+    Hot inner loops built for several instruction sets and picked at runtime.
+
+    Every variant evaluates the same per-sample expression in the same order as
+    the scalar reference, vectorising across samples rather than re-associating
+    sums, so all variants are bit-identical to the scalar path. This relies on
+    the compiler not contracting the scalar reference into fused multiply-adds.
+    GCC and Clang do that by default wherever FMA is baseline, arm64 included,
+    so every exporter builds with -ffp-contract=off (/fp:precise with MSVC).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace DspKernels
+{
+    //==============================================================================
+    enum class InstructionSet
+    {
+        scalar = 0,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    //==============================================================================
+    /** Function table for one instruction set.
+
+        The interpolation entries read a block of fractional positions from a
+        delay line whose guard region makes every kernel's taps contiguous:
+        out[i] is the kernel applied at line + firstTap[i] with fraction frac[i].
+    */
+    struct Table
+    {
+        InstructionSet instructionSet = InstructionSet::scalar;
+
+        void (*interpolateLinear)   (const float* line, const int* firstTap, const float* frac, float* out, int numSamples);
+        void (*interpolateHermite)  (const float* line, const int* firstTap, const float* frac, float* out, int numSamples);
+        void (*interpolateLagrange) (const float* line, const int* firstTap, const float* frac, float* out, int numSamples);
+
+        /** coefficientRow[i] is an offset into the sinc table's data, phaseFrac[i] the blend to the next row. */
+        void (*interpolateSinc) (const float* line, const float* sincTable, const int* firstTap,
+                                 const int* coefficientRow, const float* phaseFrac, float* out, int numSamples);
+
+        /** dest[i] = dry[i] * dryGain + wet[i] * wetGain. dest may alias dry or wet. */
+        void (*mix) (float* dest, const float* dry, const float* wet, float dryGain, float wetGain, int numSamples);
+    };
+
+    //==============================================================================
+    /** The best instruction set this CPU and build both support. */
+    InstructionSet detectInstructionSet();
+
+    /** True if this build contains the variant and the CPU can run it. */
+    bool isSupported (InstructionSet instructionSet);
+
+    /** Forces a specific variant for testing, or pass -1 to go back to detection.
+        The NOCTAVE_SIMD environment variable (scalar, sse2, avx2, avx512, neon)
+        does the same thing without a rebuild. Takes effect at the next select().
+    */
+    void forceInstructionSet (int instructionSetOrMinusOne);
+
+    /** Probes the CPU (or applies a forced choice) and makes that table active.
+        Called from prepareToPlay, so the probe never runs on the audio thread.
+    */
+    const Table& select();
+
+    /** The table chosen by the last select(), or the scalar table before that. */
+    const Table& getActive() noexcept;
+
+    const char* getName (InstructionSet instructionSet) noexcept;
+}
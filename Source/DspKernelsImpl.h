@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    DspKernelsImpl.h
+    Kernel bodies shared by every instruction set in DspKernels.cpp.
+
+    There is deliberately no include guard: DspKernels.cpp includes this file
+    once per instruction set, inside a namespace that defines Vec (the register
+    wrapper) and instructionSet, and with that target's code generation enabled.
+    Each body mirrors the scalar reference in Interpolation.h operation for
+    operation, one sample per lane.
+
+  ==============================================================================
+*/
+
+//==============================================================================
+template <typename V>
+inline void linearLanes (const float* line, const int* firstTap, const float* frac, float* out) noexcept
+{
+    const auto t  = V::load (frac);
+    const auto x0 = V::gather (line, firstTap);
+    const auto x1 = V::gather (line + 1, firstTap);
+
+    V::store (out, V::add (x0, V::mul (t, V::sub (x1, x0))));
+}
+
+template <typename V, typename Kernel>
+inline void polynomialLanes (const float* line, const int* firstTap, const float* frac, float* out) noexcept
+{
+    constexpr auto& matrix = Kernel::matrix;
+    constexpr int numTaps = Kernel::numTaps;
+    constexpr int order = (int) matrix.size();
+
+    const auto t = V::load (frac);
+    typename V::Reg partial[4] = { V::zero(), V::zero(), V::zero(), V::zero() };
+
+    for (int i = 0; i < numTaps; ++i)
+    {
+        auto c = V::set1 (matrix[order - 1][i]);
+
+        for (int p = order - 2; p >= 0; --p)
+            c = V::add (V::mul (c, t), V::set1 (matrix[p][i]));
+
+        partial[i & 3] = V::add (partial[i & 3], V::mul (V::gather (line + i, firstTap), c));
+    }
+
+    V::store (out, V::add (V::add (partial[0], partial[2]), V::add (partial[1], partial[3])));
+}
+
+template <typename V>
+inline void sincLanes (const float* line, const float* table, const int* firstTap,
+                       const int* coefficientRow, const float* phaseFrac, float* out) noexcept
+{
+    constexpr int numTaps = Interpolation::SincTable::numTaps;
+
+    const auto blend = V::load (phaseFrac);
+    typename V::Reg partial[4] = { V::zero(), V::zero(), V::zero(), V::zero() };
+
+    for (int i = 0; i < numTaps; ++i)
+    {
+        const auto lower = V::gather (table + i, coefficientRow);
+        const auto upper = V::gather (table + numTaps + i, coefficientRow);
+        const auto c = V::add (lower, V::mul (blend, V::sub (upper, lower)));
+
+        partial[i & 3] = V::add (partial[i & 3], V::mul (V::gather (line + i, firstTap), c));
+    }
+
+    V::store (out, V::add (V::add (partial[0], partial[2]), V::add (partial[1], partial[3])));
+}
+
+template <typename V>
+inline void mixLanes (float* dest, const float* dry, const float* wet, float dryGain, float wetGain) noexcept
+{
+    V::store (dest, V::add (V::mul (V::load (dry), V::set1 (dryGain)),
+                            V::mul (V::load (wet), V::set1 (wetGain))));
+}
+
+//==============================================================================
+static void interpolateLinear (const float* line, const int* firstTap, const float* frac, float* out, int numSamples)
+{
+    int i = 0;
+
+    for (; i + Vec::width <= numSamples; i += Vec::width)
+        linearLanes<Vec> (line, firstTap + i, frac + i, out + i);
+
+    for (; i < numSamples; ++i)
+        linearLanes<detail::ScalarVec> (line, firstTap + i, frac + i, out + i);
+}
+
+static void interpolateHermite (const float* line, const int* firstTap, const float* frac, float* out, int numSamples)
+{
+    using K = Interpolation::Hermite;
+    int i = 0;
+
+    for (; i + Vec::width <= numSamples; i += Vec::width)
+        polynomialLanes<Vec, K> (line, firstTap + i, frac + i, out + i);
+
+    for (; i < numSamples; ++i)
+        polynomialLanes<detail::ScalarVec, K> (line, firstTap + i, frac + i, out + i);
+}
+
+static void interpolateLagrange (const float* line, const int* firstTap, const float* frac, float* out, int numSamples)
+{
+    using K = Interpolation::Lagrange;
+    int i = 0;
+
+    for (; i + Vec::width <= numSamples; i += Vec::width)
+        polynomialLanes<Vec, K> (line, firstTap + i, frac + i, out + i);
+
+    for (; i < numSamples; ++i)
+        polynomialLanes<detail::ScalarVec, K> (line, firstTap + i, frac + i, out + i);
+}
+
+static void interpolateSinc (const float* line, const float* sincTable, const int* firstTap,
+                             const int* coefficientRow, const float* phaseFrac, float* out, int numSamples)
+{
+    int i = 0;
+
+    for (; i + Vec::width <= numSamples; i += Vec::width)
+        sincLanes<Vec> (line, sincTable, firstTap + i, coefficientRow + i, phaseFrac + i, out + i);
+
+    for (; i < numSamples; ++i)
+        sincLanes<detail::ScalarVec> (line, sincTable, firstTap + i, coefficientRow + i, phaseFrac + i, out + i);
+}
+
+static void mix (float* dest, const float* dry, const float* wet, float dryGain, float wetGain, int numSamples)
+{
+    int i = 0;
+
+    for (; i + Vec::width <= numSamples; i += Vec::width)
+        mixLanes<Vec> (dest + i, dry + i, wet + i, dryGain, wetGain);
+
+    for (; i < numSamples; ++i)
+        mixLanes<detail::ScalarVec> (dest + i, dry + i, wet + i, dryGain, wetGain);
+}
+
+//==============================================================================
+static const Table table { instructionSet,
+                           interpolateLinear,
+                           interpolateHermite,
+                           interpolateLagrange,
+                           interpolateSinc,
+                           mix };
@@ -0,0 +1,302 @@
+/*
+  ==============================================================================
+
+    Interpolation.h
+    Fractional-delay read kernels used by the pitch shifter's delay line.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+namespace Interpolation
+{
+    //==============================================================================
+    enum class Kernel
+    {
+        linear = 0,
+        hermite,    // 4-point, 3rd-order (Catmull-Rom)
+        lagrange,   // 6-point, 5th-order
+        sinc        // 16-point polyphase Kaiser-windowed sinc, anti-aliased
+    };
+
+    /** The largest number of taps any kernel reads. The delay line mirrors this
+        many samples past its end so that every kernel can read its taps as one
+        contiguous run without having to wrap.
+    */
+    static constexpr int maxTaps = 16;
+
+    //==============================================================================
+    /** Dot product over a fixed number of taps.
+
+        The four partial sums keep the loop free of a serial dependency, so the
+        compiler can turn it into packed multiplies and adds without -ffast-math.
+    */
+    template <int NumTaps>
+    inline float dotProduct (const float* taps, const float* coefficients) noexcept
+    {
+        static_assert (NumTaps % 4 == 0, "Pad kernels to a multiple of four taps");
+
+        float partial[4] = {};
+
+        for (int i = 0; i < NumTaps; i += 4)
+            for (int j = 0; j < 4; ++j)
+                partial[j] += taps[i + j] * coefficients[i + j];
+
+        return (partial[0] + partial[2]) + (partial[1] + partial[3]);
+    }
+
+    //==============================================================================
+    /** Builds the power-basis matrix of a Lagrange interpolator at compile time.
+
+        Row p holds the t^p coefficient of every tap's basis polynomial, with the
+        nodes at -(NumPoints / 2 - 1) ... NumPoints / 2. Columns past NumPoints
+        are left at zero so the kernel can be padded to a SIMD-friendly width.
+    */
+    template <int NumPoints, int PaddedTaps>
+    constexpr std::array<std::array<float, PaddedTaps>, NumPoints> makeLagrangeMatrix()
+    {
+        std::array<std::array<float, PaddedTaps>, NumPoints> matrix {};
+
+        for (int k = 0; k < NumPoints; ++k)
+        {
+            std::array<double, NumPoints> poly {};
+            poly[0] = 1.0;
+            double denominator = 1.0;
+            int degree = 0;
+
+            const double xk = k - (NumPoints / 2 - 1);
+
+            for (int j = 0; j < NumPoints; ++j)
+            {
+                if (j == k)
+                    continue;
+
+                const double xj = j - (NumPoints / 2 - 1);
+
+                // poly *= (t - xj)
+                for (int p = degree + 1; p > 0; --p)
+                    poly[p] = poly[p - 1] - xj * poly[p];
+
+                poly[0] = -xj * poly[0];
+                ++degree;
+                denominator *= (xk - xj);
+            }
+
+            for (int p = 0; p < NumPoints; ++p)
+                matrix[p][k] = (float) (poly[p] / denominator);
+        }
+
+        return matrix;
+    }
+
+    //==============================================================================
+    /** Evaluates every tap's basis polynomial at t with Horner's scheme, one
+        power at a time across all taps, then applies them to the taps.
+    */
+    template <int NumTaps, int Order>
+    inline float evaluatePolynomialKernel (const std::array<std::array<float, NumTaps>, Order>& matrix,
+                                           const float* taps, float t) noexcept
+    {
+        alignas (16) float coefficients[NumTaps];
+
+        for (int i = 0; i < NumTaps; ++i)
+            coefficients[i] = matrix[Order - 1][i];
+
+        for (int p = Order - 2; p >= 0; --p)
+            for (int i = 0; i < NumTaps; ++i)
+                coefficients[i] = coefficients[i] * t + matrix[p][i];
+
+        return dotProduct<NumTaps> (taps, coefficients);
+    }
+
+    //==============================================================================
+    struct Linear
+    {
+        static constexpr int numTaps = 2;
+        static constexpr int tapsBefore = 0;
+
+        float read (const float* taps, float t) const noexcept
+        {
+            return taps[0] + t * (taps[1] - taps[0]);
+        }
+    };
+
+    struct Hermite
+    {
+        static constexpr int numTaps = 4;
+        static constexpr int tapsBefore = 1;
+
+        static constexpr std::array<std::array<float, 4>, 4> matrix {{
+            {{  0.0f,  1.0f,  0.0f,  0.0f }},
+            {{ -0.5f,  0.0f,  0.5f,  0.0f }},
+            {{  1.0f, -2.5f,  2.0f, -0.5f }},
+            {{ -0.5f,  1.5f, -1.5f,  0.5f }}
+        }};
+
+        float read (const float* taps, float t) const noexcept
+        {
+            return evaluatePolynomialKernel<4, 4> (matrix, taps, t);
+        }
+    };
+
+    struct Lagrange
+    {
+        static constexpr int numPoints = 6;
+        static constexpr int numTaps = 8;   // padded, the last two coefficients are zero
+        static constexpr int tapsBefore = 2;
+
+        static constexpr auto matrix = makeLagrangeMatrix<numPoints, numTaps>();
+
+        float read (const float* taps, float t) const noexcept
+        {
+            return evaluatePolynomialKernel<numTaps, numPoints> (matrix, taps, t);
+        }
+    };
+
+    //==============================================================================
+    /** Polyphase Kaiser-windowed sinc tables.
+
+        One bank is kept per anti-aliasing cutoff, from 0.9 of Nyquist down to
+        0.225 (enough for a +2 octave shift). Each bank stores numPhases + 1
+        rows of numTaps coefficients, and the read kernel interpolates linearly
+        between neighbouring phases. The tables are shared by every instance and
+        built on first use, which prepare() takes care of off the audio thread.
+    */
+    class SincTable
+    {
+    public:
+        static constexpr int numTaps = maxTaps;
+        static constexpr int numPhases = 256;
+        static constexpr int numBanks = 8;
+
+        static const SincTable& getInstance()
+        {
+            static const SincTable table;
+            return table;
+        }
+
+        /** Picks the widest bank whose cutoff still rejects what a read head
+            moving at pitchRatio would fold back below Nyquist.
+        */
+        static int getBankForRatio (double pitchRatio) noexcept
+        {
+            if (pitchRatio <= 1.0)
+                return 0;
+
+            const auto bank = (int) std::ceil (std::log2 (pitchRatio) * (numBanks - 1) / 2.0);
+            return juce::jlimit (0, numBanks - 1, bank);
+        }
+
+        /** Offset of a phase's first coefficient from getData(). */
+        static int getRowOffset (int bank, int phase) noexcept
+        {
+            return (bank * (numPhases + 1) + phase) * numTaps;
+        }
+
+        const float* getData() const noexcept                      { return coefficients.data(); }
+        const float* getPhase (int bank, int phase) const noexcept { return getData() + getRowOffset (bank, phase); }
+
+    private:
+        SincTable()
+        {
+            constexpr double beta = 8.0;
+            constexpr double halfWidth = numTaps / 2;
+            constexpr int tapsBefore = numTaps / 2 - 1;
+
+            coefficients.resize ((size_t) numBanks * (numPhases + 1) * numTaps);
+
+            for (int bank = 0; bank < numBanks; ++bank)
+            {
+                const double cutoff = 0.9 * std::pow (2.0, -2.0 * bank / (numBanks - 1));
+
+                for (int phase = 0; phase <= numPhases; ++phase)
+                {
+                    auto* row = coefficients.data() + getRowOffset (bank, phase);
+                    const double frac = (double) phase / numPhases;
+                    double sum = 0.0;
+
+                    for (int tap = 0; tap < numTaps; ++tap)
+                    {
+                        const double x = (tap - tapsBefore) - frac;
+                        const double ratio = x / halfWidth;
+                        const double window = std::abs (ratio) < 1.0
+                                                ? besselI0 (beta * std::sqrt (1.0 - ratio * ratio)) / besselI0 (beta)
+                                                : 0.0;
+                        const double arg = juce::MathConstants<double>::pi * cutoff * x;
+                        const double sinc = std::abs (arg) < 1.0e-9 ? 1.0 : std::sin (arg) / arg;
+                        const double value = cutoff * sinc * window;
+
+                        row[tap] = (float) value;
+                        sum += value;
+                    }
+
+                    // Normalise each phase to unity DC gain
+                    for (int tap = 0; tap < numTaps; ++tap)
+                        row[tap] = (float) (row[tap] / sum);
+                }
+            }
+        }
+
+        static double besselI0 (double x) noexcept
+        {
+            double sum = 1.0, term = 1.0;
+
+            for (int k = 1; k < 32; ++k)
+            {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+
+                if (term < sum * 1.0e-12)
+                    break;
+            }
+
+            return sum;
+        }
+
+        std::vector<float> coefficients;
+    };
+
+    struct Sinc
+    {
+        static constexpr int numTaps = SincTable::numTaps;
+        static constexpr int tapsBefore = numTaps / 2 - 1;
+
+        const SincTable& table;
+        int bank = 0;
+
+        /** Splits a read fraction into a coefficient row and the blend towards the next row. */
+        static void getPhase (float t, int& phase, float& phaseFrac) noexcept
+        {
+            const float phasePosition = t * (float) SincTable::numPhases;
+            phase = juce::jmin ((int) phasePosition, SincTable::numPhases - 1);
+            phaseFrac = phasePosition - (float) phase;
+        }
+
+        float read (const float* taps, float t) const noexcept
+        {
+            int phase;
+            float phaseFrac;
+            getPhase (t, phase, phaseFrac);
+
+            const float* lower = table.getPhase (bank, phase);
+            const float* upper = lower + numTaps;
+
+            alignas (16) float coefficients[numTaps];
+
+            for (int i = 0; i < numTaps; ++i)
+                coefficients[i] = lower[i] + phaseFrac * (upper[i] - lower[i]);
+
+            return dotProduct<numTaps> (taps, coefficients);
+        }
+    };
+
+    //==============================================================================
+    inline juce::StringArray getKernelNames()
+    {
+        return { "Linear", "Hermite", "Lagrange", "Sinc" };
+    }
+}
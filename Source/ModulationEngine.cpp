@@ -0,0 +1,252 @@
+/*
+  ==============================================================================
+
+    ModulationEngine.cpp
+    Built-in LFO, envelope follower and random modulation sources.
+
+  ==============================================================================
+*/
+
+#include "ModulationEngine.h"
+#include "RealtimeChecks.h"
+
+namespace
+{
+    // Length of one cycle of each synced rate, in quarter notes
+    const double divisionBeats[] = { 0.125, 0.25, 1.0 / 3.0, 0.5, 2.0 / 3.0, 1.0, 2.0, 4.0, 8.0, 16.0 };
+
+    // Offset per unit of depth, indexed by Destination
+    const float destinationRanges[] = { 0.0f, 12.0f, 12.0f, 1.0f, 0.5f };
+
+    constexpr double envelopeAttackSeconds = 0.005;
+    constexpr double envelopeReleaseSeconds = 0.15;
+
+    // The same step always gets the same value, however playback got there
+    float getRandomValue (juce::int64 step) noexcept
+    {
+        auto z = (juce::uint64) step + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z ^= z >> 31;
+
+        return (float) (z >> 40) * (1.0f / 8388608.0f) - 1.0f;
+    }
+
+    // Replaces each phase (0 to 1) with the shape's value there (-1 to 1)
+    void applyShape (ModulationEngine::Shape shape, float* values, int numValues) noexcept
+    {
+        switch (shape)
+        {
+            case ModulationEngine::Shape::sine:
+                // Parabola with one correction step, within 0.1% of a sine
+                for (int i = 0; i < numValues; ++i)
+                {
+                    const float t = values[i] * 2.0f - 1.0f;
+                    const float y = 4.0f * t * (1.0f - std::abs (t));
+                    values[i] = -(0.225f * (y * std::abs (y) - y) + y);
+                }
+                break;
+
+            case ModulationEngine::Shape::triangle:
+                for (int i = 0; i < numValues; ++i)
+                {
+                    const float shifted = values[i] < 0.75f ? values[i] + 0.25f : values[i] - 0.75f;
+                    values[i] = 1.0f - 4.0f * std::abs (shifted - 0.5f);
+                }
+                break;
+
+            case ModulationEngine::Shape::saw:
+                for (int i = 0; i < numValues; ++i)
+                    values[i] = values[i] * 2.0f - 1.0f;
+                break;
+
+            case ModulationEngine::Shape::square:
+            default:
+                for (int i = 0; i < numValues; ++i)
+                    values[i] = values[i] < 0.5f ? 1.0f : -1.0f;
+                break;
+        }
+    }
+}
+
+//==============================================================================
+bool ModulationEngine::Settings::modulates (Destination destination) const noexcept
+{
+    return (lfo.isActive() && lfo.destination == destination)
+        || (envelope.isActive() && envelope.destination == destination)
+        || (random.isActive() && random.destination == destination);
+}
+
+const juce::StringArray& ModulationEngine::getDestinationNames()
+{
+    static const juce::StringArray names { "Off", "Pitch", "Harmony", "Mix", "Feedback" };
+    return names;
+}
+
+const juce::StringArray& ModulationEngine::getShapeNames()
+{
+    static const juce::StringArray names { "Sine", "Triangle", "Saw", "Square" };
+    return names;
+}
+
+const juce::StringArray& ModulationEngine::getDivisionNames()
+{
+    static const juce::StringArray names { "1/32", "1/16", "1/8T", "1/8", "1/4T", "1/4", "1/2", "1/1", "2/1", "4/1" };
+    return names;
+}
+
+int ModulationEngine::getDefaultDivision() noexcept
+{
+    return 5;
+}
+
+double ModulationEngine::getDivisionBeats (int division) noexcept
+{
+    return divisionBeats[juce::jlimit (0, (int) std::size (divisionBeats) - 1, division)];
+}
+
+void ModulationEngine::prepare (double newSampleRate, int maxBlockSize)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    sampleRate = newSampleRate;
+
+    // A block can start and end part-way through a grid step
+    const auto maxSteps = (size_t) (maxBlockSize / controlInterval + 2);
+    stepEnds.resize (maxSteps);
+    stepBeats.resize (maxSteps);
+    lfoValues.resize (maxSteps);
+    randomValues.resize (maxSteps);
+    envelopeValues.resize (maxSteps);
+
+    for (auto& destinationOffsets : offsets)
+        destinationOffsets.resize (maxSteps);
+
+    const auto stepSeconds = controlInterval / sampleRate;
+    attackCoefficient = (float) std::exp (-stepSeconds / envelopeAttackSeconds);
+    releaseCoefficient = (float) std::exp (-stepSeconds / envelopeReleaseSeconds);
+
+    reset();
+}
+
+void ModulationEngine::reset (juce::int64 samplePosition) noexcept
+{
+    jassert (samplePosition >= 0);
+
+    position = anchorPosition = samplePosition;
+    anchorBeats = (double) samplePosition * beatsPerMinute / (60.0 * sampleRate);
+    envelope = stepPeak = 0.0f;
+    numSteps = 0;
+}
+
+void ModulationEngine::setTransport (const juce::Optional<juce::AudioPlayHead::PositionInfo>& transport) noexcept
+{
+    if (! transport.hasValue())
+        return;
+
+    // Re-anchor on a tempo change so the beat carries on from where it was
+    if (const auto bpm = transport->getBpm(); bpm.hasValue() && *bpm > 0.0 && *bpm != beatsPerMinute)
+    {
+        anchorBeats = getBeatsAt (position);
+        anchorPosition = position;
+        beatsPerMinute = *bpm;
+    }
+
+    // While playing, follow the host's beat so the LFO lines up with the bar
+    if (transport->getIsPlaying())
+    {
+        if (const auto ppq = transport->getPpqPosition(); ppq.hasValue())
+        {
+            anchorBeats = *ppq;
+            anchorPosition = position;
+        }
+    }
+}
+
+double ModulationEngine::getBeatsAt (juce::int64 samplePosition) const noexcept
+{
+    return anchorBeats + (double) (samplePosition - anchorPosition) * beatsPerMinute / (60.0 * sampleRate);
+}
+
+//==============================================================================
+void ModulationEngine::process (const Settings& settings, const float* const* input, int numChannels, int numSamples) noexcept
+{
+    jassert (numSamples / controlInterval + 2 <= (int) stepEnds.size());
+
+    numSteps = 0;
+
+    // Split at the grid. Each step takes the sources' values at the grid point it ends on,
+    // so a step split across two blocks aims for the same value in both.
+    for (int start = 0; start < numSamples; ++numSteps)
+    {
+        const auto gridEnd = ((position + start) / controlInterval + 1) * controlInterval;
+        const int end = (int) juce::jmin ((juce::int64) numSamples, gridEnd - position);
+
+        stepEnds[(size_t) numSteps] = end;
+        stepBeats[(size_t) numSteps] = getBeatsAt (gridEnd);
+        envelopeValues[(size_t) numSteps] = envelope;
+
+        if (settings.envelope.isActive())
+            updateEnvelope (input, numChannels, start, end);
+
+        start = end;
+    }
+
+    position += numSamples;
+
+    if (settings.lfo.isActive())
+    {
+        const auto cycleBeats = getDivisionBeats (settings.lfoDivision);
+
+        for (int i = 0; i < numSteps; ++i)
+        {
+            const auto cycles = stepBeats[(size_t) i] / cycleBeats;
+            lfoValues[(size_t) i] = (float) (cycles - std::floor (cycles));
+        }
+
+        applyShape (settings.lfoShape, lfoValues.data(), numSteps);
+    }
+
+    if (settings.random.isActive())
+    {
+        const auto cycleBeats = getDivisionBeats (settings.randomDivision);
+
+        for (int i = 0; i < numSteps; ++i)
+            randomValues[(size_t) i] = getRandomValue ((juce::int64) std::floor (stepBeats[(size_t) i] / cycleBeats));
+    }
+
+    // Sum the routes into their destinations
+    for (int destination = 1; destination < (int) Destination::numDestinations; ++destination)
+    {
+        auto* destinationOffsets = offsets[(size_t) destination].data();
+        juce::FloatVectorOperations::clear (destinationOffsets, numSteps);
+
+        const auto addRoute = [&] (const Route& route, const std::vector<float>& values)
+        {
+            if (route.isActive() && (int) route.destination == destination)
+                juce::FloatVectorOperations::addWithMultiply (destinationOffsets, values.data(),
+                                                              route.depth * destinationRanges[destination], numSteps);
+        };
+
+        addRoute (settings.lfo, lfoValues);
+        addRoute (settings.envelope, envelopeValues);
+        addRoute (settings.random, randomValues);
+    }
+}
+
+void ModulationEngine::updateEnvelope (const float* const* input, int numChannels, int start, int end) noexcept
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax (input[channel] + start, end - start);
+        stepPeak = juce::jmax (stepPeak, -range.getStart(), range.getEnd());
+    }
+
+    // The envelope moves once per grid step, when the step is complete
+    if ((position + end) % controlInterval != 0)
+        return;
+
+    const float coefficient = stepPeak > envelope ? attackCoefficient : releaseCoefficient;
+    envelope = juce::jmin (1.0f, stepPeak + (envelope - stepPeak) * coefficient);
+    stepPeak = 0.0f;
+}
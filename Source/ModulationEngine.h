@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    ModulationEngine.h
+    Built-in LFO, envelope follower and random modulation sources.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/**
+    Moves pitch, harmony, mix and feedback without host automation.
+
+    Three sources, each routed to one destination with a signed depth: an LFO
+    synced to the host tempo, an envelope follower on the input, and a random
+    value held for each step of its own synced rate.
+
+    Sources are worked out at control rate, every controlInterval samples, on a
+    grid that counts from the start of playback rather than the block, so the
+    values don't depend on how the host splits its blocks. process() fills one
+    offset per grid step for each destination in plain loops over arrays, with
+    no transcendental calls, and the engines ramp linearly from one step's
+    value to the next.
+*/
+class ModulationEngine
+{
+public:
+    static constexpr int controlInterval = 32;
+
+    enum class Destination
+    {
+        none = 0,
+        pitch,
+        harmony,
+        mix,
+        feedback,
+        numDestinations
+    };
+
+    enum class Shape
+    {
+        sine = 0,
+        triangle,
+        saw,
+        square
+    };
+
+    struct Route
+    {
+        Destination destination = Destination::none;
+        float depth = 0.0f;
+
+        bool isActive() const noexcept     { return destination != Destination::none && depth != 0.0f; }
+    };
+
+    struct Settings
+    {
+        Shape lfoShape = Shape::sine;
+        int lfoDivision = 0, randomDivision = 0;    // Indexes into getDivisionNames()
+        Route lfo, envelope, random;
+
+        bool isActive() const noexcept                      { return lfo.isActive() || envelope.isActive() || random.isActive(); }
+        bool modulates (Destination destination) const noexcept;
+    };
+
+    static const juce::StringArray& getDestinationNames();
+    static const juce::StringArray& getShapeNames();
+    static const juce::StringArray& getDivisionNames();
+
+    /** Default synced rate, a quarter note. */
+    static int getDefaultDivision() noexcept;
+
+    /** Length of one cycle of a synced rate, in quarter notes. */
+    static double getDivisionBeats (int division) noexcept;
+
+    void prepare (double sampleRate, int maxBlockSize);
+
+    /** Carries on as if samplePosition samples had already played with the transport stopped. */
+    void reset (juce::int64 samplePosition = 0) noexcept;
+
+    /** Takes the tempo and, while the host is playing, the beat position at the start of the block. */
+    void setTransport (const juce::Optional<juce::AudioPlayHead::PositionInfo>& position) noexcept;
+
+    /** Works out the modulation for the next numSamples samples. input is what the envelope follows. */
+    void process (const Settings& settings, const float* const* input, int numChannels, int numSamples) noexcept;
+
+    /** Moves past samples played with nothing modulated, so the grid stays in step. */
+    void advance (int numSamples) noexcept     { position += numSamples; }
+
+    /** The last process() call's samples split at the control grid. Step i runs up to getStepEnd (i). */
+    int getNumSteps() const noexcept           { return numSteps; }
+    int getStepEnd (int step) const noexcept   { return stepEnds[(size_t) step]; }
+
+    /** Offset to add to destination's value during each step, in the parameter's own units.
+        A depth of 1 swings pitch and harmony an octave, and mix and feedback their full range.
+    */
+    const float* getOffsets (Destination destination) const noexcept   { return offsets[(size_t) destination].data(); }
+
+    /** Changes the number of steps a SmoothedValue takes to reach a new target, carrying
+        on with any ramp in progress. Engines use this to ramp over exactly one grid step
+        while their setting is modulated.
+    */
+    template <typename SmoothedValueType>
+    static void setRampLength (SmoothedValueType& value, int numSteps) noexcept
+    {
+        const auto current = value.getCurrentValue();
+        const auto target = value.getTargetValue();
+        value.reset (numSteps);
+        value.setCurrentAndTargetValue (current);
+        value.setTargetValue (target);
+    }
+
+private:
+    double getBeatsAt (juce::int64 samplePosition) const noexcept;
+    void updateEnvelope (const float* const* input, int numChannels, int start, int end) noexcept;
+
+    double sampleRate = 44100.0;
+    double beatsPerMinute = 120.0;
+
+    // Beats at anchorPosition; between transport updates the beat follows the sample count
+    juce::int64 position = 0, anchorPosition = 0;
+    double anchorBeats = 0.0;
+
+    // The envelope takes one value per grid step, from the loudest sample in it
+    float envelope = 0.0f, stepPeak = 0.0f;
+    float attackCoefficient = 0.0f, releaseCoefficient = 0.0f;
+
+    int numSteps = 0;
+    std::vector<int> stepEnds;
+    std::vector<double> stepBeats;
+    std::vector<float> lfoValues, randomValues, envelopeValues;
+    std::array<std::vector<float>, (size_t) Destination::numDestinations> offsets;
+};
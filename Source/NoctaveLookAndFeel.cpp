@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    NoctaveLookAndFeel.cpp
+    Vector-drawn controls for the editor.
+
+  ==============================================================================
+*/
+
+#include "NoctaveLookAndFeel.h"
+
+void NoctaveLookAndFeel::drawRotarySlider (juce::Graphics& g, int x, int y, int width, int height, float sliderPosProportional,
+                                           float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider)
+{
+    const auto fill = slider.findColour (juce::Slider::rotarySliderFillColourId);
+    const auto outline = slider.findColour (juce::Slider::rotarySliderOutlineColourId);
+    const auto thumb = slider.findColour (juce::Slider::thumbColourId);
+
+    const auto bounds = juce::Rectangle<int> (x, y, width, height).toFloat().reduced (4.0f);
+    const auto centre = bounds.getCentre();
+    const auto radius = juce::jmin (bounds.getWidth(), bounds.getHeight()) * 0.5f;
+    const auto trackWidth = juce::jmax (2.0f, radius * 0.1f);
+    const auto arcRadius = radius - trackWidth * 0.5f;
+    const auto angle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
+    const juce::PathStrokeType trackStroke (trackWidth, juce::PathStrokeType::curved, juce::PathStrokeType::rounded);
+
+    juce::Path track;
+    track.addCentredArc (centre.x, centre.y, arcRadius, arcRadius, 0.0f, rotaryStartAngle, rotaryEndAngle, true);
+    g.setColour (outline);
+    g.strokePath (track, trackStroke);
+
+    // Bipolar parameters (the shifts) fill from zero rather than from the bottom of the range
+    const auto& range = slider.getRange();
+    const auto originAngle = range.getStart() < 0.0 && range.getEnd() > 0.0
+                               ? rotaryStartAngle + (float) slider.valueToProportionOfLength (0.0) * (rotaryEndAngle - rotaryStartAngle)
+                               : rotaryStartAngle;
+
+    if (slider.isEnabled() && std::abs (angle - originAngle) > 0.001f)
+    {
+        juce::Path value;
+        value.addCentredArc (centre.x, centre.y, arcRadius, arcRadius, 0.0f,
+                             juce::jmin (originAngle, angle), juce::jmax (originAngle, angle), true);
+        g.setColour (fill);
+        g.strokePath (value, trackStroke);
+    }
+
+    // Body, lit from above, with a faint red rim
+    const auto bodyRadius = arcRadius - trackWidth * 1.5f;
+    const auto body = juce::Rectangle<float> (bodyRadius * 2.0f, bodyRadius * 2.0f).withCentre (centre);
+
+    g.setGradientFill (juce::ColourGradient (outline.brighter (0.4f), centre.x, body.getY(),
+                                             outline.darker (0.7f), centre.x, body.getBottom(), false));
+    g.fillEllipse (body);
+    g.setColour (fill.withAlpha (0.35f));
+    g.drawEllipse (body, juce::jmax (1.0f, trackWidth * 0.25f));
+
+    // Pointer - a fang tapering from the rim toward the centre
+    const auto fangWidth = bodyRadius * 0.2f;
+    juce::Path fang;
+    fang.startNewSubPath (-fangWidth * 0.5f, -bodyRadius * 0.95f);
+    fang.lineTo (fangWidth * 0.5f, -bodyRadius * 0.95f);
+    fang.lineTo (0.0f, -bodyRadius * 0.3f);
+    fang.closeSubPath();
+
+    g.setColour (slider.isEnabled() ? thumb.brighter (0.6f) : outline.brighter (0.3f));
+    g.fillPath (fang, juce::AffineTransform::rotation (angle).translated (centre));
+}
@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    NoctaveLookAndFeel.h
+    Vector-drawn controls for the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Draws the rotary knobs as paths rather than images, so they stay sharp at any
+    editor size and display scale. Colours come from the slider's own colour IDs.
+*/
+class NoctaveLookAndFeel  : public juce::LookAndFeel_V4
+{
+public:
+    void drawRotarySlider (juce::Graphics& g, int x, int y, int width, int height, float sliderPosProportional,
+                           float rotaryStartAngle, float rotaryEndAngle, juce::Slider& slider) override;
+};
@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    OffloadedPolyOctave.cpp
+    Poly Octave engine run a frame behind on the shared worker threads.
+
+  ==============================================================================
+*/
+
+#include "OffloadedPolyOctave.h"
+#include "RealtimeChecks.h"
+
+OffloadedPolyOctave::~OffloadedPolyOctave()
+{
+    detach();
+}
+
+void OffloadedPolyOctave::prepare (double sampleRate, int newFrameSize)
+{
+    RealtimeChecks::assertNotRealtime();
+    jassert (! isAttached());
+
+    // Nothing runs the jobs once detached, so finish any left over before resizing
+    reset();
+    runQueuedJobs();
+    releaseAbandonedFrames();
+
+    frameSize = juce::jmax (1, newFrameSize);
+
+    for (auto& frame : frames)
+        frame.samples.assign ((size_t) frameSize, 0.0f);
+
+    fallbackBuffer.assign ((size_t) frameSize, 0.0f);
+    fallbackDelay.prepare (frameSize);
+    fallbackDelay.setDelay (frameSize);
+
+    bank.prepare (sampleRate);
+    fallback.prepare (sampleRate);
+    fadeLength = juce::jmin (frameSize, (int) std::ceil (sampleRate * 0.002));
+    numMissedFrames.store (0);
+}
+
+void OffloadedPolyOctave::attach (WorkerPool& pool)
+{
+    if (isAttached())
+        return;
+
+    if (pool.addClient (*this))
+        workerPool = &pool;
+}
+
+void OffloadedPolyOctave::detach()
+{
+    if (! isAttached())
+        return;
+
+    workerPool->removeClient (*this);
+    workerPool = nullptr;
+}
+
+void OffloadedPolyOctave::reset() noexcept
+{
+    // Jobs already handed out can't be recalled; their results are dropped when they finish
+    for (auto slot : { inputSlot, postedSlot, outputSlot })
+        if (slot >= 0 && ! isFree (slot))
+            abandoned[(size_t) slot] = true;
+
+    // The frame being filled was never posted, so it's next in line again
+    if (inputSlot >= 0)
+        nextSlot = inputSlot;
+
+    inputSlot = postedSlot = outputSlot = -1;
+    fill = fadePosition = 0;
+    bankNeedsReset = true;
+    playedFallback = false;
+
+    fallback.reset();
+    fallbackDelay.reset();
+    releaseAbandonedFrames();
+}
+
+void OffloadedPolyOctave::setMixGlide (int numSamples) noexcept
+{
+    mixGlide = numSamples;
+    fallback.setMixGlide (numSamples);
+}
+
+void OffloadedPolyOctave::process (float* samples, int numSamples, int octaves, float mix, bool waitForWorkers) noexcept
+{
+    if (frameSize == 0)
+        return;
+
+    for (int done = 0; done < numSamples;)
+    {
+        if (fill == 0)
+            startFrame (waitForWorkers);
+
+        const int length = juce::jmin (numSamples - done, frameSize - fill);
+        auto* block = samples + done;
+
+        // The fallback runs on everything, so it's ready the moment a frame is late
+        auto* fallbackSamples = fallbackBuffer.data();
+        juce::FloatVectorOperations::copy (fallbackSamples, block, length);
+        fallback.process (fallbackSamples, length, octaves, mix);
+        fallbackDelay.process (fallbackSamples, length);
+
+        if (inputSlot >= 0)
+            juce::FloatVectorOperations::copy (frames[(size_t) inputSlot].samples.data() + fill, block, length);
+
+        if (outputSlot < 0)
+        {
+            juce::FloatVectorOperations::copy (block, fallbackSamples, length);
+        }
+        else
+        {
+            const auto* bankSamples = frames[(size_t) outputSlot].samples.data() + fill;
+            juce::FloatVectorOperations::copy (block, bankSamples, length);
+
+            for (int i = 0; i < length && fadePosition < fadeLength; ++i, ++fadePosition)
+            {
+                const float gain = (float) fadePosition / (float) fadeLength;
+                block[i] = fallbackSamples[i] + gain * (bankSamples[i] - fallbackSamples[i]);
+            }
+        }
+
+        fill += length;
+        done += length;
+
+        if (fill == frameSize)
+            finishFrame (octaves, mix);
+    }
+
+    releaseAbandonedFrames();
+}
+
+void OffloadedPolyOctave::runJob (int slot) noexcept
+{
+    auto& frame = frames[(size_t) slot];
+
+    if (frame.resetBank)
+        bank.reset();
+
+    bank.setNumBands (frame.numBands);
+    bank.setMixGlide (frame.mixGlide);
+    bank.process (frame.samples.data(), frameSize, frame.octaves, frame.mix);
+}
+
+void OffloadedPolyOctave::startFrame (bool waitForWorkers) noexcept
+{
+    if (outputSlot >= 0)
+        release (std::exchange (outputSlot, -1));
+
+    // The frame posted last plays now, if its job is done
+    if (postedSlot >= 0)
+    {
+        if (waitForWorkers)
+            runQueuedJobs();
+
+        if (isFinished (postedSlot))
+        {
+            outputSlot = postedSlot;
+            fadePosition = std::exchange (playedFallback, false) ? 0 : fadeLength;
+        }
+        else
+        {
+            abandoned[(size_t) postedSlot] = true;
+            playedFallback = true;
+            ++numMissedFrames;
+        }
+
+        postedSlot = -1;
+    }
+
+    // Slots are posted in turn, so a busy one holds up the input until it's free
+    if (isFree (nextSlot))
+    {
+        inputSlot = nextSlot;
+        nextSlot = (nextSlot + 1) % numSlots;
+    }
+    else
+    {
+        inputSlot = -1;
+        bankNeedsReset = true;
+        playedFallback = true;
+        ++numMissedFrames;
+    }
+}
+
+void OffloadedPolyOctave::finishFrame (int octaves, float mix) noexcept
+{
+    if (inputSlot >= 0)
+    {
+        auto& frame = frames[(size_t) inputSlot];
+        frame.octaves = octaves;
+        frame.mix = mix;
+        frame.numBands = numBands;
+        frame.mixGlide = mixGlide;
+        frame.resetBank = std::exchange (bankNeedsReset, false);
+
+        post (inputSlot);
+        postedSlot = std::exchange (inputSlot, -1);
+    }
+
+    fill = 0;
+}
+
+void OffloadedPolyOctave::releaseAbandonedFrames() noexcept
+{
+    for (int slot = 0; slot < numSlots; ++slot)
+    {
+        if (abandoned[(size_t) slot] && isFinished (slot))
+        {
+            release (slot);
+            abandoned[(size_t) slot] = false;
+        }
+    }
+}
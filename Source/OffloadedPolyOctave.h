@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    OffloadedPolyOctave.h
+    Poly Octave engine run a frame behind on the shared worker threads.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PolyOctave.h"
+#include "AnalogOctave.h"
+#include "TransientDetector.h"
+#include "WorkerPool.h"
+
+//==============================================================================
+/**
+    Runs a PolyOctave on the WorkerPool's realtime workers instead of the audio
+    thread, so many instances with big filter banks spread across cores.
+
+    The input is cut into frames of a fixed length. Each full frame is posted
+    to the pool, and its result is played while the next frame comes in, so
+    the output is exactly one frame late and a job has about a block's time to
+    finish. A frame whose job hasn't finished by the time it should play is
+    taken from an AnalogOctave instead. That one runs on the audio thread on
+    everything, delayed to line up, so the output never waits on a worker; a
+    late job carries on so the filter bank doesn't lose its state. While all
+    the frames are tied up, new input skips the bank and it restarts from
+    silence once a frame is free again.
+*/
+class OffloadedPolyOctave  : private WorkerPool::Client
+{
+public:
+    OffloadedPolyOctave() = default;
+    ~OffloadedPolyOctave() override;
+
+    /** Message thread, while detached. The output comes frameSize samples late. */
+    void prepare (double sampleRate, int frameSize);
+
+    /** Message thread. Starts or stops handing frames to the pool's workers.
+        While detached every frame is played from the fallback engine.
+    */
+    void attach (WorkerPool& pool);
+    void detach();
+    bool isAttached() const noexcept    { return workerPool != nullptr; }
+
+    /** Starts both engines again from silence. Safe on the audio thread. */
+    void reset() noexcept;
+
+    void setNumBands (int newNumBands) noexcept     { numBands = newNumBands; }
+    void setMixGlide (int numSamples) noexcept;
+
+    /** Processes samples in place, getLatencySamples() late. With waitForWorkers, as
+        when rendering offline, every frame is taken from the bank, running it on the
+        calling thread if need be.
+    */
+    void process (float* samples, int numSamples, int octaves, float mix, bool waitForWorkers) noexcept;
+
+    int getLatencySamples() const noexcept          { return frameSize; }
+
+    /** Frames played from the fallback engine since prepare(). */
+    int getNumMissedFrames() const noexcept         { return numMissedFrames.load(); }
+
+private:
+    struct Frame
+    {
+        std::vector<float> samples;  // Input, overwritten with the bank's output
+        int octaves = 0, numBands = 32, mixGlide = 0;
+        float mix = 0.0f;
+        bool resetBank = false;
+    };
+
+    void runJob (int slot) noexcept override;
+    void startFrame (bool waitForWorkers) noexcept;
+    void finishFrame (int octaves, float mix) noexcept;
+    void releaseAbandonedFrames() noexcept;
+
+    PolyOctave bank;                    // Only touched by jobs
+    AnalogOctave fallback;
+    LookaheadDelay fallbackDelay;
+    std::vector<float> fallbackBuffer;
+
+    std::array<Frame, numSlots> frames;
+    std::array<bool, numSlots> abandoned {};
+    int frameSize = 0, fill = 0;
+    int nextSlot = 0, inputSlot = -1, postedSlot = -1, outputSlot = -1;
+    int numBands = 32, mixGlide = 0;
+    bool bankNeedsReset = true;
+    std::atomic<int> numMissedFrames { 0 };
+
+    // Fade from the fallback back to the bank, so catching up again doesn't click
+    int fadeLength = 0, fadePosition = 0;
+    bool playedFallback = false;
+
+    WorkerPool* workerPool = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (OffloadedPolyOctave)
+};
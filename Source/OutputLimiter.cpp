@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    OutputLimiter.cpp
+    Lookahead, stereo-linked true-peak limiter at the end of the signal path.
+
+  ==============================================================================
+*/
+
+#include "OutputLimiter.h"
+#include "RealtimeChecks.h"
+
+namespace
+{
+    constexpr double lookaheadSeconds = 0.0015;
+}
+
+//==============================================================================
+void OutputLimiter::prepare (double newSampleRate)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    sampleRate = newSampleRate;
+
+    // A peak measured between the middle two taps of the interpolator is numTaps / 2 - 1
+    // samples old, so the audio waits that much longer than the lookahead. The minimum is
+    // held one sample longer than the ramp since the peak can sit on either of those taps.
+    lookahead = juce::jmax (1, juce::roundToInt (sampleRate * lookaheadSeconds));
+    holdLength = lookahead + 1;
+    latency = lookahead + numTaps / 2 - 1;
+    averageScale = 1.0 / (lookahead * gainScale);
+
+    // Hann-windowed sinc at a quarter, half and three quarters of the way between the middle taps
+    for (int phase = 0; phase < numPhases; ++phase)
+    {
+        const double position = numTaps / 2 - 1 + (phase + 1) / (double) (numPhases + 1);
+        double sum = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const double distance = tap - position;
+            const double window = 0.5 + 0.5 * std::cos (juce::MathConstants<double>::pi * distance / (numTaps / 2));
+            const double sinc = std::sin (juce::MathConstants<double>::pi * distance) / (juce::MathConstants<double>::pi * distance);
+            interpolators[(size_t) phase][(size_t) tap] = (float) (sinc * window);
+            sum += sinc * window;
+        }
+
+        // Unity gain at DC, so a constant at the ceiling doesn't read as an overshoot
+        for (auto& coefficient : interpolators[(size_t) phase])
+            coefficient = (float) (coefficient / sum);
+    }
+
+    deque.resize ((size_t) holdLength);
+    averageWindow.resize ((size_t) lookahead);
+    delayLine.setSize (maxChannels, latency);
+
+    setReleaseMilliseconds (100.0f);
+    reset();
+}
+
+void OutputLimiter::reset() noexcept
+{
+    for (auto& channel : history)
+        channel.fill (0.0f);
+
+    historyPosition = 0;
+
+    dequeFront = dequeSize = 0;
+    sampleIndex = 0;
+
+    std::fill (averageWindow.begin(), averageWindow.end(), (juce::int64) gainScale);
+    averageSum = (juce::int64) gainScale * lookahead;
+    averagePosition = 0;
+
+    delayLine.clear();
+    delayPosition = 0;
+
+    gain = 1.0f;
+}
+
+void OutputLimiter::setCeilingDecibels (float newCeiling) noexcept
+{
+    ceiling = juce::Decibels::decibelsToGain (newCeiling);
+}
+
+void OutputLimiter::setReleaseMilliseconds (float newRelease) noexcept
+{
+    releaseCoefficient = (float) std::exp (-1000.0 / (juce::jmax (1.0f, newRelease) * sampleRate));
+}
+
+int OutputLimiter::getWarmUpSamples (float releaseMilliseconds) const noexcept
+{
+    // The windows hold latency + holdLength + lookahead samples of history. The release
+    // then needs long enough to shrink an old gain difference below float precision.
+    const auto coefficient = std::exp (-1000.0 / (juce::jmax (1.0f, releaseMilliseconds) * sampleRate));
+    const auto releaseSamples = (int) std::ceil (std::log (std::ldexp (1.0, -28)) / std::log (coefficient));
+
+    return latency + holdLength + lookahead + releaseSamples;
+}
+
+//==============================================================================
+float OutputLimiter::measurePeak (int channel, float input) noexcept
+{
+    // Each sample is written twice, so the last numTaps always sit in one contiguous run
+    auto& line = history[(size_t) channel];
+    line[(size_t) historyPosition] = line[(size_t) (historyPosition + numTaps)] = input;
+    const auto* taps = line.data() + historyPosition + 1;
+
+    float peak = std::abs (taps[numTaps / 2 - 1]);
+
+    for (const auto& coefficients : interpolators)
+    {
+        float sum = 0.0f;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            sum += taps[tap] * coefficients[(size_t) tap];
+
+        peak = juce::jmax (peak, std::abs (sum));
+    }
+
+    return peak;
+}
+
+void OutputLimiter::process (juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept
+{
+    const int numChannels = juce::jmin (buffer.getNumChannels(), maxChannels);
+
+    if (numChannels == 0 || deque.empty())
+        return;
+
+    float* channels[maxChannels] {};
+    float* delayed[maxChannels] {};
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        channels[channel] = buffer.getWritePointer (channel, startSample);
+        delayed[channel] = delayLine.getWritePointer (channel);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Linked: the loudest channel sets the gain for both
+        float peak = 0.0f;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            peak = juce::jmax (peak, measurePeak (channel, channels[channel][i]));
+
+        if (++historyPosition == numTaps)
+            historyPosition = 0;
+
+        const float required = peak > ceiling ? ceiling / peak : 1.0f;
+
+        // Drop the entry leaving the window, then every later entry that can no longer be
+        // the minimum. Each entry goes in and out once, so this is O(1) per sample.
+        if (dequeSize > 0 && sampleIndex - deque[(size_t) dequeFront].index >= (juce::uint32) holdLength)
+        {
+            dequeFront = dequeFront + 1 == holdLength ? 0 : dequeFront + 1;
+            --dequeSize;
+        }
+
+        while (dequeSize > 0 && deque[(size_t) ((dequeFront + dequeSize - 1) % holdLength)].gain >= required)
+            --dequeSize;
+
+        deque[(size_t) ((dequeFront + dequeSize) % holdLength)] = { sampleIndex++, required };
+        ++dequeSize;
+
+        // Averaging the held minimum over the lookahead ramps the gain down just in time
+        const auto held = (juce::int64) (deque[(size_t) dequeFront].gain * gainScale);
+        averageSum += held - averageWindow[(size_t) averagePosition];
+        averageWindow[(size_t) averagePosition] = held;
+
+        if (++averagePosition == lookahead)
+            averagePosition = 0;
+
+        const auto average = (float) ((double) averageSum * averageScale);
+        gain = average < gain ? average : average + (gain - average) * releaseCoefficient;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float output = delayed[channel][delayPosition];
+            delayed[channel][delayPosition] = channels[channel][i];
+            channels[channel][i] = output * gain;
+        }
+
+        if (++delayPosition == latency)
+            delayPosition = 0;
+    }
+}
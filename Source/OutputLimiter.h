@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    OutputLimiter.h
+    Lookahead, stereo-linked true-peak limiter at the end of the signal path.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/**
+    The plugin's only gain protection. Everything before it runs at unity, so
+    clean material passes untouched and only peaks above the ceiling are turned
+    down.
+
+    Peaks are measured between samples too, from a 4x interpolation, so the
+    ceiling holds after the host converts to analogue or resamples. Both channels
+    get the same gain, which keeps the stereo image still while limiting.
+
+    The audio is delayed by the lookahead. Each sample's required gain goes into
+    a sliding-window minimum kept in a monotonic deque, which is O(1) per sample
+    however long the window is, and a moving average of that minimum ramps the
+    gain down in time for each peak. Recovery follows the release time.
+*/
+class OutputLimiter
+{
+public:
+    static constexpr int maxChannels = 2;
+
+    /** Sizes the delay lines. The lookahead, and so the latency, depends on the sample rate. */
+    void prepare (double sampleRate);
+    void reset() noexcept;
+
+    void setCeilingDecibels (float newCeiling) noexcept;
+    void setReleaseMilliseconds (float newRelease) noexcept;
+
+    /** Delay added to the audio, to report to the host. */
+    int getLatencySamples() const noexcept     { return latency; }
+
+    /** Pre-roll needed after a reset before the gain no longer depends on what came before,
+        for restarting a render part-way through.
+    */
+    int getWarmUpSamples (float releaseMilliseconds) const noexcept;
+
+    /** Limits up to maxChannels channels in place. */
+    void process (juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+private:
+    // Taps per interpolation phase; the measured point lies between the middle two
+    static constexpr int numTaps = 8;
+    static constexpr int numPhases = 3;
+
+    // Gains are summed as fixed point, so the moving average never drifts
+    static constexpr double gainScale = 16777216.0;
+
+    struct Entry
+    {
+        juce::uint32 index;
+        float gain;
+    };
+
+    float measurePeak (int channel, float input) noexcept;
+
+    double sampleRate = 44100.0;
+    int lookahead = 1, holdLength = 2, latency = 4;
+    double averageScale = 1.0 / gainScale;
+    float ceiling = 1.0f;
+    float releaseCoefficient = 0.0f;
+
+    std::array<std::array<float, numTaps>, numPhases> interpolators {};
+    std::array<std::array<float, numTaps * 2>, maxChannels> history {};
+    int historyPosition = 0;
+
+    // Monotonic deque: gains rise from front to back, so the front is the window's minimum
+    std::vector<Entry> deque;
+    int dequeFront = 0, dequeSize = 0;
+    juce::uint32 sampleIndex = 0;
+
+    std::vector<juce::int64> averageWindow;
+    juce::int64 averageSum = 0;
+    int averagePosition = 0;
+
+    juce::AudioBuffer<float> delayLine;
+    int delayPosition = 0;
+
+    float gain = 1.0f;
+};
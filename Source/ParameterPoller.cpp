@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    ParameterPoller.cpp
+    Keeps the editor's controls in step with their parameters once per frame.
+
+  ==============================================================================
+*/
+
+#include "ParameterPoller.h"
+
+//==============================================================================
+class ParameterPoller::Binding
+{
+public:
+    Binding (juce::Component& controlToBind, juce::RangedAudioParameter& parameterToBind, std::atomic<float>& valueToRead)
+        : control (controlToBind), parameter (parameterToBind), value (valueToRead)
+    {
+    }
+
+    virtual ~Binding() = default;
+
+    void poll()
+    {
+        const auto current = value.load (std::memory_order_relaxed);
+
+        if (current == lastValue)
+            return;
+
+        lastValue = current;
+
+        const juce::ScopedValueSetter<bool> showing (isShowing, true);
+        show (current);
+    }
+
+    juce::Component& control;
+
+protected:
+    virtual void show (float newValue) = 0;
+
+    // From the control to the host. Changes the poll itself makes aren't sent back
+    void setValue (float newValue, bool partOfGesture)
+    {
+        if (isShowing)
+            return;
+
+        if (! partOfGesture)
+            parameter.beginChangeGesture();
+
+        parameter.setValueNotifyingHost (parameter.convertTo0to1 (newValue));
+
+        if (! partOfGesture)
+            parameter.endChangeGesture();
+    }
+
+    juce::RangedAudioParameter& parameter;
+
+private:
+    std::atomic<float>& value;
+    float lastValue = std::numeric_limits<float>::quiet_NaN();     // Never equal, so the first poll shows the value
+    bool isShowing = false;
+};
+
+//==============================================================================
+class ParameterPoller::SliderBinding  : public Binding
+{
+public:
+    SliderBinding (juce::Slider& sliderToBind, juce::RangedAudioParameter& parameterToBind, std::atomic<float>& valueToRead)
+        : Binding (sliderToBind, parameterToBind, valueToRead), slider (sliderToBind)
+    {
+        auto& param = parameter;
+        slider.valueFromTextFunction = [&param] (const juce::String& text) { return (double) param.convertFrom0to1 (param.getValueForText (text)); };
+        slider.textFromValueFunction = [&param] (double v) { return param.getText (param.convertTo0to1 ((float) v), 0); };
+        slider.setDoubleClickReturnValue (true, param.convertFrom0to1 (param.getDefaultValue()));
+
+        // The slider moves through the parameter's own range, skew and steps
+        const auto range = parameter.getNormalisableRange();
+        juce::NormalisableRange<double> sliderRange ((double) range.start, (double) range.end,
+            [range] (double, double, double proportion) { return (double) range.convertFrom0to1 ((float) proportion); },
+            [range] (double, double, double v)          { return (double) range.convertTo0to1 ((float) v); },
+            [range] (double, double, double v)          { return (double) range.snapToLegalValue ((float) v); });
+        sliderRange.interval = range.interval;
+        sliderRange.skew = range.skew;
+        sliderRange.symmetricSkew = range.symmetricSkew;
+        slider.setNormalisableRange (sliderRange);
+
+        slider.onDragStart = [this] { parameter.beginChangeGesture(); };
+        slider.onValueChange = [this] { setValue ((float) slider.getValue(), slider.isMouseButtonDown()); };
+        slider.onDragEnd = [this] { parameter.endChangeGesture(); };
+    }
+
+    ~SliderBinding() override
+    {
+        slider.onDragStart = nullptr;
+        slider.onValueChange = nullptr;
+        slider.onDragEnd = nullptr;
+    }
+
+private:
+    void show (float newValue) override     { slider.setValue ((double) newValue, juce::dontSendNotification); }
+
+    juce::Slider& slider;
+};
+
+//==============================================================================
+class ParameterPoller::ComboBoxBinding  : public Binding
+{
+public:
+    ComboBoxBinding (juce::ComboBox& boxToBind, juce::RangedAudioParameter& parameterToBind, std::atomic<float>& valueToRead)
+        : Binding (boxToBind, parameterToBind, valueToRead), box (boxToBind)
+    {
+        box.onChange = [this] { setValue ((float) box.getSelectedItemIndex(), false); };
+    }
+
+    ~ComboBoxBinding() override
+    {
+        box.onChange = nullptr;
+    }
+
+private:
+    void show (float newValue) override     { box.setSelectedItemIndex (juce::roundToInt (newValue), juce::dontSendNotification); }
+
+    juce::ComboBox& box;
+};
+
+//==============================================================================
+class ParameterPoller::ButtonBinding  : public Binding
+{
+public:
+    ButtonBinding (juce::Button& buttonToBind, juce::RangedAudioParameter& parameterToBind, std::atomic<float>& valueToRead)
+        : Binding (buttonToBind, parameterToBind, valueToRead), button (buttonToBind)
+    {
+        button.setClickingTogglesState (true);
+        button.onClick = [this] { setValue (button.getToggleState() ? 1.0f : 0.0f, false); };
+    }
+
+    ~ButtonBinding() override
+    {
+        button.onClick = nullptr;
+    }
+
+private:
+    void show (float newValue) override     { button.setToggleState (newValue >= 0.5f, juce::dontSendNotification); }
+
+    juce::Button& button;
+};
+
+//==============================================================================
+ParameterPoller::ParameterPoller (juce::AudioProcessorValueTreeState& stateToPoll, juce::Component& editor)
+    : state (stateToPoll),
+      vblankAttachment (&editor, [this] { poll(); })
+{
+}
+
+ParameterPoller::~ParameterPoller() = default;
+
+template <typename BindingType, typename ControlType>
+void ParameterPoller::add (ControlType& control, const juce::String& parameterID)
+{
+    auto* parameter = state.getParameter (parameterID);
+    auto* value = state.getRawParameterValue (parameterID);
+    jassert (parameter != nullptr && value != nullptr);
+
+    // The old binding has to go first, as its destructor clears the control's callbacks
+    bindings.erase (std::remove_if (bindings.begin(), bindings.end(),
+                                    [&control] (const auto& binding) { return &binding->control == &control; }),
+                    bindings.end());
+
+    bindings.push_back (std::make_unique<BindingType> (control, *parameter, *value));
+
+    // Shown straight away rather than a frame late
+    bindings.back()->poll();
+}
+
+void ParameterPoller::attach (juce::Slider& slider, const juce::String& parameterID)     { add<SliderBinding> (slider, parameterID); }
+void ParameterPoller::attach (juce::ComboBox& box, const juce::String& parameterID)      { add<ComboBoxBinding> (box, parameterID); }
+void ParameterPoller::attach (juce::Button& button, const juce::String& parameterID)     { add<ButtonBinding> (button, parameterID); }
+
+void ParameterPoller::poll()
+{
+    for (auto& binding : bindings)
+        binding->poll();
+}
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    ParameterPoller.h
+    Keeps the editor's controls in step with their parameters once per frame.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Connects controls to parameters like the APVTS attachments, but without
+    listening to the parameters. A listener posts an update to the message thread
+    for every change the host makes, so dense automation with several editors open
+    can swamp it. Here each control instead reads its parameter's value from the
+    atomic the audio thread already writes, once per display frame, and only the
+    controls whose values changed are updated and repainted. The message thread's
+    work follows the frame rate, however fast the automation is.
+
+    Changes made with the controls reach the host straight away, in change
+    gestures, as they do with the attachments.
+*/
+class ParameterPoller
+{
+public:
+    /** Polls on the vertical blank of the display the editor is on. */
+    ParameterPoller (juce::AudioProcessorValueTreeState& state, juce::Component& editor);
+    ~ParameterPoller();
+
+    /** Attaches a control, replacing whatever it was attached to before. */
+    void attach (juce::Slider& slider, const juce::String& parameterID);
+    void attach (juce::ComboBox& box, const juce::String& parameterID);
+    void attach (juce::Button& button, const juce::String& parameterID);
+
+    /** Updates the controls whose parameters changed since the last frame. */
+    void poll();
+
+private:
+    class Binding;
+    class SliderBinding;
+    class ComboBoxBinding;
+    class ButtonBinding;
+
+    template <typename BindingType, typename ControlType>
+    void add (ControlType& control, const juce::String& parameterID);
+
+    juce::AudioProcessorValueTreeState& state;
+    std::vector<std::unique_ptr<Binding>> bindings;
+    juce::VBlankAttachment vblankAttachment;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterPoller)
+};
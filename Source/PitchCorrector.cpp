@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    PitchCorrector.cpp
+    Control-rate pitch correction towards scale or MIDI target notes.
+
+  ==============================================================================
+*/
+
+#include "PitchCorrector.h"
+
+namespace
+{
+    // A new target has to be this many semitones nearer than the current one
+    constexpr float targetHysteresis = 0.2f;
+
+    // Full humanise adds this much retune time once a note has been held humaniseOnsetSeconds
+    constexpr double maxHumaniseSeconds = 0.4;
+    constexpr double humaniseOnsetSeconds = 0.25;
+
+    // Beyond this the pitch is taken to be a different note, not an out-of-tune one
+    constexpr float maxCorrection = 12.0f;
+}
+
+//==============================================================================
+void PitchCorrector::prepare (double sampleRate, int controlInterval)
+{
+    controlPeriodSeconds = controlInterval / sampleRate;
+    reset();
+}
+
+void PitchCorrector::reset() noexcept
+{
+    correction = 0.0f;
+    target = -1;
+    heldSeconds = 0.0;
+    heldNotes.reset();
+    heldPitchClasses.reset();
+}
+
+void PitchCorrector::handleMidiMessage (const juce::MidiMessage& message) noexcept
+{
+    if (message.isNoteOn())
+        heldNotes.set ((size_t) message.getNoteNumber());
+    else if (message.isNoteOff())
+        heldNotes.reset ((size_t) message.getNoteNumber());
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+        heldNotes.reset();
+    else
+        return;
+
+    heldPitchClasses.reset();
+
+    for (size_t note = 0; note < heldNotes.size(); ++note)
+        if (heldNotes[note])
+            heldPitchClasses.set (note % 12);
+}
+
+float PitchCorrector::update (float frequency, int root, Scales::Scale scale, bool useMidi) noexcept
+{
+    float wanted = 0.0f;
+
+    if (frequency > 0.0f)
+    {
+        const float played = Scales::frequencyToNote (frequency);
+        const bool fromMidi = useMidi && heldPitchClasses.any();
+        const int nearest = fromMidi ? getNearestHeldNote (played) : Scales::getNearestNote (played, root, scale);
+
+        if (target < 0 || ! isTarget (target, root, scale, fromMidi)
+             || std::abs (played - (float) nearest) + targetHysteresis < std::abs (played - (float) target))
+        {
+            if (nearest != target)
+                heldSeconds = 0.0;
+
+            target = nearest;
+        }
+
+        wanted = juce::jlimit (-maxCorrection, maxCorrection, (float) target - played);
+        heldSeconds += controlPeriodSeconds;
+    }
+    else
+    {
+        target = -1;
+        heldSeconds = 0.0;
+    }
+
+    // The smoother's coefficient changes with the time held, so it's worked out once per period
+    const double retuneTime = retuneSeconds + humanise * maxHumaniseSeconds * juce::jmin (1.0, heldSeconds / humaniseOnsetSeconds);
+    const float coefficient = retuneTime > 0.0 ? (float) std::exp (-controlPeriodSeconds / retuneTime) : 0.0f;
+
+    correction = wanted + (correction - wanted) * coefficient;
+    return correction;
+}
+
+bool PitchCorrector::isTarget (int note, int root, Scales::Scale scale, bool fromMidi) const noexcept
+{
+    return fromMidi ? heldPitchClasses[(size_t) (note % 12)] : Scales::contains (root, scale, note);
+}
+
+int PitchCorrector::getNearestHeldNote (float midiNote) const noexcept
+{
+    // A held note stands for its pitch class in every octave, and one is always within a tritone
+    const int below = (int) std::floor (midiNote);
+    int nearest = below;
+    float nearestDistance = std::numeric_limits<float>::max();
+
+    for (int note = below - 6; note <= below + 6; ++note)
+    {
+        const float distance = std::abs ((float) note - midiNote);
+
+        if (note >= 0 && heldPitchClasses[(size_t) (note % 12)] && distance < nearestDistance)
+        {
+            nearest = note;
+            nearestDistance = distance;
+        }
+    }
+
+    return nearest;
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    PitchCorrector.h
+    Control-rate pitch correction towards scale or MIDI target notes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <bitset>
+#include "Scales.h"
+
+//==============================================================================
+/**
+    Works out how far to shift the input so it lands on the nearest target note,
+    one control period at a time.
+
+    The target is the nearest note of the scale, or, while notes are held on
+    MIDI, the nearest note sharing a pitch class with one of them. A new target
+    has to be clearly nearer than the current one before it takes over, so a
+    pitch halfway between two notes doesn't flip.
+    The correction follows the target through a one-pole smoother whose time is
+    the retune speed; with humanise, a note held longer retunes more slowly, so
+    sustained notes keep their vibrato while short ones still snap. The
+    smoother's coefficient is worked out once per period, and the shifter
+    glides linearly across each period to the value it gives.
+*/
+class PitchCorrector
+{
+public:
+    /** controlInterval is the length of one period in samples. */
+    void prepare (double sampleRate, int controlInterval);
+
+    /** Relaxes to no correction and forgets the target and held notes. */
+    void reset() noexcept;
+
+    /** Time to close most of the distance to a new note; 0 snaps straight to it. */
+    void setRetuneSpeed (float milliseconds) noexcept   { retuneSeconds = milliseconds * 0.001f; }
+
+    /** 0 to 1: how much the retune slows down on sustained notes. */
+    void setHumanise (float amount) noexcept            { humanise = juce::jlimit (0.0f, 1.0f, amount); }
+
+    /** Note-ons, note-offs and all-notes-off change the held notes. */
+    void handleMidiMessage (const juce::MidiMessage& message) noexcept;
+
+    /** Advances one control period. frequency is the input's pitch in Hz, or 0
+        while unvoiced, which relaxes the correction. With useMidi the held notes
+        are the targets, falling back to the scale while none are held.
+        Returns the shift in semitones to reach by the end of the period.
+    */
+    float update (float frequency, int root, Scales::Scale scale, bool useMidi) noexcept;
+
+private:
+    bool isTarget (int note, int root, Scales::Scale scale, bool fromMidi) const noexcept;
+    int getNearestHeldNote (float midiNote) const noexcept;
+
+    double controlPeriodSeconds = 32.0 / 44100.0;
+    float retuneSeconds = 0.05f, humanise = 0.0f;
+    float correction = 0.0f;
+    int target = -1;
+    double heldSeconds = 0.0;   // Time on the current target
+
+    std::bitset<128> heldNotes;
+    std::bitset<12> heldPitchClasses;
+};
@@ -0,0 +1,631 @@
+/*
+  ==============================================================================
+
+    PitchShifter.cpp
+    Delay-line pitch shifter used for both the main shift and the harmonizer.
+
+  ==============================================================================
+*/
+
+#include "PitchShifter.h"
+#include "ModulationEngine.h"
+#include "RealtimeChecks.h"
+
+namespace
+{
+    // Default glide times for setting changes
+    constexpr double pitchGlideSeconds = 0.05;
+    constexpr double mixGlideSeconds = 0.02;
+
+    // Span after a steered onset that the next natural splice is kept out of
+    constexpr double transientHoldSeconds = 0.01;
+
+    // How long a freeze takes to fade in or out
+    constexpr double freezeFadeSeconds = 0.02;
+}
+
+//==============================================================================
+PitchShifter::History::History()
+{
+    RealtimeChecks::assertNotRealtime();
+
+    // Compact lines are decoded with wrap-around, so they don't need the guard region
+   #if NOCTAVE_COMPACT_HISTORY
+    samples.resize ((size_t) maxDelaySamples);
+   #else
+    samples.resize ((size_t) (maxDelaySamples + guardSamples));
+   #endif
+}
+
+void PitchShifter::History::clear() noexcept
+{
+    std::fill (samples.begin(), samples.end(), Sample {});
+}
+
+size_t PitchShifter::getHistorySizeInBytes() noexcept
+{
+   #if NOCTAVE_COMPACT_HISTORY
+    return (size_t) maxDelaySamples * sizeof (History::Sample);
+   #else
+    return (size_t) (maxDelaySamples + guardSamples) * sizeof (History::Sample);
+   #endif
+}
+
+//==============================================================================
+void PitchShifter::prepare (double sampleRate, int maxBlockSize, bool allocateHistory)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    juce::ignoreUnused (maxBlockSize);
+    currentSampleRate = sampleRate;
+    kernels = &DspKernels::getActive();
+
+    // Build the shared sinc tables here rather than on the first audio callback
+    juce::ignoreUnused (Interpolation::SincTable::getInstance());
+
+    if (allocateHistory && history == nullptr)
+        history = std::make_unique<History>();
+
+    transientDetector.prepare (sampleRate);
+    dryDelay.prepare ((int) std::ceil (maxLookaheadSeconds * sampleRate));
+    transientHold = (int) std::ceil (transientHoldSeconds * sampleRate);
+
+    pitchRatio.reset (sampleRate, pitchGlideSeconds);
+    mixAmount.reset (sampleRate, mixGlideSeconds);
+    feedbackAmount.reset (sampleRate, mixGlideSeconds);
+    freezeAmount.reset (sampleRate, freezeFadeSeconds);
+    pitchGlide = mixGlide = feedbackGlide = 0;
+    reset();
+}
+
+void PitchShifter::reset (juce::int64 samplePosition)
+{
+    jassert (samplePosition >= 0 && samplePosition <= 0xffffffff);
+
+    if (history != nullptr)
+        history->clear();
+
+    transientDetector.reset (samplePosition);
+    dryDelay.reset();
+    startPosition = position = samplePosition;
+    snapToTargets = true;
+
+    // Still frozen, but on what the cleared line holds from here. The grains are placed
+    // the same way every time, so renders repeat exactly.
+    captureNeeded = frozen;
+    grainRandom.setSeed (samplePosition);
+    freezeAmount.setCurrentAndTargetValue (frozen ? 1.0f : 0.0f);
+}
+
+std::unique_ptr<PitchShifter::History> PitchShifter::exchangeHistory (std::unique_ptr<History> newHistory) noexcept
+{
+    std::swap (history, newHistory);
+    return newHistory;
+}
+
+void PitchShifter::setLookahead (int numSamples) noexcept
+{
+    if (numSamples > 0)
+        numSamples = juce::jmax (numSamples, minLookaheadSamples);
+
+    if (numSamples == dryDelay.getDelay())
+        return;
+
+    // Onsets already found were timed for the old lookahead
+    dryDelay.setDelay (numSamples);
+    transientDetector.reset (position);
+}
+
+void PitchShifter::setFreeze (bool shouldFreeze) noexcept
+{
+    if (shouldFreeze == frozen)
+        return;
+
+    frozen = shouldFreeze;
+    freezeAmount.setTargetValue (frozen ? 1.0f : 0.0f);
+
+    // The loop is taken at the start of the next block. Detection stops while frozen,
+    // so it starts again from where the input is when writing resumes.
+    if (frozen)
+        captureNeeded = true;
+    else
+        transientDetector.reset (position);
+}
+
+void PitchShifter::setGlide (int pitchSamples, int mixSamples, int feedbackSamples) noexcept
+{
+    const auto update = [this] (auto& value, int& glide, int newGlide, double defaultSeconds)
+    {
+        if (newGlide == glide)
+            return;
+
+        glide = newGlide;
+        ModulationEngine::setRampLength (value, newGlide > 0 ? newGlide : (int) std::floor (defaultSeconds * currentSampleRate));
+    };
+
+    update (pitchRatio, pitchGlide, pitchSamples, pitchGlideSeconds);
+    update (mixAmount, mixGlide, mixSamples, mixGlideSeconds);
+    update (feedbackAmount, feedbackGlide, feedbackSamples, mixGlideSeconds);
+}
+
+int PitchShifter::getWarmUpSamples (float feedback) noexcept
+{
+    // Each pass round the line scales what's left of the old state by the loop gain;
+    // past 2^-28 it no longer changes a float result. Two spare passes for rounding.
+    const float loopGain = juce::jlimit (0.0f, 0.5f, feedback) * 0.75f;
+    const int numPasses = loopGain > 0.0f ? (int) std::ceil (std::log (std::ldexp (1.0, -28)) / std::log (loopGain)) + 2
+                                          : 1;
+
+    return numPasses * maxDelaySamples + subBlockSize;
+}
+
+juce::uint64 PitchShifter::toPhaseStep (float ratio) noexcept
+{
+    return (juce::uint64) std::llround ((double) ratio * 4294967296.0);
+}
+
+void PitchShifter::positionVoice (juce::int64 samplePosition, float ratio) noexcept
+{
+    // Both heads start mid-line, the read head a kernel's width behind, and move by a
+    // fixed amount per sample, so their positions after n samples can be worked out
+    // directly, modulo the line length
+    const auto n = (juce::uint64) samplePosition;
+    const auto step = toPhaseStep (ratio);
+    const auto wholeSamples = (n % maxDelaySamples) * (step >> 32) % maxDelaySamples;
+    const auto travelled = ((wholeSamples << 32) + (n * (step & 0xffffffffu)) % lineLength) % lineLength;
+    const auto startPhase = (juce::uint64) (maxDelaySamples / 2 - Interpolation::maxTaps) << 32;
+
+    voices[0].readPhase = (startPhase + travelled) % lineLength;
+    voices[0].writePosition = (int) ((maxDelaySamples / 2 + n) % maxDelaySamples);
+}
+
+void PitchShifter::processBlock (juce::AudioBuffer<float>& buffer,
+                                 float pitchShiftSemitones,
+                                 float mix,
+                                 float feedback)
+{
+    if (buffer.getNumSamples() == 0)
+        return;
+
+    // Convert semitones to pitch ratio
+    const float targetRatio = std::pow (2.0f, pitchShiftSemitones / 12.0f);
+
+    // Clamp feedback to prevent runaway accumulation
+    feedback = juce::jlimit (0.0f, 0.5f, feedback);
+
+    // Ramp to the new settings from this sample on; jump straight there after a prepare
+    if (snapToTargets)
+    {
+        pitchRatio.setCurrentAndTargetValue (targetRatio);
+        mixAmount.setCurrentAndTargetValue (mix);
+        feedbackAmount.setCurrentAndTargetValue (feedback);
+        positionVoice (startPosition, targetRatio);
+        snapToTargets = false;
+    }
+    else
+    {
+        pitchRatio.setTargetValue (targetRatio);
+        mixAmount.setTargetValue (mix);
+        feedbackAmount.setTargetValue (feedback);
+    }
+
+    auto* samples = buffer.getWritePointer (0);
+    const int numSamples = buffer.getNumSamples();
+
+    // Onsets are found for the whole block before any of it plays
+    if (dryDelay.getDelay() > 0 && ! frozen)
+        transientDetector.process (samples, numSamples);
+
+    // Without a delay line there's no wet signal, only the dry part of the mix
+    if (history == nullptr)
+    {
+        dryDelay.process (samples, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] *= 1.0f - mixAmount.getNextValue();
+
+        position += numSamples;
+
+        while (transientDetector.getNextOnset() >= 0
+                && transientDetector.getNextOnset() + dryDelay.getDelay() < position)
+            transientDetector.popOnset();
+
+        return;
+    }
+
+    if (std::exchange (captureNeeded, false))
+        captureLoop();
+
+    // Dispatch once per block so the per-sample loop is specialised for the kernel
+    switch (interpolation)
+    {
+        case Interpolation::Kernel::linear:
+            processSamples (samples, numSamples, Interpolation::Linear{});
+            break;
+
+        case Interpolation::Kernel::hermite:
+            processSamples (samples, numSamples, Interpolation::Hermite{});
+            break;
+
+        case Interpolation::Kernel::lagrange:
+            processSamples (samples, numSamples, Interpolation::Lagrange{});
+            break;
+
+        case Interpolation::Kernel::sinc:
+        default:
+            processSamples (samples, numSamples, Interpolation::Sinc { Interpolation::SincTable::getInstance(), 0 });
+            break;
+    }
+
+    position += numSamples;
+}
+
+juce::uint64 PitchShifter::getSplicePhase (int writePosition, float ratio, int numTaps) const noexcept
+{
+    // The onset reached the line the lookahead ago, so reading that far behind the write
+    // head plays it in step with the dry signal. Shifting up, the read head gains on the
+    // write head, so it starts further back and plays the attack late by just enough to
+    // keep the next crossing out of the transient hold.
+    const int lookahead = dryDelay.getDelay();
+    const double lateBy = juce::jmax (0.0, (double) (ratio - 1.0f) * transientHold + numTaps - lookahead);
+    const double age = lookahead + ratio * lateBy;
+
+    const auto writePhase = (juce::uint64) writePosition << 32;
+    const auto agePhase = (juce::uint64) std::llround (age * 4294967296.0) % lineLength;
+
+    return (writePhase + lineLength - agePhase) % lineLength;
+}
+
+template <typename KernelType>
+void PitchShifter::processSamples (float* samples, int numSamples, KernelType kernel) noexcept
+{
+    // Once fully frozen only the grains play; while a freeze fades in or out both do
+    if (frozen && ! freezeAmount.isSmoothing())
+    {
+        processFrozen (samples, numSamples, kernel);
+        return;
+    }
+
+    const bool freezeFading = freezeAmount.isSmoothing();
+    auto& voice = voices[0];
+    auto* delayData = history->samples.data();
+
+    for (int start = 0; start < numSamples; start += subBlockSize)
+    {
+        const int num = juce::jmin (subBlockSize, numSamples - start);
+
+        // Band-limit for the fastest the read head will move in this sub-block
+        if constexpr (std::is_same_v<KernelType, Interpolation::Sinc>)
+            kernel.bank = Interpolation::SincTable::getBankForRatio (juce::jmax (pitchRatio.getCurrentValue(),
+                                                                                 pitchRatio.getTargetValue()));
+
+        const int firstWrite = voice.writePosition;
+        bool readsOwnWrites = false;
+
+        const bool ratioSteady = ! pitchRatio.isSmoothing();
+        const auto steadyStep = toPhaseStep (pitchRatio.getTargetValue());
+
+        for (int i = 0; i < num; ++i)
+        {
+            dryScratch[i] = samples[start + i];
+
+            // The read head follows the write head through the line at the pitch ratio:
+            // faster when shifting up, slower when shifting down. Where it laps the write
+            // head, or is moved onto an onset, the output splices to other audio.
+            const float ratio = ratioSteady ? pitchRatio.getTargetValue() : pitchRatio.getNextValue();
+            const auto samplePosition = position + start + i;
+
+            if (const auto onset = transientDetector.getNextOnset(); onset >= 0 && samplePosition >= onset + dryDelay.getDelay())
+            {
+                int writePosition = firstWrite + i;
+                if (writePosition >= maxDelaySamples)
+                    writePosition -= maxDelaySamples;
+
+                voice.readPhase = getSplicePhase (writePosition, ratio, KernelType::numTaps);
+                transientDetector.popOnset();
+            }
+            else
+            {
+                voice.readPhase += ratioSteady ? steadyStep : toPhaseStep (ratio);
+
+                if (voice.readPhase >= lineLength)
+                    voice.readPhase -= lineLength;
+            }
+
+            // Each kernel reads its taps as one contiguous run; the guard region past
+            // the end of the line mirrors its start so this never has to wrap.
+            // The top 24 bits of the fraction convert to float exactly.
+            const int readPosInt = static_cast<int> (voice.readPhase >> 32);
+            fracScratch[i] = static_cast<float> ((voice.readPhase >> 8) & 0xffffffu) * (1.0f / 16777216.0f);
+
+            int firstTap = readPosInt - KernelType::tapsBefore;
+            if (firstTap < 0)
+                firstTap += maxDelaySamples;
+
+            firstTapScratch[i] = firstTap;
+
+            // While the read head crosses the write head, a tap can land on a slot
+            // written earlier in this sub-block, so those reads must stay in order
+            int distance = firstTap - firstWrite;
+            if (distance < 0)
+                distance += maxDelaySamples;
+
+            readsOwnWrites = readsOwnWrites || distance < num || distance > maxDelaySamples - KernelType::numTaps;
+        }
+
+        const float frozenRatio = pitchRatio.getCurrentValue();
+
+       #if NOCTAVE_COMPACT_HISTORY
+        // The kernels read floats, so decode the stretch of line this sub-block's taps cover
+        if (! readsOwnWrites)
+            readsOwnWrites = ! decodeWindow (delayData, num, KernelType::numTaps);
+
+        if (! readsOwnWrites)
+            readSubBlock (windowScratch, num, kernel);
+       #else
+        if (! readsOwnWrites)
+            readSubBlock (delayData, num, kernel);
+       #endif
+
+        for (int i = 0; i < num; ++i)
+        {
+           #if NOCTAVE_COMPACT_HISTORY
+            float output = wetScratch[i];
+
+            if (readsOwnWrites)
+            {
+                float taps[Interpolation::maxTaps];
+
+                for (int tap = 0, position = firstTapScratch[i]; tap < KernelType::numTaps; ++tap)
+                {
+                    taps[tap] = (float) delayData[position] * (1.0f / History::scale);
+
+                    if (++position == maxDelaySamples)
+                        position = 0;
+                }
+
+                output = kernel.read (taps, fracScratch[i]);
+            }
+           #else
+            const float output = readsOwnWrites ? kernel.read (delayData + firstTapScratch[i], fracScratch[i])
+                                                : wetScratch[i];
+           #endif
+            wetScratch[i] = output;
+
+            // The loop gain stays below 0.375, so the regeneration always dies away
+            // without clipping in the loop; the output limiter handles any peaks
+            const float feedbackContribution = output * feedbackAmount.getNextValue() * 0.75f;
+
+            if (freezeFading)
+                wetScratch[i] = output + (readFrozen (kernel, frozenRatio) - output) * freezeAmount.getNextValue();
+
+            // Frozen, the write head stays where the loop ends
+            if (frozen)
+                continue;
+
+            // Write input + feedback to delay buffer
+            const float delayInput = dryScratch[i] + feedbackContribution;
+
+           #if NOCTAVE_COMPACT_HISTORY
+            delayData[voice.writePosition] = (History::Sample) juce::jlimit (-32768, 32767, juce::roundToInt (delayInput * History::scale));
+           #else
+            delayData[voice.writePosition] = delayInput;
+
+            if (voice.writePosition < guardSamples)
+                delayData[voice.writePosition + maxDelaySamples] = delayInput;
+           #endif
+
+            // Update write position (always increments by 1)
+            if (++voice.writePosition >= maxDelaySamples)
+                voice.writePosition = 0;
+        }
+
+        // The dry part plays the lookahead late, in step with the steered wet part
+        dryDelay.process (dryScratch, num);
+        mixSubBlock (samples + start, num);
+    }
+}
+
+template <typename KernelType>
+void PitchShifter::processFrozen (float* samples, int numSamples, KernelType kernel) noexcept
+{
+    for (int start = 0; start < numSamples; start += subBlockSize)
+    {
+        const int num = juce::jmin (subBlockSize, numSamples - start);
+
+        if constexpr (std::is_same_v<KernelType, Interpolation::Sinc>)
+            kernel.bank = Interpolation::SincTable::getBankForRatio (juce::jmax (pitchRatio.getCurrentValue(),
+                                                                                 pitchRatio.getTargetValue()));
+
+        for (int i = 0; i < num; ++i)
+        {
+            dryScratch[i] = samples[start + i];
+            wetScratch[i] = readFrozen (kernel, pitchRatio.getNextValue());
+        }
+
+        dryDelay.process (dryScratch, num);
+        mixSubBlock (samples + start, num);
+    }
+
+    // Nothing is written, so there's nothing to feed back, but the ramp keeps time
+    feedbackAmount.skip (numSamples);
+}
+
+void PitchShifter::mixSubBlock (float* samples, int numSamples) noexcept
+{
+    // Unity-gain crossfade between dry and wet
+    if (mixAmount.isSmoothing())
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float mix = mixAmount.getNextValue();
+            samples[i] = dryScratch[i] * (1.0f - mix) + wetScratch[i] * mix;
+        }
+    }
+    else
+    {
+        const float mix = mixAmount.getTargetValue();
+        kernels->mix (samples, dryScratch, wetScratch, 1.0f - mix, mix, numSamples);
+    }
+}
+
+//==============================================================================
+void PitchShifter::captureLoop() noexcept
+{
+    // The newer half of the line, ending a kernel's width short of the write head so no tap
+    // reads past it. The other half takes the writes while the loop fades out.
+    loopLength = maxDelaySamples / 2;
+    loopStart = voices[0].writePosition - loopLength - Interpolation::maxTaps;
+
+    if (loopStart < 0)
+        loopStart += maxDelaySamples;
+
+    // Even, so the grains can sit exactly half a grain apart
+    grainLength = (loopLength / 6) & ~1;
+
+    const float ratio = pitchRatio.getTargetValue();
+    startGrain (grains[0], ratio);
+    startGrain (grains[1], ratio);
+    grains[1].age = grainLength / 2;
+}
+
+void PitchShifter::startGrain (Grain& grain, float ratio) noexcept
+{
+    // Anywhere in the loop the grain can play through without reaching the end, at this
+    // ratio or the one a glide under way is heading for
+    const double room = (double) loopLength - (double) grainLength * juce::jmax (ratio, pitchRatio.getTargetValue());
+
+    grain.offset = room > 0.0 ? grainRandom.nextDouble() * room : 0.0;
+    grain.age = 0;
+}
+
+template <typename KernelType>
+float PitchShifter::readFrozen (const KernelType& kernel, float ratio) noexcept
+{
+    // Half a grain apart, the grains' sin² windows always add up to one
+    const float fade = juce::square (std::sin (juce::MathConstants<float>::pi * (float) grains[0].age / (float) grainLength));
+    const float output = readLine (grains[0].offset, kernel) * fade + readLine (grains[1].offset, kernel) * (1.0f - fade);
+
+    // A grain swept up after it started can run out of loop. It holds at the end until its
+    // window closes rather than jump back to the start at full level.
+    const auto lastOffset = (double) (loopLength - 1);
+
+    for (auto& grain : grains)
+    {
+        grain.offset = juce::jmin (grain.offset + ratio, lastOffset);
+
+        if (++grain.age >= grainLength)
+            startGrain (grain, ratio);
+    }
+
+    return output;
+}
+
+template <typename KernelType>
+float PitchShifter::readLine (double loopOffset, const KernelType& kernel) const noexcept
+{
+    jassert (loopOffset >= 0.0 && loopOffset < (double) loopLength);
+
+    const double whole = std::floor (loopOffset);
+    int firstTap = loopStart + (int) whole - KernelType::tapsBefore;
+
+    if (firstTap >= maxDelaySamples)
+        firstTap -= maxDelaySamples;
+    else if (firstTap < 0)
+        firstTap += maxDelaySamples;
+
+   #if NOCTAVE_COMPACT_HISTORY
+    float taps[Interpolation::maxTaps];
+
+    for (int tap = 0, position = firstTap; tap < KernelType::numTaps; ++tap)
+    {
+        taps[tap] = (float) history->samples[(size_t) position] * (1.0f / History::scale);
+
+        if (++position == maxDelaySamples)
+            position = 0;
+    }
+
+    return kernel.read (taps, (float) (loopOffset - whole));
+   #else
+    // The guard region past the end mirrors the start, so the taps never wrap
+    return kernel.read (history->samples.data() + firstTap, (float) (loopOffset - whole));
+   #endif
+}
+
+template <typename KernelType>
+void PitchShifter::readSubBlock (const float* delayData, int numSamples, const KernelType& kernel) noexcept
+{
+    if constexpr (std::is_same_v<KernelType, Interpolation::Linear>)
+    {
+        kernels->interpolateLinear (delayData, firstTapScratch, fracScratch, wetScratch, numSamples);
+    }
+    else if constexpr (std::is_same_v<KernelType, Interpolation::Hermite>)
+    {
+        kernels->interpolateHermite (delayData, firstTapScratch, fracScratch, wetScratch, numSamples);
+    }
+    else if constexpr (std::is_same_v<KernelType, Interpolation::Lagrange>)
+    {
+        kernels->interpolateLagrange (delayData, firstTapScratch, fracScratch, wetScratch, numSamples);
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            int phase;
+            Interpolation::Sinc::getPhase (fracScratch[i], phase, phaseFracScratch[i]);
+            coefficientRowScratch[i] = Interpolation::SincTable::getRowOffset (kernel.bank, phase);
+        }
+
+        kernels->interpolateSinc (delayData, kernel.table.getData(), firstTapScratch,
+                                  coefficientRowScratch, phaseFracScratch, wetScratch, numSamples);
+    }
+
+    juce::ignoreUnused (kernel);
+}
+
+#if NOCTAVE_COMPACT_HISTORY
+bool PitchShifter::decodeWindow (const History::Sample* line, int numSamples, int numTaps) noexcept
+{
+    // Offsets from the first read, unwrapped where the head crosses the start of the line
+    const int origin = firstTapScratch[0];
+
+    const auto getOffset = [origin] (int firstTap)
+    {
+        const int offset = firstTap - origin;
+        return offset > maxDelaySamples / 2 ? offset - maxDelaySamples
+             : offset < -maxDelaySamples / 2 ? offset + maxDelaySamples
+             : offset;
+    };
+
+    int lowest = 0, highest = 0;
+
+    for (int i = 1; i < numSamples; ++i)
+    {
+        lowest = juce::jmin (lowest, getOffset (firstTapScratch[i]));
+        highest = juce::jmax (highest, getOffset (firstTapScratch[i]));
+    }
+
+    const int windowLength = highest - lowest + numTaps;
+
+    if (windowLength > windowSamples)
+        return false;
+
+    int position = origin + lowest;
+
+    if (position < 0)
+        position += maxDelaySamples;
+
+    for (int i = 0; i < windowLength; ++i)
+    {
+        windowScratch[i] = (float) line[position] * (1.0f / History::scale);
+
+        if (++position == maxDelaySamples)
+            position = 0;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        firstTapScratch[i] = getOffset (firstTapScratch[i]) - lowest;
+
+    return true;
+}
+#endif
@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    PitchShifter.h
+    Delay-line pitch shifter used for both the main shift and the harmonizer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Interpolation.h"
+#include "DspKernels.h"
+#include "TransientDetector.h"
+
+// Stores delay history as 16-bit integers instead of floats when the build defines
+// NOCTAVE_COMPACT_HISTORY=1: half the memory, at a noise floor near -89 dBFS
+#ifndef NOCTAVE_COMPACT_HISTORY
+ #define NOCTAVE_COMPACT_HISTORY 0
+#endif
+
+//==============================================================================
+// Pitch shifter implementation using delay-based approach
+class PitchShifter
+{
+public:
+    //==============================================================================
+    /** One shifter's delay line. Big enough to matter, so a shifter that's only needed
+        now and then can be given one when it's switched on and hand it back after.
+    */
+    class History
+    {
+    public:
+        History();
+
+        void clear() noexcept;
+
+       #if NOCTAVE_COMPACT_HISTORY
+        // Fixed point with 12 dB of headroom over full scale, for the feedback to build into
+        using Sample = juce::int16;
+        static constexpr float scale = 8192.0f;
+       #else
+        using Sample = float;
+       #endif
+
+        std::vector<Sample> samples;
+
+        JUCE_DECLARE_NON_COPYABLE (History)
+    };
+
+    //==============================================================================
+    /** Gets the shifter ready to run. A shifter with no history is given one, unless
+        allocateHistory is false and the caller supplies it with exchangeHistory().
+    */
+    void prepare (double sampleRate, int maxBlockSize, bool allocateHistory = true);
+
+    /** Clears the delay line. The next block then continues as if samplePosition samples had
+        already gone through at the next block's settings. Once getWarmUpSamples() more
+        have gone through, the output matches a continuous render sample for sample,
+        whatever the block sizes.
+    */
+    void reset (juce::int64 samplePosition = 0);
+
+    /** Pre-roll needed after reset (samplePosition) before the output is exact. Feedback
+        keeps old input circulating, so it needs enough passes round the line to decay away.
+    */
+    static int getWarmUpSamples (float feedback) noexcept;
+
+    void processBlock (juce::AudioBuffer<float>& buffer, float pitchShiftSemitones, float mix, float feedback);
+
+    /** Samples pitch, mix and feedback take to glide to a new setting. Zero keeps the
+        default glide; a modulated setting glides over one modulation grid step.
+    */
+    void setGlide (int pitchSamples, int mixSamples, int feedbackSamples) noexcept;
+
+    /** Swaps in a different delay line, or none, and returns the old one without freeing it,
+        so this can be called on the audio thread. Without a line the shifter outputs only
+        its dry part. A new History starts silent.
+    */
+    std::unique_ptr<History> exchangeHistory (std::unique_ptr<History> newHistory) noexcept;
+    bool hasHistory() const noexcept                                   { return history != nullptr; }
+
+    /** Memory one delay line takes. */
+    static size_t getHistorySizeInBytes() noexcept;
+
+    /** Range of lookaheads setLookahead() takes. An onset is only known once its hop
+        is complete, so the shortest covers two hops.
+    */
+    static constexpr double maxLookaheadSeconds = 0.01;
+    static constexpr int minLookaheadSamples = 2 * TransientDetector::hopSize;
+
+    /** Holds the dry signal back by numSamples, and uses that time to see onsets coming
+        and splice the read head onto each one, so attacks play from their start and no
+        splice lands inside one. 0 turns it off and adds no latency.
+    */
+    void setLookahead (int numSamples) noexcept;
+    int getLookahead() const noexcept                                  { return dryDelay.getDelay(); }
+
+    /** Freezes the sound in the delay line. Writing stops, and the newer half of the
+        line loops as two overlapping grains read straight from the line, each
+        crossfaded into the next at a random point, so the loop has no seam. The
+        grains read at the pitch ratio, so a frozen pad can still be swept. Input
+        detection and feedback stop while frozen. The dry signal still plays through
+        the lookahead delay and the mix, so Mix below 100% keeps working.
+    */
+    void setFreeze (bool shouldFreeze) noexcept;
+    bool isFrozen() const noexcept                                     { return frozen; }
+
+    /** Selects the kernel used to read between delay-line samples. */
+    void setInterpolation (Interpolation::Kernel newKernel) noexcept   { interpolation = newKernel; }
+    Interpolation::Kernel getInterpolation() const noexcept            { return interpolation; }
+
+private:
+    static constexpr int maxDelaySamples = 44100; // 1 second at 44.1kHz
+
+    // Samples mirrored past the end of the delay line so kernel taps never wrap
+    static constexpr int guardSamples = Interpolation::maxTaps;
+
+    // Samples whose delay-line reads are gathered and handed to the kernels together
+    static constexpr int subBlockSize = 64;
+
+   #if NOCTAVE_COMPACT_HISTORY
+    // Compact history is decoded a sub-block's span at a time. Pitch tops out at two
+    // octaves up, so the read head covers at most 4 samples per sample.
+    static constexpr int windowSamples = 5 * subBlockSize + Interpolation::maxTaps;
+   #endif
+
+    // Read positions are fixed point with 32 fractional bits, so the read head moves
+    // by exactly the same steps however the audio is split into blocks
+    static constexpr juce::uint64 lineLength = (juce::uint64) maxDelaySamples << 32;
+
+    struct Voice
+    {
+        int writePosition = 0;
+        juce::uint64 readPhase = 0;
+    };
+
+    static juce::uint64 toPhaseStep (float ratio) noexcept;
+    void positionVoice (juce::int64 samplePosition, float ratio) noexcept;
+    juce::uint64 getSplicePhase (int writePosition, float ratio, int numTaps) const noexcept;
+
+    template <typename KernelType>
+    void processSamples (float* samples, int numSamples, KernelType kernel) noexcept;
+
+    template <typename KernelType>
+    void processFrozen (float* samples, int numSamples, KernelType kernel) noexcept;
+
+    template <typename KernelType>
+    float readFrozen (const KernelType& kernel, float ratio) noexcept;
+
+    template <typename KernelType>
+    float readLine (double loopOffset, const KernelType& kernel) const noexcept;
+
+    struct Grain
+    {
+        double offset = 0.0;    // Read position from the start of the loop
+        int age = 0;
+    };
+
+    void captureLoop() noexcept;
+    void startGrain (Grain& grain, float ratio) noexcept;
+    void mixSubBlock (float* samples, int numSamples) noexcept;
+
+    template <typename KernelType>
+    void readSubBlock (const float* delayData, int numSamples, const KernelType& kernel) noexcept;
+
+   #if NOCTAVE_COMPACT_HISTORY
+    bool decodeWindow (const History::Sample* line, int numSamples, int numTaps) noexcept;
+   #endif
+
+    Voice voices[1]; // Single voice for pitch shifting
+    std::unique_ptr<History> history;
+    double currentSampleRate = 44100.0;
+
+    // Per-sample ramps, so parameter and program changes glide without clicks
+    // and start at exactly the sample they arrive on
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> pitchRatio;
+    juce::SmoothedValue<float> mixAmount, feedbackAmount;
+    int pitchGlide = 0, mixGlide = 0, feedbackGlide = 0;
+    bool snapToTargets = true;
+    juce::int64 startPosition = 0; // Applied with the first block after a reset
+    juce::int64 position = 0;      // Input samples since the start, for placing splices
+    Interpolation::Kernel interpolation = Interpolation::Kernel::hermite;
+    const DspKernels::Table* kernels = &DspKernels::getActive();
+
+    // Onsets are found in the input as it's written to the line, and the dry signal
+    // runs the lookahead behind it
+    TransientDetector transientDetector;
+    LookaheadDelay dryDelay;
+    int transientHold = 0;
+
+    // Freeze loops a stretch of the line, fading over from the live read head as it engages
+    bool frozen = false, captureNeeded = false;
+    int loopStart = 0, loopLength = 0, grainLength = 0;
+    Grain grains[2];
+    juce::SmoothedValue<float> freezeAmount;
+    juce::Random grainRandom;
+
+    // Per-sub-block scratch, filled with read positions before the batched read
+    float dryScratch[subBlockSize];
+    float wetScratch[subBlockSize];
+    float fracScratch[subBlockSize];
+    float phaseFracScratch[subBlockSize];
+    int firstTapScratch[subBlockSize];
+    int coefficientRowScratch[subBlockSize];
+   #if NOCTAVE_COMPACT_HISTORY
+    float windowScratch[windowSamples];
+   #endif
+};
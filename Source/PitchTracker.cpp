@@ -0,0 +1,343 @@
+/*
+  ==============================================================================
+
+    PitchTracker.cpp
+    Realtime pitch tracking and key detection on a decimated copy of the input.
+
+  ==============================================================================
+*/
+
+#include "PitchTracker.h"
+#include "RealtimeChecks.h"
+
+namespace
+{
+    constexpr double targetAnalysisRate = 11025.0;
+
+    constexpr float lowestPitchHz = 60.0f;
+    constexpr float highestPitchHz = 1500.0f;
+
+    // Same YIN thresholds as the offline analysis
+    constexpr float pitchThreshold = 0.15f;
+    constexpr float voicingThreshold = 0.35f;
+    constexpr float silenceMeanSquare = 1.0e-6f;
+
+    // Range folded into the chromagram, and how long it remembers
+    constexpr double lowestChromaHz = 80.0;
+    constexpr double highestChromaHz = 2000.0;
+    constexpr double chromaMemorySeconds = 8.0;
+
+    // Listen this long before naming a key, and switch only for a clearly better one
+    constexpr double keySettleSeconds = 2.0;
+    constexpr float keySwitchMargin = 0.05f;
+
+    // Krumhansl-Kessler probe-tone profiles, from the tonic up
+    constexpr std::array<float, 12> majorProfile { 6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f };
+    constexpr std::array<float, 12> minorProfile { 6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f };
+
+    // Pearson correlation of the chromagram with a profile rotated onto root
+    float correlate (const std::array<float, 12>& chroma, const std::array<float, 12>& profile, int root) noexcept
+    {
+        float chromaMean = 0.0f, profileMean = 0.0f;
+
+        for (int i = 0; i < 12; ++i)
+        {
+            chromaMean += chroma[(size_t) i];
+            profileMean += profile[(size_t) i];
+        }
+
+        chromaMean /= 12.0f;
+        profileMean /= 12.0f;
+
+        float product = 0.0f, chromaSquares = 0.0f, profileSquares = 0.0f;
+
+        for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+        {
+            const float c = chroma[(size_t) pitchClass] - chromaMean;
+            const float p = profile[(size_t) ((pitchClass - root + 12) % 12)] - profileMean;
+            product += c * p;
+            chromaSquares += c * c;
+            profileSquares += p * p;
+        }
+
+        const float norm = std::sqrt (chromaSquares * profileSquares);
+        return norm > 0.0f ? product / norm : 0.0f;
+    }
+}
+
+//==============================================================================
+void PitchTracker::Biquad::setLowPass (double sampleRate, double frequency, double q) noexcept
+{
+    const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const double alpha = std::sin (omega) / (2.0 * q);
+    const double cosine = std::cos (omega);
+    const double a0 = 1.0 + alpha;
+
+    b0 = b2 = (float) ((1.0 - cosine) * 0.5 / a0);
+    b1 = (float) ((1.0 - cosine) / a0);
+    a1 = (float) (-2.0 * cosine / a0);
+    a2 = (float) ((1.0 - alpha) / a0);
+}
+
+//==============================================================================
+PitchTracker::PitchTracker()
+    : frame ((size_t) chromaFrameSize),
+      fftBuffer ((size_t) chromaFrameSize * 2),
+      energies ((size_t) pitchFrameSize + 1),
+      chromaWindow ((size_t) chromaFrameSize),
+      binPitchClasses ((size_t) chromaFrameSize / 2 + 1, -1)
+{
+}
+
+void PitchTracker::prepare (double sampleRate)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    decimation = juce::jmax (1, (int) (sampleRate / targetAnalysisRate));
+    analysisRate = sampleRate / decimation;
+
+    // Fourth-order Butterworth well under the decimated Nyquist
+    antiAliasing[0].setLowPass (sampleRate, 0.2 * analysisRate, 0.5412);
+    antiAliasing[1].setLowPass (sampleRate, 0.2 * analysisRate, 1.3066);
+
+    minLag = juce::jmax (2, (int) std::floor (analysisRate / highestPitchHz));
+    maxLag = juce::jmin (pitchFrameSize / 2, (int) std::ceil (analysisRate / lowestPitchHz));
+    difference.assign ((size_t) maxLag + 2, 1.0f);
+
+    for (int i = 0; i < chromaFrameSize; ++i)
+        chromaWindow[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) chromaFrameSize);
+
+    for (size_t bin = 1; bin < binPitchClasses.size(); ++bin)
+    {
+        const double frequency = (double) bin * analysisRate / chromaFrameSize;
+
+        binPitchClasses[bin] = frequency >= lowestChromaHz && frequency <= highestChromaHz
+                                 ? (juce::roundToInt (12.0 * std::log2 (frequency / 440.0)) + 9 + 120) % 12
+                                 : -1;
+    }
+
+    chromaDecay = (float) std::exp (-chromaHopSize / (chromaMemorySeconds * analysisRate));
+    reset();
+}
+
+void PitchTracker::reset() noexcept
+{
+    for (auto& filter : antiAliasing)
+        filter.z1 = filter.z2 = 0.0f;
+
+    history.fill (0.0f);
+    chromagram.fill (0.0f);
+    writePosition = decimationPhase = 0;
+    pitchHopFill = chromaHopFill = chromaFramesHeard = 0;
+    pitch = 0.0f;
+    hasKey = false;
+}
+
+bool PitchTracker::getKey (Key& result) const noexcept
+{
+    if (hasKey)
+        result = key;
+
+    return hasKey;
+}
+
+void PitchTracker::process (const float* input, int numSamples, bool detectKey) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float filtered = antiAliasing[1].process (antiAliasing[0].process (input[i]));
+
+        if (++decimationPhase < decimation)
+            continue;
+
+        decimationPhase = 0;
+        history[(size_t) writePosition] = filtered;
+        writePosition = (writePosition + 1) & (historySize - 1);
+        ++pitchHopFill;
+        ++chromaHopFill;
+    }
+
+    // One frame of each at most, on the newest input, so a long block costs no more
+    if (pitchHopFill >= pitchHopSize)
+    {
+        pitchHopFill %= pitchHopSize;
+        detectPitch();
+    }
+
+    if (chromaHopFill >= chromaHopSize)
+    {
+        chromaHopFill %= chromaHopSize;
+
+        if (detectKey)
+            updateChromagram();
+    }
+}
+
+void PitchTracker::copyNewest (float* destination, int numSamples) const noexcept
+{
+    const int start = (writePosition - numSamples) & (historySize - 1);
+    const int firstPart = juce::jmin (numSamples, historySize - start);
+
+    std::copy (history.begin() + start, history.begin() + start + firstPart, destination);
+    std::copy (history.begin(), history.begin() + (numSamples - firstPart), destination + firstPart);
+}
+
+void PitchTracker::detectPitch() noexcept
+{
+    constexpr int fftSize = 1 << pitchOrder;
+
+    copyNewest (frame.data(), pitchFrameSize);
+
+    energies[0] = 0.0f;
+
+    for (int i = 0; i < pitchFrameSize; ++i)
+        energies[(size_t) i + 1] = energies[(size_t) i] + frame[(size_t) i] * frame[(size_t) i];
+
+    const float totalEnergy = energies[(size_t) pitchFrameSize];
+
+    if (totalEnergy < silenceMeanSquare * (float) pitchFrameSize)
+    {
+        pitch = 0.0f;
+        return;
+    }
+
+    // Autocorrelation through the FFT, zero-padded so it doesn't wrap
+    std::fill (fftBuffer.begin(), fftBuffer.begin() + 2 * fftSize, 0.0f);
+    std::copy (frame.begin(), frame.begin() + pitchFrameSize, fftBuffer.begin());
+
+    pitchFFT.performRealOnlyForwardTransform (fftBuffer.data());
+
+    for (int bin = 0; bin < fftSize; ++bin)
+    {
+        const float re = fftBuffer[(size_t) bin * 2];
+        const float im = fftBuffer[(size_t) bin * 2 + 1];
+        fftBuffer[(size_t) bin * 2] = re * re + im * im;
+        fftBuffer[(size_t) bin * 2 + 1] = 0.0f;
+    }
+
+    pitchFFT.performRealOnlyInverseTransform (fftBuffer.data());
+
+    // Lag 0 is the frame's energy, which pins down the transform's scaling
+    const float scale = fftBuffer[0] > 0.0f ? totalEnergy / fftBuffer[0] : 0.0f;
+
+    // Mean squared difference at each lag, then YIN's cumulative mean normalisation
+    float runningSum = 0.0f;
+    difference[0] = 1.0f;
+
+    for (int lag = 1; lag <= maxLag; ++lag)
+    {
+        const float overlapEnergy = energies[(size_t) (pitchFrameSize - lag)]
+                                  + (totalEnergy - energies[(size_t) lag]);
+        const float squaredDifference = juce::jmax (0.0f, overlapEnergy - 2.0f * scale * fftBuffer[(size_t) lag]);
+        const float meanDifference = squaredDifference / (float) (pitchFrameSize - lag);
+
+        runningSum += meanDifference;
+        difference[(size_t) lag] = runningSum > 0.0f ? meanDifference * (float) lag / runningSum : 1.0f;
+    }
+
+    int bestLag = -1;
+
+    for (int lag = minLag; lag < maxLag; ++lag)
+    {
+        if (difference[(size_t) lag] < pitchThreshold)
+        {
+            while (lag + 1 < maxLag && difference[(size_t) lag + 1] < difference[(size_t) lag])
+                ++lag;
+
+            bestLag = lag;
+            break;
+        }
+    }
+
+    if (bestLag < 0)
+    {
+        bestLag = minLag;
+
+        for (int lag = minLag + 1; lag < maxLag; ++lag)
+            if (difference[(size_t) lag] < difference[(size_t) bestLag])
+                bestLag = lag;
+
+        if (difference[(size_t) bestLag] > voicingThreshold)
+        {
+            pitch = 0.0f;
+            return;
+        }
+    }
+
+    // Parabolic interpolation around the dip for a sub-sample period
+    const float before = difference[(size_t) bestLag - 1];
+    const float at = difference[(size_t) bestLag];
+    const float after = difference[(size_t) bestLag + 1];
+    const float curvature = before - 2.0f * at + after;
+    const float shift = curvature > 0.0f ? juce::jlimit (-0.5f, 0.5f, 0.5f * (before - after) / curvature) : 0.0f;
+
+    pitch = (float) (analysisRate / ((double) bestLag + shift));
+}
+
+void PitchTracker::updateChromagram() noexcept
+{
+    copyNewest (frame.data(), chromaFrameSize);
+
+    std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+
+    for (int i = 0; i < chromaFrameSize; ++i)
+        fftBuffer[(size_t) i] = frame[(size_t) i] * chromaWindow[(size_t) i];
+
+    chromaFFT.performFrequencyOnlyForwardTransform (fftBuffer.data(), true);
+
+    std::array<float, 12> frameChroma {};
+    float total = 0.0f;
+
+    for (size_t bin = 0; bin < binPitchClasses.size(); ++bin)
+    {
+        if (binPitchClasses[bin] >= 0)
+        {
+            frameChroma[(size_t) binPitchClasses[bin]] += fftBuffer[bin];
+            total += fftBuffer[bin];
+        }
+    }
+
+    // Silence leaves the key as it was rather than fading it out
+    if (total < 1.0e-3f)
+        return;
+
+    // Each frame counts the same however loud, so the key follows the notes, not the dynamics
+    for (int pitchClass = 0; pitchClass < 12; ++pitchClass)
+        chromagram[(size_t) pitchClass] = chromagram[(size_t) pitchClass] * chromaDecay + frameChroma[(size_t) pitchClass] / total;
+
+    ++chromaFramesHeard;
+    updateKey();
+}
+
+void PitchTracker::updateKey() noexcept
+{
+    if (chromaFramesHeard < (int) (keySettleSeconds * analysisRate / chromaHopSize))
+        return;
+
+    Key best;
+    float bestScore = -2.0f;
+    float currentScore = -2.0f;
+
+    for (int root = 0; root < 12; ++root)
+    {
+        for (const bool isMinor : { false, true })
+        {
+            const float score = correlate (chromagram, isMinor ? minorProfile : majorProfile, root);
+
+            if (score > bestScore)
+            {
+                bestScore = score;
+                best = { root, isMinor };
+            }
+
+            if (hasKey && root == key.root && isMinor == key.isMinor)
+                currentScore = score;
+        }
+    }
+
+    if (! hasKey || bestScore > currentScore + keySwitchMargin)
+    {
+        key = best;
+        hasKey = true;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    PitchTracker.h
+    Realtime pitch tracking and key detection on a decimated copy of the input.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/**
+    Tracks the pitch of a live monophonic input and, optionally, the key it's
+    in, cheaply enough to run on the audio thread.
+
+    The input is low-passed and decimated to around 11 kHz, which is plenty for
+    fundamentals up to 1.5 kHz and keyboard-range chroma. Pitch comes from
+    YIN on the newest 512 decimated samples every 128, with the autocorrelation
+    done through an FFT as in the offline SourceAnalyser.
+
+    The key comes from a chromagram. Every 512 decimated samples a windowed
+    2048-point FFT of the newest input is folded into the 12 pitch classes, and
+    that frame is added to a running chromagram that decays exponentially, so
+    each update costs one frame however long the tracker has been listening.
+    The chromagram is compared with the 24 rotated Krumhansl-Kessler key
+    profiles, and a new key has to correlate clearly better than the current one
+    before it takes over.
+
+    However long the block, a call to process() analyses at most one pitch frame
+    and one chroma frame, on the newest input; frames that fell due earlier in a
+    long block are skipped. Nothing is allocated after prepare().
+*/
+class PitchTracker
+{
+public:
+    struct Key
+    {
+        int root = 0;       // Pitch class of the tonic, 0 = C
+        bool isMinor = false;
+    };
+
+    PitchTracker();
+
+    void prepare (double sampleRate);
+    void reset() noexcept;
+
+    /** Feeds input; the chromagram is only updated with detectKey on. */
+    void process (const float* input, int numSamples, bool detectKey) noexcept;
+
+    /** Fundamental of the newest frame in Hz, or 0 if it was unvoiced. */
+    float getPitch() const noexcept     { return pitch; }
+
+    /** The key so far, or false until enough has been heard to tell. */
+    bool getKey (Key& result) const noexcept;
+
+private:
+    static constexpr int pitchFrameSize = 512;
+    static constexpr int pitchHopSize = 128;
+    static constexpr int pitchOrder = 10;                  // room for the linear autocorrelation of a frame
+    static constexpr int chromaOrder = 11;
+    static constexpr int chromaFrameSize = 1 << chromaOrder;
+    static constexpr int chromaHopSize = 512;
+    static constexpr int historySize = chromaFrameSize;    // power of two, holds the longest frame
+
+    struct Biquad
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        float z1 = 0.0f, z2 = 0.0f;
+
+        void setLowPass (double sampleRate, double frequency, double q) noexcept;
+
+        float process (float input) noexcept
+        {
+            const float output = b0 * input + z1;
+            z1 = b1 * input - a1 * output + z2;
+            z2 = b2 * input - a2 * output;
+            return output;
+        }
+    };
+
+    void copyNewest (float* destination, int numSamples) const noexcept;
+    void detectPitch() noexcept;
+    void updateChromagram() noexcept;
+    void updateKey() noexcept;
+
+    double analysisRate = 11025.0;
+    int decimation = 4, decimationPhase = 0;
+    std::array<Biquad, 2> antiAliasing;
+
+    std::array<float, historySize> history {};
+    int writePosition = 0;
+    int pitchHopFill = 0, chromaHopFill = 0;
+    int chromaFramesHeard = 0;
+
+    juce::dsp::FFT pitchFFT { pitchOrder };
+    juce::dsp::FFT chromaFFT { chromaOrder };
+    std::vector<float> frame, fftBuffer, energies, difference, chromaWindow;
+    std::vector<int> binPitchClasses;   // -1 for bins outside the chroma range
+    int minLag = 8, maxLag = 200;
+
+    float pitch = 0.0f;
+    float chromaDecay = 0.0f;
+    std::array<float, 12> chromagram {};
+    Key key;
+    bool hasKey = false;
+};
@@ -8,26 +8,289 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "ChunkRenderer.h"
+
+namespace
+{
+    // Renders a file with the current settings in parallel chunks and writes the
+    // result beside it, then reports the speed and how the chunks compare with a
+    // single pass. Deletes itself when it's done.
+    class RenderFileTask  : public juce::ThreadWithProgressWindow
+    {
+    public:
+        RenderFileTask (NoctaveAudioProcessor& processor, const juce::File& file)
+            : juce::ThreadWithProgressWindow ("Rendering " + file.getFileName(), true, true),
+              inputFile (file)
+        {
+            formatManager.registerBasicFormats();
+            reader.reset (formatManager.createReaderFor (inputFile));
+
+            if (reader == nullptr || reader->numChannels < 1 || reader->numChannels > 2)
+                return;
+
+            // The instances belong on the message thread, so they're made here rather than in run()
+            juce::MemoryBlock state;
+            processor.getStateInformation (state);
+            renderer = std::make_unique<ChunkRenderer> (state, reader->sampleRate, (int) reader->numChannels);
+        }
+
+        void run() override
+        {
+            if (renderer == nullptr)
+            {
+                result = "Couldn't open " + inputFile.getFileName() + " as mono or stereo audio.";
+                return;
+            }
+
+            if (reader->lengthInSamples > std::numeric_limits<int>::max())
+            {
+                result = inputFile.getFileName() + " is too long to render in one go.";
+                return;
+            }
+
+            setStatusMessage ("Reading...");
+            juce::AudioBuffer<float> audio ((int) reader->numChannels, (int) reader->lengthInSamples);
+            reader->read (&audio, 0, audio.getNumSamples(), 0, true, true);
+
+            setStatusMessage ("Rendering in one pass for comparison...");
+            const auto report = renderer->render (audio, true, [this] (double progress)
+            {
+                setStatusMessage ("Rendering in chunks...");
+                setProgress (progress);
+                return ! threadShouldExit();
+            });
+
+            if (threadShouldExit())
+                return;
+
+            setStatusMessage ("Writing...");
+            const auto outputFile = inputFile.getSiblingFile (inputFile.getFileNameWithoutExtension() + " (Noctave).wav")
+                                             .getNonexistentSibling();
+            auto stream = std::make_unique<juce::FileOutputStream> (outputFile);
+            std::unique_ptr<juce::AudioFormatWriter> writer;
+
+            // 32-bit float, so the comparison above still holds for the file
+            if (stream->openedOk())
+                writer.reset (juce::WavAudioFormat().createWriterFor (stream.get(), reader->sampleRate,
+                                                                      (unsigned int) audio.getNumChannels(), 32, {}, 0));
+
+            if (writer != nullptr)
+                stream.release(); // Owned by the writer now
+
+            if (writer == nullptr || ! writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples()))
+            {
+                result = "Couldn't write " + outputFile.getFileName() + ".";
+                return;
+            }
+
+            result = report.toString (audio.getNumSamples() / reader->sampleRate)
+                       + "\nWritten to " + outputFile.getFileName() + ".";
+        }
+
+        void threadComplete (bool userPressedCancel) override
+        {
+            renderer.reset();
+
+            if (! userPressedCancel)
+                juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::InfoIcon, "Render", result);
+
+            delete this;
+        }
+
+    private:
+        juce::File inputFile;
+        juce::AudioFormatManager formatManager;
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        std::unique_ptr<ChunkRenderer> renderer;
+        juce::String result;
+    };
+}
 
 //==============================================================================
 NoctaveAudioProcessorEditor::NoctaveAudioProcessorEditor (NoctaveAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
-    // Set editor size
-    setSize (800, 600);
+    setLookAndFeel (&lookAndFeel);
+    setOpaque (true);
+
+    // Only the content component takes clicks; the editor under it just paints the background
+    content.setInterceptsMouseClicks (false, true);
+    content.setSize (designWidth, designHeight);
+    addAndMakeVisible (content);
+
+    // Freely resizable, keeping the design's proportions
+    setResizable (true, true);
+    setResizeLimits (designWidth / 2, designHeight / 2, designWidth * 2, designHeight * 2);
+    getConstrainer()->setFixedAspectRatio ((double) designWidth / (double) designHeight);
+    setSize (designWidth, designHeight);
 
     // Setup sliders
     setupSlider (pitchShiftSlider, pitchShiftLabel, "Pitch Shift");
     setupSlider (mixSlider, mixLabel, "Mix");
     setupSlider (feedbackSlider, feedbackLabel, "Feedback");
     setupSlider (harmonizerSlider, harmonizerLabel, "Harmonizer");
+    setupSlider (ceilingSlider, ceilingLabel, "Ceiling");
+    setupSlider (releaseSlider, releaseLabel, "Release");
+    setupSlider (transientSlider, transientLabel, "Transients");
+    setupSlider (retuneSpeedSlider, retuneSpeedLabel, "Retune Speed");
+    setupSlider (humaniseSlider, humaniseLabel, "Humanise");
+    setupSlider (lfoDepthSlider, lfoLabel, "LFO");
+    setupSlider (envelopeDepthSlider, envelopeLabel, "Envelope");
+    setupSlider (randomDepthSlider, randomLabel, "Random");
+
+    // The limiter, correction and modulation settings are set-and-forget, so they get compact bars
+    for (auto* slider : { &ceilingSlider, &releaseSlider, &transientSlider, &retuneSpeedSlider, &humaniseSlider,
+                          &lfoDepthSlider, &envelopeDepthSlider, &randomDepthSlider })
+    {
+        slider->setSliderStyle (juce::Slider::LinearHorizontal);
+        slider->setTextBoxStyle (juce::Slider::TextBoxRight, false, 70, 22);
+    }
+
+    for (auto* label : { &ceilingLabel, &releaseLabel, &transientLabel, &retuneSpeedLabel, &humaniseLabel,
+                         &lfoLabel, &envelopeLabel, &randomLabel })
+        label->setFont (juce::Font (16.0f, juce::Font::bold));
+
+    // Depth bars share their column with the target selector, and the lookahead sits under
+    // the harmonizer knob, so their value boxes are narrower
+    for (auto* slider : { &transientSlider, &lfoDepthSlider, &envelopeDepthSlider, &randomDepthSlider })
+        slider->setTextBoxStyle (juce::Slider::TextBoxRight, false, 45, 22);
+
+    // Setup mode selectors
+    setupComboBox (interpolationBox, interpolationLabel, "Interpolation", "INTERPOLATION");
+    setupComboBox (engineBox, engineLabel, "Engine", "ENGINE");
+    setupComboBox (polyBandsBox, polyBandsLabel, "Poly Bands", "POLY_BANDS");
+    setupComboBox (stereoModeBox, stereoModeLabel, "Stereo Mode", "STEREO_MODE");
+    setupComboBox (harmonyModeBox, harmonyModeLabel, "Harmony Mode", "HARMONY_MODE");
+    setupComboBox (keyBox, keyLabel, "Key", "KEY");
+    setupComboBox (scaleBox, scaleLabel, "Scale", "SCALE");
+    setupComboBox (correctionBox, correctionLabel, "Correction", "CORRECTION");
+
+    // Poly Offload shares the band selector's label row
+    polyOffloadButton.setColour (juce::ToggleButton::textColourId, vampireText);
+    polyOffloadButton.setColour (juce::ToggleButton::tickColourId, vampireRed);
+    polyOffloadButton.setColour (juce::ToggleButton::tickDisabledColourId, vampireGray);
+    content.addAndMakeVisible (&polyOffloadButton);
+    parameterPoller.attach (polyOffloadButton, "POLY_OFFLOAD");
+
+    // Freeze sits under the feedback knob, the other way of holding a sound
+    freezeButton.setColour (juce::ToggleButton::textColourId, vampireText);
+    freezeButton.setColour (juce::ToggleButton::tickColourId, vampireRed);
+    freezeButton.setColour (juce::ToggleButton::tickDisabledColourId, vampireGray);
+    content.addAndMakeVisible (&freezeButton);
+    parameterPoller.attach (freezeButton, "FREEZE");
+
+    // Modulation routing - the source names above each column label them
+    attachComboBox (lfoShapeBox, "MOD_LFO_SHAPE");
+    attachComboBox (lfoRateBox, "MOD_LFO_RATE");
+    attachComboBox (lfoTargetBox, "MOD_LFO_TARGET");
+    attachComboBox (envelopeTargetBox, "MOD_ENV_TARGET");
+    attachComboBox (randomRateBox, "MOD_RANDOM_RATE");
+    attachComboBox (randomTargetBox, "MOD_RANDOM_TARGET");
+
+    // Step sequencer
+    sequencerButton.setColour (juce::ToggleButton::textColourId, vampireText);
+    sequencerButton.setColour (juce::ToggleButton::tickColourId, vampireRed);
+    sequencerButton.setColour (juce::ToggleButton::tickDisabledColourId, vampireGray);
+    content.addAndMakeVisible (&sequencerButton);
+    parameterPoller.attach (sequencerButton, "SEQ_ON");
+
+    attachComboBox (sequencerRateBox, "SEQ_RATE");
+
+    setupSlider (sequencerLengthSlider, sequencerLengthLabel, "Steps");
+    sequencerLengthSlider.setSliderStyle (juce::Slider::LinearHorizontal);
+    sequencerLengthSlider.setTextBoxStyle (juce::Slider::TextBoxRight, false, 35, 22);
+    sequencerLengthLabel.setFont (juce::Font (16.0f, juce::Font::bold));
+
+    sequencerLaneBox.addItemList ({ "Pitch", "Harmony" }, 1);
+    sequencerLaneBox.setSelectedId (1, juce::dontSendNotification);
+    sequencerLaneBox.setColour (juce::ComboBox::backgroundColourId, vampireBlack);
+    sequencerLaneBox.setColour (juce::ComboBox::textColourId, vampireText);
+    sequencerLaneBox.setColour (juce::ComboBox::outlineColourId, vampireGray);
+    sequencerLaneBox.setColour (juce::ComboBox::arrowColourId, vampireRed);
+    sequencerLaneBox.onChange = [this] { attachStepSliders(); };
+    content.addAndMakeVisible (&sequencerLaneBox);
+
+    for (auto& slider : stepSliders)
+    {
+        slider.setSliderStyle (juce::Slider::LinearBarVertical);
+        slider.setTextBoxStyle (juce::Slider::TextBoxBelow, false, 40, 20);
+        slider.setColour (juce::Slider::trackColourId, vampireCrimson);
+        slider.setColour (juce::Slider::textBoxTextColourId, vampireText);
+        slider.setColour (juce::Slider::textBoxBackgroundColourId, vampireBlack);
+        slider.setColour (juce::Slider::textBoxOutlineColourId, vampireGray);
+        content.addAndMakeVisible (&slider);
+    }
+
+    attachStepSliders();
+
+    // Program selector
+    programBox.setColour (juce::ComboBox::backgroundColourId, vampireBlack);
+    programBox.setColour (juce::ComboBox::textColourId, vampireText);
+    programBox.setColour (juce::ComboBox::outlineColourId, vampireGray);
+    programBox.setColour (juce::ComboBox::arrowColourId, vampireRed);
+    programBox.onChange = [this]
+    {
+        const auto index = programBox.getSelectedItemIndex();
+
+        if (index >= 0 && index != audioProcessor.getCurrentProgram())
+            audioProcessor.setCurrentProgram (index);
+    };
+    content.addAndMakeVisible (&programBox);
+
+    savePresetButton.setColour (juce::TextButton::buttonColourId, vampireDark);
+    savePresetButton.setColour (juce::TextButton::textColourOffId, vampireText);
+    savePresetButton.onClick = [this]
+    {
+        const auto& bank = audioProcessor.getPresetBank();
+        const auto userNumber = bank.getNumPresets() - bank.getNumFactoryPresets() + 1;
+
+        if (audioProcessor.saveCurrentAsUserPreset ("User " + juce::String (userNumber)) >= 0)
+            refreshProgramBox();
+    };
+    content.addAndMakeVisible (&savePresetButton);
+
+    // Offline render of a whole file, split across cores
+    renderFileButton.setColour (juce::TextButton::buttonColourId, vampireDark);
+    renderFileButton.setColour (juce::TextButton::textColourOffId, vampireText);
+    renderFileButton.onClick = [this]
+    {
+        renderFileChooser = std::make_unique<juce::FileChooser> ("Render a file through Noctave", juce::File(),
+                                                                 "*.wav;*.aif;*.aiff;*.flac;*.ogg");
+        renderFileChooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                        [this] (const juce::FileChooser& chooser)
+        {
+            const auto file = chooser.getResult();
+
+            if (file.existsAsFile())
+                (new RenderFileTask (audioProcessor, file))->launchThread();
+        });
+    };
+    content.addAndMakeVisible (&renderFileButton);
+
+   #if NOCTAVE_TRACE
+    // Writes the recorded trace markers to the desktop
+    dumpTraceButton.setColour (juce::TextButton::buttonColourId, vampireDark);
+    dumpTraceButton.setColour (juce::TextButton::textColourOffId, vampireText);
+    dumpTraceButton.onClick = []
+    {
+        const auto file = juce::File::getSpecialLocation (juce::File::userDesktopDirectory)
+                              .getNonexistentChildFile ("Noctave trace", ".json");
+
+        if (! Trace::dumpToFile (file))
+            juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Trace",
+                                                    "Couldn't write " + file.getFullPathName());
+    };
+    content.addAndMakeVisible (&dumpTraceButton);
+   #endif
+
+    refreshProgramBox();
 
     // Title label
     titleLabel.setText ("NOCTAVE", juce::dontSendNotification);
     titleLabel.setFont (juce::Font (56.0f, juce::Font::bold));
     titleLabel.setJustificationType (juce::Justification::centred);
     titleLabel.setColour (juce::Label::textColourId, vampireRed);
-    addAndMakeVisible (&titleLabel);
+    content.addAndMakeVisible (&titleLabel);
 
     // Try to load Nosferatu image from resources
     // Projucer should generate BinaryData when the resource is marked in .jucer file
@@ -77,6 +340,7 @@ NoctaveAudioProcessorEditor::NoctaveAudioProcessorEditor (NoctaveAudioProcessor&
 
 NoctaveAudioProcessorEditor::~NoctaveAudioProcessorEditor()
 {
+    setLookAndFeel (nullptr);
 }
 
 void NoctaveAudioProcessorEditor::setupSlider (juce::Slider& slider, juce::Label& label, const juce::String& labelText)
@@ -84,55 +348,158 @@ void NoctaveAudioProcessorEditor::setupSlider (juce::Slider& slider, juce::Label
     // Configure slider
     slider.setSliderStyle (juce::Slider::RotaryHorizontalVerticalDrag);
     slider.setTextBoxStyle (juce::Slider::TextBoxBelow, false, 100, 25);
-    slider.setPopupDisplayEnabled (true, false, this);
+    slider.setPopupDisplayEnabled (true, false, &content);
     slider.setColour (juce::Slider::rotarySliderFillColourId, vampireRed);
     slider.setColour (juce::Slider::rotarySliderOutlineColourId, vampireDark);
     slider.setColour (juce::Slider::thumbColourId, vampireCrimson);
     slider.setColour (juce::Slider::textBoxTextColourId, vampireText);
     slider.setColour (juce::Slider::textBoxBackgroundColourId, vampireBlack);
     slider.setColour (juce::Slider::textBoxOutlineColourId, vampireGray);
-    addAndMakeVisible (&slider);
+    content.addAndMakeVisible (&slider);
 
     // Configure label
     label.setText (labelText, juce::dontSendNotification);
     label.setJustificationType (juce::Justification::centred);
     label.setFont (juce::Font (18.0f, juce::Font::bold));
     label.setColour (juce::Label::textColourId, vampireText);
-    addAndMakeVisible (&label);
+    content.addAndMakeVisible (&label);
 
     // Attach to parameters
     if (labelText == "Pitch Shift")
     {
         pitchShiftSlider.setTextValueSuffix (" st");
-        pitchShiftAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.apvts, "PITCH_SHIFT", pitchShiftSlider);
+        parameterPoller.attach (pitchShiftSlider, "PITCH_SHIFT");
     }
     else if (labelText == "Mix")
     {
         mixSlider.setTextValueSuffix ("%");
-        mixAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.apvts, "MIX", mixSlider);
+        parameterPoller.attach (mixSlider, "MIX");
     }
     else if (labelText == "Feedback")
     {
         feedbackSlider.setTextValueSuffix ("%");
-        feedbackAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.apvts, "FEEDBACK", feedbackSlider);
+        parameterPoller.attach (feedbackSlider, "FEEDBACK");
     }
     else if (labelText == "Harmonizer")
     {
         harmonizerSlider.setTextValueSuffix (" st");
-        harmonizerAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-            audioProcessor.apvts, "HARMONIZER", harmonizerSlider);
+        parameterPoller.attach (harmonizerSlider, "HARMONIZER");
     }
+    else if (labelText == "Ceiling")
+    {
+        ceilingSlider.setTextValueSuffix (" dB");
+        parameterPoller.attach (ceilingSlider, "LIMIT_CEILING");
+    }
+    else if (labelText == "Release")
+    {
+        releaseSlider.setTextValueSuffix (" ms");
+        parameterPoller.attach (releaseSlider, "LIMIT_RELEASE");
+    }
+    else if (labelText == "Transients")
+    {
+        parameterPoller.attach (transientSlider, "TRANSIENT_LOOKAHEAD");
+    }
+    else if (labelText == "Retune Speed")
+    {
+        retuneSpeedSlider.setTextValueSuffix (" ms");
+        parameterPoller.attach (retuneSpeedSlider, "RETUNE_SPEED");
+    }
+    else if (labelText == "Humanise")
+    {
+        humaniseSlider.setTextValueSuffix ("%");
+        parameterPoller.attach (humaniseSlider, "HUMANISE");
+    }
+    else if (labelText == "Steps")
+    {
+        parameterPoller.attach (sequencerLengthSlider, "SEQ_LENGTH");
+    }
+    else if (labelText == "LFO")
+    {
+        parameterPoller.attach (lfoDepthSlider, "MOD_LFO_DEPTH");
+    }
+    else if (labelText == "Envelope")
+    {
+        parameterPoller.attach (envelopeDepthSlider, "MOD_ENV_DEPTH");
+    }
+    else if (labelText == "Random")
+    {
+        parameterPoller.attach (randomDepthSlider, "MOD_RANDOM_DEPTH");
+    }
+}
+
+void NoctaveAudioProcessorEditor::attachStepSliders()
+{
+    // Attaching a slider again replaces its old binding, so the lanes swap in place
+    const auto lane = sequencerLaneBox.getSelectedId() == 2 ? juce::String ("SEQ_HARMONY_") : juce::String ("SEQ_PITCH_");
+
+    for (size_t step = 0; step < stepSliders.size(); ++step)
+        parameterPoller.attach (stepSliders[step], lane + juce::String ((int) step + 1));
+}
+
+void NoctaveAudioProcessorEditor::refreshProgramBox()
+{
+    programBox.clear (juce::dontSendNotification);
+
+    for (int i = 0; i < audioProcessor.getNumPrograms(); ++i)
+        programBox.addItem (audioProcessor.getProgramName (i), i + 1);
+
+    programBox.setSelectedItemIndex (audioProcessor.getCurrentProgram(), juce::dontSendNotification);
+}
+
+void NoctaveAudioProcessorEditor::setupComboBox (juce::ComboBox& box, juce::Label& label, const juce::String& labelText, const juce::String& parameterID)
+{
+    attachComboBox (box, parameterID);
+
+    label.setText (labelText, juce::dontSendNotification);
+    label.setJustificationType (juce::Justification::centred);
+    label.setFont (juce::Font (16.0f, juce::Font::bold));
+    label.setColour (juce::Label::textColourId, vampireText);
+    content.addAndMakeVisible (&label);
+}
+
+void NoctaveAudioProcessorEditor::attachComboBox (juce::ComboBox& box, const juce::String& parameterID)
+{
+    // Populate from the parameter's choices before attaching so the selection is restored
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*> (audioProcessor.apvts.getParameter (parameterID)))
+        box.addItemList (choice->choices, 1);
+
+    box.setColour (juce::ComboBox::backgroundColourId, vampireBlack);
+    box.setColour (juce::ComboBox::textColourId, vampireText);
+    box.setColour (juce::ComboBox::outlineColourId, vampireGray);
+    box.setColour (juce::ComboBox::arrowColourId, vampireRed);
+    content.addAndMakeVisible (&box);
+
+    parameterPoller.attach (box, parameterID);
 }
 
 //==============================================================================
 void NoctaveAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    NOCTAVE_TRACE_SCOPE ("paint editor");
+
+    // The background is only redrawn when the size or the display's scale changes. Otherwise a
+    // repaint is one unscaled copy, so dragging a knob costs the same however big the window is
+    const auto pixelScale = (float) getWidth() / (float) designWidth * g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (! backgroundCache.isValid() || pixelScale != backgroundCacheScale)
+    {
+        backgroundCache = juce::Image (juce::Image::RGB, juce::roundToInt ((float) designWidth * pixelScale),
+                                       juce::roundToInt ((float) designHeight * pixelScale), false);
+        backgroundCacheScale = pixelScale;
+
+        juce::Graphics cacheGraphics (backgroundCache);
+        cacheGraphics.addTransform (juce::AffineTransform::scale (pixelScale));
+        drawBackground (cacheGraphics);
+    }
+
+    g.drawImage (backgroundCache, getLocalBounds().toFloat());
+}
+
+void NoctaveAudioProcessorEditor::drawBackground (juce::Graphics& g)
 {
     // Dark vampire-themed gradient background
     juce::ColourGradient gradient (vampireBlack, 0, 0,
-                                   vampireDark, 0, (float) getHeight(),
+                                   vampireDark, 0, (float) designHeight,
                                    false);
     gradient.addColour (0.3, vampireCrimson.withAlpha (0.1f));
     gradient.addColour (0.7, vampireDark);
@@ -140,12 +507,12 @@ void NoctaveAudioProcessorEditor::paint (juce::Graphics& g)
     g.fillAll();
 
     // Draw gothic frame
-    drawGothicFrame (g, getLocalBounds());
+    drawGothicFrame (g, { designWidth, designHeight });
 
     // Draw Nosferatu image if available
     if (nosferatuImage.isValid())
     {
-        juce::Rectangle<int> imageArea (getWidth() - 280, 100, 250, 400);
+        juce::Rectangle<int> imageArea (designWidth - 280, 100, 250, 400);
         
         // Draw with dark overlay for atmosphere
         g.setColour (juce::Colours::black.withAlpha (0.3f));
@@ -153,6 +520,7 @@ void NoctaveAudioProcessorEditor::paint (juce::Graphics& g)
         
         // Draw image with slight transparency for eerie effect
         g.setColour (juce::Colours::white.withAlpha (0.9f));
+        g.setImageResamplingQuality (juce::Graphics::highResamplingQuality);
         g.drawImageWithin (nosferatuImage, 
                           imageArea.getX(), imageArea.getY(),
                           imageArea.getWidth(), imageArea.getHeight(),
@@ -168,7 +536,7 @@ void NoctaveAudioProcessorEditor::paint (juce::Graphics& g)
     else
     {
         // Draw placeholder if image not found
-        juce::Rectangle<int> placeholderArea (getWidth() - 280, 100, 250, 400);
+        juce::Rectangle<int> placeholderArea (designWidth - 280, 100, 250, 400);
         g.setColour (vampireGray.withAlpha (0.3f));
         g.fillRect (placeholderArea);
         g.setColour (vampireText.withAlpha (0.5f));
@@ -181,17 +549,17 @@ void NoctaveAudioProcessorEditor::paint (juce::Graphics& g)
     g.setColour (vampireRed.withAlpha (0.3f));
     
     // Draw vertical lines on sides
-    g.drawLine (20.0f, 0.0f, 20.0f, (float) getHeight(), 2.0f);
-    g.drawLine ((float) getWidth() - 20.0f, 0.0f, (float) getWidth() - 20.0f, (float) getHeight(), 2.0f);
+    g.drawLine (20.0f, 0.0f, 20.0f, (float) designHeight, 2.0f);
+    g.drawLine ((float) designWidth - 20.0f, 0.0f, (float) designWidth - 20.0f, (float) designHeight, 2.0f);
     
     // Draw horizontal decorative lines
-    g.drawLine (0.0f, 80.0f, (float) getWidth(), 80.0f, 1.0f);
-    g.drawLine (0.0f, (float) getHeight() - 20.0f, (float) getWidth(), (float) getHeight() - 20.0f, 1.0f);
+    g.drawLine (0.0f, 80.0f, (float) designWidth, 80.0f, 1.0f);
+    g.drawLine (0.0f, (float) designHeight - 20.0f, (float) designWidth, (float) designHeight - 20.0f, 1.0f);
 
     // Draw subtitle
     g.setFont (juce::Font (14.0f, juce::Font::italic));
     g.setColour (vampireGray);
-    g.drawText ("Vampire-Themed Octave Pitch Shifter", getWidth() / 2 - 200, 90, 400, 20,
+    g.drawText ("Vampire-Themed Octave Pitch Shifter", designWidth / 2 - 200, 90, 400, 20,
                juce::Justification::centred, false);
 }
 
@@ -224,6 +592,9 @@ void NoctaveAudioProcessorEditor::drawGothicFrame (juce::Graphics& g, juce::Rect
 
 void NoctaveAudioProcessorEditor::resized()
 {
+    // Laid out at the design size, then scaled to the window as a whole
+    content.setTransform (juce::AffineTransform::scale ((float) getWidth() / (float) designWidth));
+
     const int sliderSize = 120;
     const int labelHeight = 30;
     const int spacing = 40;
@@ -231,10 +602,18 @@ void NoctaveAudioProcessorEditor::resized()
     const int leftMargin = 50;
     
     // Title - centered horizontally across the full width
-    const int titleWidth = getWidth() - 300; // Account for image on right side
-    const int titleX = (getWidth() - titleWidth) / 2; // Center the title in the available space
+    const int titleWidth = designWidth - 300; // Account for image on right side
+    const int titleX = (designWidth - titleWidth) / 2; // Center the title in the available space
     titleLabel.setBounds (titleX, 20, titleWidth, 60);
 
+    // Program selector - between the subtitle and the first row of knobs
+    programBox.setBounds (leftMargin, 112, 220, 26);
+    savePresetButton.setBounds (leftMargin + 230, 112, 60, 26);
+    renderFileButton.setBounds (leftMargin + 300, 112, 80, 26);
+   #if NOCTAVE_TRACE
+    dumpTraceButton.setBounds (leftMargin + 390, 112, 60, 26);
+   #endif
+
     // Pitch Shift slider (main control)
     pitchShiftSlider.setBounds (leftMargin, startY, sliderSize, sliderSize);
     pitchShiftLabel.setBounds (leftMargin, startY + sliderSize + 5, sliderSize, labelHeight);
@@ -246,10 +625,99 @@ void NoctaveAudioProcessorEditor::resized()
     // Feedback slider
     feedbackSlider.setBounds (leftMargin + 2 * (sliderSize + spacing), startY, sliderSize, sliderSize);
     feedbackLabel.setBounds (leftMargin + 2 * (sliderSize + spacing), startY + sliderSize + 5, sliderSize, labelHeight);
+    freezeButton.setBounds (leftMargin + 2 * (sliderSize + spacing) + 20, startY + sliderSize + 5 + labelHeight, sliderSize - 20, 28);
 
     // Harmonizer slider - placed on second row to avoid overlapping with image
     const int secondRowY = startY + sliderSize + labelHeight + 40;
     harmonizerSlider.setBounds (leftMargin, secondRowY, sliderSize, sliderSize);
     harmonizerLabel.setBounds (leftMargin, secondRowY + sliderSize + 5, sliderSize, labelHeight);
+
+    // Mode selectors - beside the harmonizer on the second row
+    const int comboWidth = 140;
+    const int comboHeight = 28;
+    const int comboX = leftMargin + sliderSize + spacing;
+    interpolationLabel.setBounds (comboX, secondRowY, comboWidth, labelHeight);
+    interpolationBox.setBounds (comboX, secondRowY + labelHeight, comboWidth, comboHeight);
+
+    const int engineY = secondRowY + labelHeight + comboHeight + 10;
+    engineLabel.setBounds (comboX, engineY, comboWidth, labelHeight);
+    engineBox.setBounds (comboX, engineY + labelHeight, comboWidth, comboHeight);
+
+    const int secondComboX = comboX + comboWidth + 20;
+    stereoModeLabel.setBounds (secondComboX, secondRowY, comboWidth, labelHeight);
+    stereoModeBox.setBounds (secondComboX, secondRowY + labelHeight, comboWidth, comboHeight);
+
+    const int offloadWidth = 65;
+    polyBandsLabel.setBounds (secondComboX, engineY, comboWidth - offloadWidth, labelHeight);
+    polyOffloadButton.setBounds (secondComboX + comboWidth - offloadWidth, engineY, offloadWidth, labelHeight);
+    polyBandsBox.setBounds (secondComboX, engineY + labelHeight, comboWidth, comboHeight);
+
+    // Output limiter - under the mode selectors
+    const int limiterY = engineY + labelHeight + comboHeight + 10;
+    ceilingLabel.setBounds (comboX, limiterY, comboWidth, labelHeight);
+    ceilingSlider.setBounds (comboX, limiterY + labelHeight, comboWidth, comboHeight);
+    releaseLabel.setBounds (secondComboX, limiterY, comboWidth, labelHeight);
+    releaseSlider.setBounds (secondComboX, limiterY + labelHeight, comboWidth, comboHeight);
+
+    // Transient lookahead - under the harmonizer knob
+    const int transientY = secondRowY + sliderSize + 5 + labelHeight;
+    transientLabel.setBounds (leftMargin, transientY, sliderSize, labelHeight);
+    transientSlider.setBounds (leftMargin, transientY + labelHeight, sliderSize, comboHeight);
+
+    // Diatonic harmony - a row under the limiter, clear of the image
+    const int harmonyY = limiterY + labelHeight + comboHeight + 10;
+    const int thirdComboX = secondComboX + comboWidth + 20;
+    harmonyModeLabel.setBounds (comboX, harmonyY, comboWidth, labelHeight);
+    harmonyModeBox.setBounds (comboX, harmonyY + labelHeight, comboWidth, comboHeight);
+    scaleLabel.setBounds (secondComboX, harmonyY, comboWidth, labelHeight);
+    scaleBox.setBounds (secondComboX, harmonyY + labelHeight, comboWidth, comboHeight);
+    keyLabel.setBounds (thirdComboX, harmonyY, comboWidth, labelHeight);
+    keyBox.setBounds (thirdComboX, harmonyY + labelHeight, comboWidth, comboHeight);
+
+    // Pitch correction - under the harmony row, which has the key and scale it corrects to
+    const int correctionY = harmonyY + labelHeight + comboHeight + 10;
+    correctionLabel.setBounds (comboX, correctionY, comboWidth, labelHeight);
+    correctionBox.setBounds (comboX, correctionY + labelHeight, comboWidth, comboHeight);
+    retuneSpeedLabel.setBounds (secondComboX, correctionY, comboWidth, labelHeight);
+    retuneSpeedSlider.setBounds (secondComboX, correctionY + labelHeight, comboWidth, comboHeight);
+    humaniseLabel.setBounds (thirdComboX, correctionY, comboWidth, labelHeight);
+    humaniseSlider.setBounds (thirdComboX, correctionY + labelHeight, comboWidth, comboHeight);
+
+    // Modulation - one column per source across the bottom: target and depth, then the source's own settings
+    const int modulationY = correctionY + labelHeight + comboHeight + 20;
+    const int columnWidth = 220;
+    const int halfWidth = (columnWidth - 10) / 2;
+    const int routeY = modulationY + labelHeight;
+    const int settingsY = routeY + comboHeight + 6;
+
+    lfoLabel.setBounds (leftMargin, modulationY, columnWidth, labelHeight);
+    envelopeLabel.setBounds (leftMargin + columnWidth + 20, modulationY, columnWidth, labelHeight);
+    randomLabel.setBounds (leftMargin + 2 * (columnWidth + 20), modulationY, columnWidth, labelHeight);
+
+    lfoTargetBox.setBounds (lfoLabel.getX(), routeY, halfWidth, comboHeight);
+    lfoDepthSlider.setBounds (lfoLabel.getX() + halfWidth + 10, routeY, halfWidth, comboHeight);
+    lfoShapeBox.setBounds (lfoLabel.getX(), settingsY, halfWidth, comboHeight);
+    lfoRateBox.setBounds (lfoLabel.getX() + halfWidth + 10, settingsY, halfWidth, comboHeight);
+
+    envelopeTargetBox.setBounds (envelopeLabel.getX(), routeY, halfWidth, comboHeight);
+    envelopeDepthSlider.setBounds (envelopeLabel.getX() + halfWidth + 10, routeY, halfWidth, comboHeight);
+
+    randomTargetBox.setBounds (randomLabel.getX(), routeY, halfWidth, comboHeight);
+    randomDepthSlider.setBounds (randomLabel.getX() + halfWidth + 10, routeY, halfWidth, comboHeight);
+    randomRateBox.setBounds (randomLabel.getX(), settingsY, halfWidth, comboHeight);
+
+    // Step sequencer - its settings on one row, then a bar per step across the bottom
+    const int sequencerY = settingsY + comboHeight + 20;
+    sequencerButton.setBounds (leftMargin, sequencerY, 120, comboHeight);
+    sequencerRateBox.setBounds (leftMargin + 130, sequencerY, 100, comboHeight);
+    sequencerLengthLabel.setBounds (leftMargin + 240, sequencerY, 60, comboHeight);
+    sequencerLengthSlider.setBounds (leftMargin + 300, sequencerY, 160, comboHeight);
+    sequencerLaneBox.setBounds (leftMargin + 470, sequencerY, 120, comboHeight);
+
+    const int stepWidth = 42;
+    const int stepsY = sequencerY + comboHeight + 8;
+
+    for (size_t step = 0; step < stepSliders.size(); ++step)
+        stepSliders[step].setBounds (leftMargin + (int) step * stepWidth, stepsY, stepWidth - 4, 70);
 }
 
@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "NoctaveLookAndFeel.h"
+#include "ParameterPoller.h"
 
 //==============================================================================
 /**
@@ -29,6 +31,14 @@ private:
     // access the processor object that created it.
     NoctaveAudioProcessor& audioProcessor;
 
+    // The layout is in design coordinates; the controls sit in a content component
+    // that's scaled to the window, so text and paths are drawn sharp at any size
+    static constexpr int designWidth = 800;
+    static constexpr int designHeight = 940;
+
+    NoctaveLookAndFeel lookAndFeel;
+    juce::Component content;
+
     // Vampire-themed colors
     juce::Colour vampireBlack = juce::Colour::fromFloatRGBA (0.05f, 0.02f, 0.05f, 1.0f);
     juce::Colour vampireDark = juce::Colour::fromFloatRGBA (0.15f, 0.08f, 0.12f, 1.0f);
@@ -42,23 +52,89 @@ private:
     juce::Slider mixSlider;
     juce::Slider feedbackSlider;
     juce::Slider harmonizerSlider;
+    juce::Slider ceilingSlider;
+    juce::Slider releaseSlider;
+    juce::Slider transientSlider;
+    juce::Slider retuneSpeedSlider;
+    juce::Slider humaniseSlider;
+    juce::Slider lfoDepthSlider;
+    juce::Slider envelopeDepthSlider;
+    juce::Slider randomDepthSlider;
     
     juce::Label pitchShiftLabel;
     juce::Label mixLabel;
     juce::Label feedbackLabel;
     juce::Label harmonizerLabel;
+    juce::Label ceilingLabel;
+    juce::Label releaseLabel;
+    juce::Label transientLabel;
+    juce::Label retuneSpeedLabel;
+    juce::Label humaniseLabel;
+    juce::Label lfoLabel;
+    juce::Label envelopeLabel;
+    juce::Label randomLabel;
+    juce::Label sequencerLengthLabel;
     juce::Label titleLabel;
+
+    juce::ComboBox interpolationBox;
+    juce::Label interpolationLabel;
+    juce::ComboBox engineBox;
+    juce::Label engineLabel;
+    juce::ComboBox polyBandsBox;
+    juce::Label polyBandsLabel;
+    juce::ToggleButton polyOffloadButton { "Offload" };
+    juce::ComboBox stereoModeBox;
+    juce::Label stereoModeLabel;
+    juce::ComboBox harmonyModeBox;
+    juce::Label harmonyModeLabel;
+    juce::ComboBox keyBox;
+    juce::Label keyLabel;
+    juce::ComboBox scaleBox;
+    juce::Label scaleLabel;
+    juce::ComboBox correctionBox;
+    juce::Label correctionLabel;
+
+    // Modulation routing
+    juce::ComboBox lfoShapeBox;
+    juce::ComboBox lfoRateBox;
+    juce::ComboBox lfoTargetBox;
+    juce::ComboBox envelopeTargetBox;
+    juce::ComboBox randomRateBox;
+    juce::ComboBox randomTargetBox;
+
+    juce::ToggleButton freezeButton { "Freeze" };
+
+    // Step sequencer - the step sliders edit one lane at a time
+    juce::ToggleButton sequencerButton { "Sequencer" };
+    juce::ComboBox sequencerRateBox;
+    juce::Slider sequencerLengthSlider;
+    juce::ComboBox sequencerLaneBox;
+    std::array<juce::Slider, StepSequencer::maxSteps> stepSliders;
+
+    juce::ComboBox programBox;
+    juce::TextButton savePresetButton { "Save" };
+    juce::TextButton renderFileButton { "Render..." };
+    std::unique_ptr<juce::FileChooser> renderFileChooser;
+   #if NOCTAVE_TRACE
+    juce::TextButton dumpTraceButton { "Trace" };
+   #endif
     
-    // Attachments
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> pitchShiftAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> feedbackAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> harmonizerAttachment;
+    // Keeps the controls in step with their parameters, once per frame
+    ParameterPoller parameterPoller { audioProcessor.apvts, *this };
     
     // Nosferatu image
     juce::Image nosferatuImage;
+
+    // Background, frame and image rendered once at the window's physical pixel scale
+    juce::Image backgroundCache;
+    float backgroundCacheScale = 0.0f;
     
     void setupSlider (juce::Slider& slider, juce::Label& label, const juce::String& labelText);
+    void setupComboBox (juce::ComboBox& box, juce::Label& label, const juce::String& labelText, const juce::String& parameterID);
+    void attachComboBox (juce::ComboBox& box, const juce::String& parameterID);
+    void attachStepSliders();
+    void refreshProgramBox();
+    void drawBackground (juce::Graphics& g);
     void drawGothicFrame (juce::Graphics& g, juce::Rectangle<int> bounds);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoctaveAudioProcessorEditor)
@@ -9,131 +9,32 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-//==============================================================================
-// PitchShifter Implementation
-//==============================================================================
+#if JucePlugin_Enable_ARA
+ #include "ARAPlaybackRenderer.h"
+#endif
 
-NoctaveAudioProcessor::PitchShifter::PitchShifter()
+namespace
 {
-    voices[0].delayBuffer.setSize (1, maxDelaySamples);
-    voices[0].delayBuffer.clear();
-}
+    // Below this, handing voices to the worker pool costs more than it saves
+    constexpr int minParallelChunkSize = 256;
 
-void NoctaveAudioProcessor::PitchShifter::prepare (double sampleRate, int maxBlockSize)
-{
-    currentSampleRate = sampleRate;
-    
-    voices[0].delayBuffer.setSize (1, maxDelaySamples);
-    voices[0].delayBuffer.clear();
-    voices[0].writePosition = maxDelaySamples * 0.5f; // Start at middle of buffer
-    voices[0].readPosition = maxDelaySamples * 0.5f;
-    
-    smoothedPitchShift = 0.0f;
-}
-
-void NoctaveAudioProcessor::PitchShifter::reset()
-{
-    voices[0].delayBuffer.clear();
-    voices[0].writePosition = maxDelaySamples * 0.5f;
-    voices[0].readPosition = maxDelaySamples * 0.5f;
-}
+    // Sequencer steps glide the pitch and fade the harmony over this long
+    constexpr double sequencerGlideSeconds = 0.003;
 
+    // In place: left becomes mid and right becomes side
+    void encodeMidSide (float* left, float* right, int numSamples) noexcept
+    {
+        juce::FloatVectorOperations::add (left, right, numSamples);
+        juce::FloatVectorOperations::multiply (left, 0.5f, numSamples);
+        juce::FloatVectorOperations::subtract (right, left, right, numSamples);
+    }
 
-void NoctaveAudioProcessor::PitchShifter::processBlock (juce::AudioBuffer<float>& buffer, 
-                                                         float pitchShiftSemitones, 
-                                                         float mix, 
-                                                         float feedback)
-{
-    if (buffer.getNumSamples() == 0)
-        return;
-    
-    // Smooth pitch shift parameter to avoid clicks
-    const float smoothingFactor = 0.995f;
-    smoothedPitchShift = smoothedPitchShift * smoothingFactor + pitchShiftSemitones * (1.0f - smoothingFactor);
-    
-    // Convert semitones to pitch ratio
-    float pitchRatio = std::pow (2.0f, smoothedPitchShift / 12.0f);
-    
-    // Clamp feedback to prevent runaway accumulation
-    feedback = juce::jlimit (0.0f, 0.5f, feedback);
-    
-    // Process each sample
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-    {
-        float input = buffer.getSample (0, sample);
-        
-        // Protect against hot input signals that could cause clipping
-        // More aggressive input limiting to prevent downstream issues
-        input = juce::jlimit (-0.9f, 0.9f, input);
-        
-        // Use the first voice for processing
-        auto& voice = voices[0];
-        
-        // Calculate read position based on pitch ratio
-        // When pitchRatio > 1 (shift up), read moves faster than write (read decrements more)
-        // When pitchRatio < 1 (shift down), read moves slower than write (read decrements less)
-        // Read position moves backwards relative to write
-        voice.readPosition -= pitchRatio;
-        
-        // Wrap read position
-        while (voice.readPosition < 0.0f)
-            voice.readPosition += maxDelaySamples;
-        while (voice.readPosition >= maxDelaySamples)
-            voice.readPosition -= maxDelaySamples;
-        
-        // Linear interpolation for smooth reading
-        int readPosInt = static_cast<int> (voice.readPosition);
-        float frac = voice.readPosition - readPosInt;
-        int readPosNext = (readPosInt + 1) % maxDelaySamples;
-        
-        float sample1 = voice.delayBuffer.getSample (0, readPosInt);
-        float sample2 = voice.delayBuffer.getSample (0, readPosNext);
-        float delayed = sample1 + frac * (sample2 - sample1);
-        
-        // Apply soft clipping to delayed signal to prevent harsh clipping
-        // More aggressive limiting to prevent hot signals from pitch shifter
-        float output = juce::jlimit (-0.85f, 0.85f, delayed);
-        
-        // Apply feedback with proper scaling to prevent accumulation
-        // Calculate feedback contribution with stronger attenuation to prevent runaway
-        // Use exponential decay to prevent feedback from building up indefinitely
-        float feedbackContribution = output * feedback * 0.75f; // Even stronger attenuation for stability
-        
-        // Write input + feedback to delay buffer, with aggressive limiting to prevent clipping
-        // This ensures the delay buffer never contains values that would cause clipping
-        float delayInput = juce::jlimit (-0.85f, 0.85f, input + feedbackContribution);
-        int writePosInt = static_cast<int> (voice.writePosition);
-        voice.delayBuffer.setSample (0, writePosInt, delayInput);
-        
-        // Update write position (always increments by 1)
-        voice.writePosition += 1.0f;
-        if (voice.writePosition >= maxDelaySamples)
-            voice.writePosition -= maxDelaySamples;
-        
-        // Mix dry and wet with proper gain staging and headroom
-        // Reduce gain more aggressively when mix is high to prevent clipping at 100% wet
-        float mixReduction = 1.0f - (mix * 0.15f); // Reduce up to 15% when mix is 100%
-        float wetGain = mix * 0.85f * mixReduction;  // More reduction for headroom
-        float dryGain = (1.0f - mix) * 0.9f;  // Slight reduction for headroom
-        float finalOutput = input * dryGain + output * wetGain;
-        
-        // Apply aggressive soft clipping to final output to prevent hard clipping
-        // Use a smooth tanh-based soft clipper for natural-sounding limiting
-        const float threshold = 0.8f;  // Lower threshold for more protection
-        if (std::abs (finalOutput) > threshold)
-        {
-            // Soft clip using tanh approximation for smooth limiting
-            float sign = finalOutput > 0.0f ? 1.0f : -1.0f;
-            float absValue = std::abs (finalOutput);
-            float excess = absValue - threshold;
-            // Smooth transition: compress excess above threshold more aggressively
-            finalOutput = sign * (threshold + (1.0f - threshold) * std::tanh (excess * 6.0f));
-        }
-        
-        // Final hard limit as safety (should rarely be needed with soft clipping)
-        finalOutput = juce::jlimit (-0.9f, 0.9f, finalOutput);
-        
-        buffer.setSample (0, sample, finalOutput);
+    // In place: mid and side back to left and right
+    void decodeMidSide (float* mid, float* side, int numSamples) noexcept
+    {
+        juce::FloatVectorOperations::add (mid, side, numSamples);
+        juce::FloatVectorOperations::multiply (side, -2.0f, numSamples);
+        juce::FloatVectorOperations::add (side, mid, numSamples);
     }
 }
 
@@ -158,10 +59,54 @@ NoctaveAudioProcessor::NoctaveAudioProcessor()
     mixParam = apvts.getRawParameterValue("MIX");
     feedbackParam = apvts.getRawParameterValue("FEEDBACK");
     harmonizerParam = apvts.getRawParameterValue("HARMONIZER");
+    interpolationParam = apvts.getRawParameterValue("INTERPOLATION");
+    engineParam = apvts.getRawParameterValue("ENGINE");
+    polyBandsParam = apvts.getRawParameterValue("POLY_BANDS");
+    stereoModeParam = apvts.getRawParameterValue("STEREO_MODE");
+    limitCeilingParam = apvts.getRawParameterValue("LIMIT_CEILING");
+    limitReleaseParam = apvts.getRawParameterValue("LIMIT_RELEASE");
+    transientLookaheadParam = apvts.getRawParameterValue("TRANSIENT_LOOKAHEAD");
+    polyOffloadParam = apvts.getRawParameterValue("POLY_OFFLOAD");
+    harmonyModeParam = apvts.getRawParameterValue("HARMONY_MODE");
+    keyParam = apvts.getRawParameterValue("KEY");
+    scaleParam = apvts.getRawParameterValue("SCALE");
+    correctionParam = apvts.getRawParameterValue("CORRECTION");
+    retuneSpeedParam = apvts.getRawParameterValue("RETUNE_SPEED");
+    humaniseParam = apvts.getRawParameterValue("HUMANISE");
+    lfoShapeParam = apvts.getRawParameterValue("MOD_LFO_SHAPE");
+    lfoRateParam = apvts.getRawParameterValue("MOD_LFO_RATE");
+    lfoTargetParam = apvts.getRawParameterValue("MOD_LFO_TARGET");
+    lfoDepthParam = apvts.getRawParameterValue("MOD_LFO_DEPTH");
+    envelopeTargetParam = apvts.getRawParameterValue("MOD_ENV_TARGET");
+    envelopeDepthParam = apvts.getRawParameterValue("MOD_ENV_DEPTH");
+    randomRateParam = apvts.getRawParameterValue("MOD_RANDOM_RATE");
+    randomTargetParam = apvts.getRawParameterValue("MOD_RANDOM_TARGET");
+    randomDepthParam = apvts.getRawParameterValue("MOD_RANDOM_DEPTH");
+    freezeParam = apvts.getRawParameterValue("FREEZE");
+    sequencerParam = apvts.getRawParameterValue("SEQ_ON");
+    sequencerRateParam = apvts.getRawParameterValue("SEQ_RATE");
+    sequencerLengthParam = apvts.getRawParameterValue("SEQ_LENGTH");
+
+    for (int step = 0; step < StepSequencer::maxSteps; ++step)
+    {
+        sequencerPitchParams[(size_t) step] = apvts.getRawParameterValue ("SEQ_PITCH_" + juce::String (step + 1));
+        sequencerHarmonyParams[(size_t) step] = apvts.getRawParameterValue ("SEQ_HARMONY_" + juce::String (step + 1));
+    }
+
+    presetBank->initialise (apvts);
+    stateIndex = std::make_unique<StateFormat::ParameterIndex> (*this);
+
+    // Mirrors program changes made on the audio thread back to the parameters
+    startTimerHz (30);
 }
 
 NoctaveAudioProcessor::~NoctaveAudioProcessor()
 {
+    stopTimer();
+
+    // The pool may go with this instance, so let go of its workers first
+    for (auto& octave : offloadedOctaves)
+        octave.detach();
 }
 
 //==============================================================================
@@ -204,46 +149,412 @@ double NoctaveAudioProcessor::getTailLengthSeconds() const
 
 int NoctaveAudioProcessor::getNumPrograms()
 {
-    return 1;
+    return presetBank->getNumPresets();
 }
 
 int NoctaveAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
 void NoctaveAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow (index, presetBank->getNumPresets()))
+        return;
+
+    currentProgram.store (index);
+
+    // While processing, the audio thread switches at the start of its next block;
+    // otherwise there's nothing to glide, so set the parameters straight away
+    if (isPrepared.load())
+        pendingProgram.store (index);
+    else
+        pushProgramToParameters (index);
 }
 
 const juce::String NoctaveAudioProcessor::getProgramName (int index)
 {
+    if (juce::isPositiveAndBelow (index, presetBank->getNumPresets()))
+        return presetBank->getPreset (index).name;
+
     return {};
 }
 
 void NoctaveAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    presetBank->renamePreset (index, newName);
+}
+
+int NoctaveAudioProcessor::saveCurrentAsUserPreset (const juce::String& name)
+{
+    const auto index = presetBank->addUserPreset (name, apvts);
+
+    if (index >= 0)
+    {
+        currentProgram.store (index);
+        updateHostDisplay (ChangeDetails().withProgramChanged (true));
+    }
+
+    return index;
+}
+
+void NoctaveAudioProcessor::applyProgram (int index) noexcept
+{
+    if (! juce::isPositiveAndBelow (index, presetBank->getNumPresets()))
+        return;
+
+    currentProgram.store (index);
+    overrideProgram.store (index);
+    programToSync.store (index);
+}
+
+void NoctaveAudioProcessor::pushProgramToParameters (int index)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    const auto& preset = presetBank->getPreset (index);
+    const auto& ids = PresetBank::getParameterIDs();
+
+    for (int slot = 0; slot < ids.size(); ++slot)
+    {
+        if (auto* parameter = apvts.getParameter (ids[slot]))
+        {
+            parameter->beginChangeGesture();
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (preset.values[(size_t) slot]));
+            parameter->endChangeGesture();
+        }
+    }
+}
+
+float NoctaveAudioProcessor::getParameterValue (int slot, const std::atomic<float>* parameter) const noexcept
+{
+    const auto program = overrideProgram.load();
+
+    return program >= 0 ? presetBank->getPreset (program).values[(size_t) slot]
+                        : parameter->load();
+}
+
+bool NoctaveAudioProcessor::isHarmonizerWanted() const noexcept
+{
+    return std::abs (getParameterValue (PresetBank::harmonizerSlot, harmonizerParam)) > 0.1f
+            || getModulationSettings().modulates (ModulationEngine::Destination::harmony)
+            || sequencesHarmony();
+}
+
+bool NoctaveAudioProcessor::sequencesHarmony() const noexcept
+{
+    if (getParameterValue (PresetBank::sequencerSlot, sequencerParam) < 0.5f)
+        return false;
+
+    const int length = juce::jlimit (1, StepSequencer::maxSteps,
+                                     juce::roundToInt (getParameterValue (PresetBank::sequencerLengthSlot, sequencerLengthParam)));
+
+    for (int step = 0; step < length; ++step)
+        if (std::abs (getParameterValue (PresetBank::sequencerHarmonySlot + step, sequencerHarmonyParams[(size_t) step])) > 0.1f)
+            return true;
+
+    return false;
+}
+
+void NoctaveAudioProcessor::updateHarmonizerHistory (bool useHarmonizer)
+{
+    const bool hasHistory = harmonizers[0].hasHistory();
+
+    if (! hasHistory && offeredHistory.full.load (std::memory_order_acquire))
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            offeredHistory.lines[(size_t) channel] = harmonizers[channel].exchangeHistory (std::move (offeredHistory.lines[(size_t) channel]));
+
+        harmonizerHasHistory.store (true);
+        offeredHistory.full.store (false, std::memory_order_release);
+    }
+    else if (! hasHistory && useHarmonizer && isNonRealtime())
+    {
+        // A render mustn't depend on when the timer last ran, and has time to allocate here
+        for (auto& harmonizer : harmonizers)
+            harmonizer.exchangeHistory (std::make_unique<PitchShifter::History>());
+
+        harmonizerHasHistory.store (true);
+    }
+    else if (hasHistory && ! useHarmonizer && releaseHarmonizerHistory.load()
+              && ! retiredHistory.full.load (std::memory_order_acquire))
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            retiredHistory.lines[(size_t) channel] = harmonizers[channel].exchangeHistory (nullptr);
+
+        harmonizerHasHistory.store (false);
+        retiredHistory.full.store (true, std::memory_order_release);
+    }
+}
+
+void NoctaveAudioProcessor::manageHarmonizerHistory()
+{
+    // Hand the harmonizer back its memory a while after it's switched off, so flicking
+    // through settings doesn't allocate over and over
+    constexpr juce::uint32 releaseDelayMilliseconds = 2000;
+
+    if (retiredHistory.full.load (std::memory_order_acquire))
+    {
+        for (auto& line : retiredHistory.lines)
+            line.reset();
+
+        retiredHistory.full.store (false, std::memory_order_release);
+        DBG (getMemoryReport());
+    }
+
+    const auto now = juce::Time::getMillisecondCounter();
+    const bool wanted = isHarmonizerWanted();
+
+    if (wanted)
+        lastHarmonizerUse = now;
+
+    releaseHarmonizerHistory.store (now - lastHarmonizerUse > releaseDelayMilliseconds);
+
+    // The audio thread clears the offer only after it has taken the lines, so checking
+    // in this order never offers a second pair
+    if (wanted && isPrepared.load()
+         && ! offeredHistory.full.load (std::memory_order_acquire) && ! harmonizerHasHistory.load())
+    {
+        for (auto& line : offeredHistory.lines)
+            line = std::make_unique<PitchShifter::History>();
+
+        offeredHistory.full.store (true, std::memory_order_release);
+        DBG (getMemoryReport() << " (harmonizer history offered)");
+    }
+}
+
+juce::String NoctaveAudioProcessor::getMemoryReport() const
+{
+    const auto toKilobytes = [] (size_t bytes) { return juce::String ((double) bytes / 1024.0, 1) + " KB"; };
+
+    const auto pairBytes = 2 * PitchShifter::getHistorySizeInBytes();
+    const bool harmonizerAllocated = harmonizerHasHistory.load();
+    const auto scratchBytes = (size_t) (harmonyBuffer.getNumChannels() * harmonyBuffer.getNumSamples()) * sizeof (float);
+    const auto totalBytes = pairBytes + (harmonizerAllocated ? pairBytes : 0) + scratchBytes;
+
+    return juce::String ("Noctave memory: shifter history ") + toKilobytes (pairBytes)
+             + (NOCTAVE_COMPACT_HISTORY ? " (16-bit)" : " (32-bit)")
+             + ", harmonizer history " + (harmonizerAllocated ? toKilobytes (pairBytes) : juce::String ("not allocated"))
+             + ", harmony scratch " + toKilobytes (scratchBytes)
+             + ", total " + toKilobytes (totalBytes);
+}
+
+int NoctaveAudioProcessor::getLookaheadSamples() const noexcept
+{
+    // Only the delay line steers its splices; the octave engines stay at zero latency
+    if (static_cast<Engine> (juce::roundToInt (engineParam->load())) != Engine::delayLine)
+        return 0;
+
+    const int samples = juce::roundToInt (transientLookaheadParam->load() * 0.001 * currentSampleRate);
+    return samples > 0 ? juce::jmax (samples, PitchShifter::minLookaheadSamples) : 0;
+}
+
+int NoctaveAudioProcessor::getOffloadLatencySamples() const noexcept
+{
+    if (static_cast<Engine> (juce::roundToInt (engineParam->load())) != Engine::polyOctave || polyOffloadParam->load() < 0.5f)
+        return 0;
+
+    return offloadedOctaves[0].getLatencySamples();
+}
+
+void NoctaveAudioProcessor::getTargetScale (int& root, Scales::Scale& scale) const noexcept
+{
+    // Auto takes the tonic and mode the tracker has heard, or the scale on C until it has
+    const int keyChoice = juce::roundToInt (getParameterValue (PresetBank::keySlot, keyParam));
+    scale = static_cast<Scales::Scale> (juce::roundToInt (getParameterValue (PresetBank::scaleSlot, scaleParam)));
+    root = juce::jmax (0, keyChoice - 1);
+
+    if (PitchTracker::Key key; keyChoice == 0 && pitchTracker.getKey (key))
+    {
+        root = key.root;
+        scale = key.isMinor ? Scales::Scale::naturalMinor : Scales::Scale::major;
+    }
+}
+
+int NoctaveAudioProcessor::getDiatonicInterval (float harmonizerInterval) noexcept
+{
+    // Until the tracker has heard a note, the knob's interval plays as it is
+    const int note = noteFollower.update (pitchTracker.getPitch());
+
+    if (note < 0)
+        return juce::roundToInt (harmonizerInterval);
+
+    int root = 0;
+    auto scale = Scales::Scale::major;
+    getTargetScale (root, scale);
+
+    return Scales::getDiatonicInterval (note, root, scale, Scales::getScaleSteps (juce::roundToInt (harmonizerInterval), scale));
+}
+
+void NoctaveAudioProcessor::updateOffloadWorkers()
+{
+    // Only attach while offloading, so the clients the workers scan all have work coming.
+    // Offline renders run every frame themselves and don't need them.
+    const bool wanted = isPrepared.load() && getOffloadLatencySamples() > 0 && ! isNonRealtime();
+
+    for (auto& octave : offloadedOctaves)
+    {
+        if (wanted)
+            octave.attach (*workerPool);
+        else
+            octave.detach();
+    }
+}
+
+void NoctaveAudioProcessor::timerCallback()
+{
+    manageHarmonizerHistory();
+    updateOffloadWorkers();
+
+    // The lookahead and offload are part of the latency, which the host is told about from here
+    if (isPrepared.load())
+        if (const int latency = outputLimiter.getLatencySamples() + getLookaheadSamples() + getOffloadLatencySamples();
+             latency != getLatencySamples())
+            setLatencySamples (latency);
+
+    const auto program = programToSync.exchange (-1);
+
+    if (program < 0)
+        return;
+
+    pushProgramToParameters (program);
+
+    // Hand control back to the parameters, unless another program arrived meanwhile
+    auto expected = program;
+    overrideProgram.compare_exchange_strong (expected, -1);
+
+    updateHostDisplay (ChangeDetails().withProgramChanged (true));
 }
 
 //==============================================================================
 void NoctaveAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    NOCTAVE_TRACE_SCOPE ("prepareToPlay");
     currentSampleRate = sampleRate;
+
+    // Probe the CPU once here; the shifters pick the chosen kernels up in prepare()
+    kernels = &DspKernels::select();
+    DBG ("Noctave DSP kernels: " << DspKernels::getName (kernels->instructionSet));
     
     for (int channel = 0; channel < 2; ++channel)
     {
         pitchShifters[channel].prepare (sampleRate, samplesPerBlock);
-        harmonizers[channel].prepare (sampleRate, samplesPerBlock);
+        harmonizers[channel].prepare (sampleRate, samplesPerBlock, false);
+        analogOctaves[channel].prepare (sampleRate);
+        polyOctaves[channel].prepare (sampleRate);
+
+        // Offloading delays by one block, so a job has a block's time on the workers
+        offloadedOctaves[channel].detach();
+        offloadedOctaves[channel].prepare (sampleRate, samplesPerBlock);
+        harmonyDelays[channel].prepare (samplesPerBlock);
     }
+
+    // The harmonizer gets its delay lines here if it's already on, otherwise from the timer once it is
+    if (isHarmonizerWanted() && ! harmonizers[0].hasHistory())
+        for (auto& harmonizer : harmonizers)
+            harmonizer.exchangeHistory (std::make_unique<PitchShifter::History>());
+
+    harmonizerHasHistory.store (harmonizers[0].hasHistory());
+
+    // The engines work sample by sample; the limiter looks ahead, and so does the delay
+    // line when it's steering splices onto transients. Offloading adds a block.
+    outputLimiter.prepare (sampleRate);
+    setLatencySamples (outputLimiter.getLatencySamples() + getLookaheadSamples() + getOffloadLatencySamples());
+    sideDelay.prepare (juce::jmax ((int) std::ceil (PitchShifter::maxLookaheadSeconds * sampleRate), samplesPerBlock));
+
+    pitchTracker.prepare (sampleRate);
+    noteFollower.reset();
+    pitchCorrector.prepare (sampleRate, ModulationEngine::controlInterval);
+
+    harmonyBuffer.setSize (2, juce::jmax (1, samplesPerBlock));
+    modulationEngine.prepare (sampleRate, harmonyBuffer.getNumSamples());
+    stepSequencer.prepare (sampleRate);
+    sequencerStep = -1;
+    stepCorrections.assign ((size_t) (harmonyBuffer.getNumSamples() / ModulationEngine::controlInterval + 2), 0.0f);
+    DBG (getMemoryReport());
+
+    sideGain.reset (sampleRate, 0.02);
+    sideGainGlide = 0;
+    snapSideGain = true;
+    harmonyGain.reset (sampleRate, sequencerGlideSeconds);
+    snapHarmonyGain = true;
+
+   #if JucePlugin_Enable_ARA
+    prepareToPlayForARA (sampleRate, samplesPerBlock, getMainBusNumOutputChannels(), getProcessingPrecision());
+   #endif
+
+    isPrepared.store (true);
+    updateOffloadWorkers();
 }
 
 void NoctaveAudioProcessor::releaseResources()
 {
+    isPrepared.store (false);
+    updateOffloadWorkers();
+
+   #if JucePlugin_Enable_ARA
+    releaseResourcesForARA();
+   #endif
+
     for (int channel = 0; channel < 2; ++channel)
     {
         pitchShifters[channel].reset();
         harmonizers[channel].reset();
+        analogOctaves[channel].reset();
+        polyOctaves[channel].reset();
+        offloadedOctaves[channel].reset();
+        harmonyDelays[channel].reset();
     }
+
+    // Nothing is playing, so the harmonizer's lines can go straight away
+    for (auto& harmonizer : harmonizers)
+        harmonizer.exchangeHistory (nullptr);
+
+    harmonizerHasHistory.store (false);
+
+    sideDelay.reset();
+    pitchTracker.reset();
+    noteFollower.reset();
+    pitchCorrector.reset();
+    outputLimiter.reset();
+    modulationEngine.reset();
+    stepSequencer.reset();
+    sequencerStep = -1;
+}
+
+void NoctaveAudioProcessor::restartAt (juce::int64 samplePosition)
+{
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        pitchShifters[channel].reset (samplePosition);
+        harmonizers[channel].reset (samplePosition);
+        analogOctaves[channel].reset();
+        polyOctaves[channel].reset();
+        offloadedOctaves[channel].reset();
+        harmonyDelays[channel].reset();
+    }
+
+    sideDelay.reset();
+    pitchTracker.reset();
+    noteFollower.reset();
+    pitchCorrector.reset();
+    outputLimiter.reset();
+    modulationEngine.reset (samplePosition);
+    stepSequencer.reset (samplePosition);
+    sequencerStep = -1;
+
+    // Already on the current engine and mode, so the next segment doesn't reset again
+    activeEngine = static_cast<Engine> (juce::roundToInt (engineParam->load()));
+    activeStereoMode = static_cast<StereoMode> (juce::roundToInt (stereoModeParam->load()));
+    activeOffload = getOffloadLatencySamples() > 0;
+    snapSideGain = true;
+    snapHarmonyGain = true;
+}
+
+int NoctaveAudioProcessor::getRestartWarmUpSamples() const
+{
+    return PitchShifter::getWarmUpSamples (getParameterValue (PresetBank::feedbackSlot, feedbackParam))
+             + outputLimiter.getWarmUpSamples (getParameterValue (PresetBank::limitReleaseSlot, limitReleaseParam));
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -269,79 +580,473 @@ bool NoctaveAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 
 void NoctaveAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    juce::ignoreUnused (midiMessages);
-    
     juce::ScopedNoDenormals noDenormals;
+    const RealtimeChecks::ScopedRealtimeRender realtimeRender (isRealtime());
+    NOCTAVE_TRACE_SCOPE ("processBlock");
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
+    const int numSamples = buffer.getNumSamples();
 
     // Clear unused output channels
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+        buffer.clear (i, 0, numSamples);
+
+   #if JucePlugin_Enable_ARA
+    // Bound to an ARA document: play the clips rendered in the background instead
+    if (isBoundToARA())
+    {
+        if (const auto program = pendingProgram.exchange (-1); program >= 0)
+            applyProgram (program);
+
+        if (auto* renderer = getPlaybackRenderer<NoctavePlaybackRenderer>())
+            renderer->setParameters (getParameterValue (PresetBank::pitchShiftSlot, pitchShiftParam),
+                                     getParameterValue (PresetBank::mixSlot, mixParam));
+
+        if (! processBlockForARA (buffer, isRealtime(), getPlayHead()))
+            processBlockBypassed (buffer, midiMessages);
+
+        limitOutput (buffer);
+        RealtimeChecks::checkOutput (buffer);
+        return;
+    }
+   #endif
+
+    // A program picked by the host since the last block starts with this block
+    if (const auto program = pendingProgram.exchange (-1); program >= 0)
+        applyProgram (program);
+
+    // Synced modulation and the sequencer follow the host's tempo and beat
+    if (auto* playHead = getPlayHead())
+    {
+        const auto position = playHead->getPosition();
+        modulationEngine.setTransport (position);
+        stepSequencer.setTransport (position);
+    }
+
+    // The sequencer's steps are found before the block plays. Off, it only counts samples.
+    if (getParameterValue (PresetBank::sequencerSlot, sequencerParam) >= 0.5f)
+    {
+        const int rate = juce::roundToInt (getParameterValue (PresetBank::sequencerRateSlot, sequencerRateParam));
+        const int length = juce::roundToInt (getParameterValue (PresetBank::sequencerLengthSlot, sequencerLengthParam));
+
+        stepSequencer.schedule (ModulationEngine::getDivisionBeats (rate),
+                                juce::jlimit (1, StepSequencer::maxSteps, length),
+                                numSamples);
+    }
+    else
+    {
+        stepSequencer.advance (numSamples);
+        sequencerStep = -1;
+    }
+
+    // MIDI program changes split the block, so their ramps start on the exact sample. So do
+    // notes while they're the pitch correction's targets; otherwise they're only noted.
+    const bool noteTargets = static_cast<Correction> (juce::roundToInt (getParameterValue (PresetBank::correctionSlot, correctionParam)))
+                               == Correction::midi;
+    int segmentStart = 0, nextTransition = 0;
+
+    // Plays up to end, splitting at each sequencer step that starts on the way
+    const auto processUpTo = [&] (int end)
+    {
+        for (; nextTransition < stepSequencer.getNumTransitions(); ++nextTransition)
+        {
+            const auto& transition = stepSequencer.getTransition (nextTransition);
+
+            if (transition.sample > end)
+                break;
+
+            processSegment (buffer, segmentStart, transition.sample - segmentStart);
+            segmentStart = transition.sample;
+            sequencerStep = transition.step;
+        }
+
+        processSegment (buffer, segmentStart, end - segmentStart);
+        segmentStart = end;
+    };
+
+    for (const auto metadata : midiMessages)
+    {
+        const auto message = metadata.getMessage();
+        const bool isNote = message.isNoteOnOrOff() || message.isAllNotesOff() || message.isAllSoundOff();
+
+        if (! message.isProgramChange() && ! (isNote && noteTargets))
+        {
+            if (isNote)
+                pitchCorrector.handleMidiMessage (message);
+
+            continue;
+        }
+
+        processUpTo (juce::jlimit (segmentStart, numSamples, metadata.samplePosition));
+
+        if (isNote)
+            pitchCorrector.handleMidiMessage (message);
+        else
+            applyProgram (message.getProgramChangeNumber());
+    }
+
+    processUpTo (numSamples);
+
+    limitOutput (buffer);
+    RealtimeChecks::checkOutput (buffer);
+}
+
+ModulationEngine::Settings NoctaveAudioProcessor::getModulationSettings() const noexcept
+{
+    const auto getChoice = [this] (int slot, const std::atomic<float>* parameter)
+    {
+        return juce::roundToInt (getParameterValue (slot, parameter));
+    };
+
+    const auto getRoute = [&] (int targetSlot, const std::atomic<float>* target, int depthSlot, const std::atomic<float>* depth)
+    {
+        return ModulationEngine::Route { static_cast<ModulationEngine::Destination> (getChoice (targetSlot, target)),
+                                         getParameterValue (depthSlot, depth) };
+    };
+
+    ModulationEngine::Settings settings;
+    settings.lfoShape = static_cast<ModulationEngine::Shape> (getChoice (PresetBank::lfoShapeSlot, lfoShapeParam));
+    settings.lfoDivision = getChoice (PresetBank::lfoRateSlot, lfoRateParam);
+    settings.randomDivision = getChoice (PresetBank::randomRateSlot, randomRateParam);
+    settings.lfo = getRoute (PresetBank::lfoTargetSlot, lfoTargetParam, PresetBank::lfoDepthSlot, lfoDepthParam);
+    settings.envelope = getRoute (PresetBank::envelopeTargetSlot, envelopeTargetParam, PresetBank::envelopeDepthSlot, envelopeDepthParam);
+    settings.random = getRoute (PresetBank::randomTargetSlot, randomTargetParam, PresetBank::randomDepthSlot, randomDepthParam);
+    return settings;
+}
+
+void NoctaveAudioProcessor::limitOutput (juce::AudioBuffer<float>& buffer) noexcept
+{
+    NOCTAVE_TRACE_SCOPE ("limit output");
+
+    outputLimiter.setCeilingDecibels (getParameterValue (PresetBank::limitCeilingSlot, limitCeilingParam));
+    outputLimiter.setReleaseMilliseconds (getParameterValue (PresetBank::limitReleaseSlot, limitReleaseParam));
+    outputLimiter.process (buffer, 0, buffer.getNumSamples());
+}
+
+void NoctaveAudioProcessor::processSegment (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0 || harmonyBuffer.getNumSamples() == 0)
+        return;
 
     // Get parameter values
-    float pitchShift = pitchShiftParam->load();
-    float mix = mixParam->load();
-    float feedback = feedbackParam->load();
-    float harmonizerInterval = harmonizerParam->load();
-
-    // Process each channel
-    for (int channel = 0; channel < totalNumInputChannels && channel < 2; ++channel)
-    {
-        // Create a single-channel buffer for processing
-        juce::AudioBuffer<float> singleChannelBuffer (1, buffer.getNumSamples());
-        singleChannelBuffer.copyFrom (0, 0, buffer, channel, 0, buffer.getNumSamples());
-        
+    NOCTAVE_TRACE_BEGIN (parameterTrace, "read parameters");
+    float pitchShift = getParameterValue (PresetBank::pitchShiftSlot, pitchShiftParam);
+    float mix = getParameterValue (PresetBank::mixSlot, mixParam);
+    float feedback = getParameterValue (PresetBank::feedbackSlot, feedbackParam);
+    float harmonizerInterval = getParameterValue (PresetBank::harmonizerSlot, harmonizerParam);
+    auto interpolation = static_cast<Interpolation::Kernel> (juce::roundToInt (getParameterValue (PresetBank::interpolationSlot, interpolationParam)));
+    auto engine = static_cast<Engine> (juce::roundToInt (engineParam->load()));
+    const int polyBands = PolyOctave::getBandCount (juce::roundToInt (polyBandsParam->load()));
+    auto stereoMode = static_cast<StereoMode> (juce::roundToInt (stereoModeParam->load()));
+    const auto modulation = getModulationSettings();
+    const bool modulating = modulation.isActive();
+
+    // The sequencer's step adds its intervals to the knobs, as modulation does
+    const bool sequencing = sequencerStep >= 0;
+
+    if (sequencing)
+    {
+        pitchShift = juce::jlimit (-24.0f, 24.0f, pitchShift + getParameterValue (PresetBank::sequencerPitchSlot + sequencerStep,
+                                                                                 sequencerPitchParams[(size_t) sequencerStep]));
+        harmonizerInterval = juce::jlimit (-12.0f, 12.0f, harmonizerInterval + getParameterValue (PresetBank::sequencerHarmonySlot + sequencerStep,
+                                                                                                 sequencerHarmonyParams[(size_t) sequencerStep]));
+    }
+
+    // A pattern with harmony keeps the voice running through its steps without
+    const bool useHarmonizer = std::abs (harmonizerInterval) > 0.1f
+                                || modulation.modulates (ModulationEngine::Destination::harmony)
+                                || sequencesHarmony();
+    const int lookahead = getLookaheadSamples();
+    const int offloadLatency = getOffloadLatencySamples();
+    const bool offload = offloadLatency > 0;
+    const bool diatonic = static_cast<HarmonyMode> (juce::roundToInt (getParameterValue (PresetBank::harmonyModeSlot, harmonyModeParam)))
+                            == HarmonyMode::diatonic;
+    const bool detectKey = juce::roundToInt (getParameterValue (PresetBank::keySlot, keyParam)) == 0;
+    const auto correction = static_cast<Correction> (juce::roundToInt (getParameterValue (PresetBank::correctionSlot, correctionParam)));
+    const bool freeze = freezeParam->load() >= 0.5f;
+
+    // Correction drives the delay line's ratio; the octave engines only shift whole octaves
+    const bool correcting = correction != Correction::off && engine == Engine::delayLine;
+    pitchCorrector.setRetuneSpeed (getParameterValue (PresetBank::retuneSpeedSlot, retuneSpeedParam));
+    pitchCorrector.setHumanise (getParameterValue (PresetBank::humaniseSlot, humaniseParam));
+    NOCTAVE_TRACE_END (parameterTrace);
+
+    // Until the timer's delay lines arrive, the harmony voice is silent
+    updateHarmonizerHistory (useHarmonizer);
+
+    // Start the engine being switched to from silence rather than stale history
+    if (engine != activeEngine || stereoMode != activeStereoMode || offload != activeOffload)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            pitchShifters[channel].reset();
+            harmonizers[channel].reset();
+            analogOctaves[channel].reset();
+            polyOctaves[channel].reset();
+            offloadedOctaves[channel].reset();
+            harmonyDelays[channel].reset();
+        }
+
+        sideDelay.reset();
+        activeEngine = engine;
+        activeStereoMode = stereoMode;
+        activeOffload = offload;
+    }
+
+    // The mid/side modes shift only the mid, in channel 0, so only one chain runs
+    const int numInputChannels = juce::jmin (getTotalNumInputChannels(), 2);
+    const bool midSide = numInputChannels == 2 && stereoMode != StereoMode::leftRight;
+    const int numChains = midSide ? 1 : numInputChannels;
+
+    if (midSide)
+    {
+        encodeMidSide (buffer.getWritePointer (0, startSample), buffer.getWritePointer (1, startSample), numSamples);
+
+        sideDelay.setDelay (lookahead + offloadLatency);
+        sideDelay.process (buffer.getWritePointer (1, startSample), numSamples);
+    }
+
+    // Modulated settings glide over exactly one grid step, which joins the steps into a line
+    const auto getGlide = [&modulation] (ModulationEngine::Destination destination)
+    {
+        return modulation.modulates (destination) ? ModulationEngine::controlInterval : 0;
+    };
+
+    // Corrected pitch moves every grid step too. Sequencer steps glide just long enough not to click.
+    const int sequencerGlide = sequencing ? (int) std::ceil (currentSampleRate * sequencerGlideSeconds) : 0;
+    int pitchGlide = correcting ? ModulationEngine::controlInterval : getGlide (ModulationEngine::Destination::pitch);
+
+    if (pitchGlide == 0)
+        pitchGlide = sequencerGlide;
+
+    // Diatonic intervals change with the note played, and glide there over 30 ms unless modulated or sequenced
+    int harmonyGlide = getGlide (ModulationEngine::Destination::harmony);
+
+    if (harmonyGlide == 0)
+        harmonyGlide = sequencing ? sequencerGlide : diatonic ? (int) std::ceil (currentSampleRate * 0.03) : 0;
+
+    // Sequencer steps without harmony fade the voice out rather than leave it in unison
+    const float harmonyLevel = sequencing && std::abs (harmonizerInterval) <= 0.1f
+                                 && ! modulation.modulates (ModulationEngine::Destination::harmony) ? 0.0f : 1.0f;
+
+    if (! useHarmonizer || std::exchange (snapHarmonyGain, false))
+        harmonyGain.setCurrentAndTargetValue (harmonyLevel);
+    else
+        harmonyGain.setTargetValue (harmonyLevel);
+    const int mixGlide = getGlide (ModulationEngine::Destination::mix);
+    const int feedbackGlide = getGlide (ModulationEngine::Destination::feedback);
+
+    for (int channel = 0; channel < numChains; ++channel)
+    {
+        pitchShifters[channel].setInterpolation (interpolation);
+        harmonizers[channel].setInterpolation (interpolation);
+        pitchShifters[channel].setGlide (pitchGlide, mixGlide, feedbackGlide);
+        harmonizers[channel].setGlide (harmonyGlide, 0, 0);
+        pitchShifters[channel].setLookahead (lookahead);
+        harmonizers[channel].setLookahead (lookahead);
+        pitchShifters[channel].setFreeze (freeze);
+        harmonizers[channel].setFreeze (freeze);
+        analogOctaves[channel].setMixGlide (mixGlide);
+        polyOctaves[channel].setMixGlide (mixGlide);
+        offloadedOctaves[channel].setMixGlide (mixGlide);
+        harmonyDelays[channel].setDelay (offloadLatency);
+    }
+
+    if (mixGlide != sideGainGlide)
+    {
+        sideGainGlide = mixGlide;
+        ModulationEngine::setRampLength (sideGain, mixGlide > 0 ? mixGlide : (int) std::floor (currentSampleRate * 0.02));
+    }
+
+    // Each chain has a main voice and, with the harmonizer on, a harmony voice on its own
+    // scratch channel. Voices are independent until they're mixed, so offline they run in parallel.
+    const int numVoices = useHarmonizer ? 2 : 1;
+    const int numTasks = numChains * numVoices;
+
+    // Work in place on the host's buffer, in chunks no longer than the harmonizer scratch
+    for (int offset = 0; offset < numSamples; offset += harmonyBuffer.getNumSamples())
+    {
+        const int chunkSize = juce::jmin (numSamples - offset, harmonyBuffer.getNumSamples());
+
         // Store original input for harmonizer
-        juce::AudioBuffer<float> originalBuffer (1, buffer.getNumSamples());
-        originalBuffer.copyFrom (0, 0, buffer, channel, 0, buffer.getNumSamples());
-        
-        // Process the channel with pitch shifter
-        pitchShifters[channel].processBlock (singleChannelBuffer, pitchShift, mix, feedback);
-        
-        // Process harmonizer if interval is not zero
-        if (std::abs (harmonizerInterval) > 0.1f)
+        if (useHarmonizer)
+            for (int channel = 0; channel < numChains; ++channel)
+                harmonyBuffer.copyFrom (channel, 0, buffer, channel, startSample + offset, chunkSize);
+
+        // With modulation or correction on, the chunk is processed a grid step at a time, each step with its own settings
+        const bool stepping = modulating || correcting;
+        int numSteps = 1;
+
+        if (stepping)
+        {
+            const float* input[] = { buffer.getReadPointer (0, startSample + offset),
+                                     buffer.getReadPointer (numChains - 1, startSample + offset) };
+            modulationEngine.process (modulation, input, numChains, chunkSize);
+            numSteps = modulationEngine.getNumSteps();
+        }
+        else
+        {
+            modulationEngine.advance (chunkSize);
+        }
+
+        const auto getStepEnd = [&] (int step)
         {
-            juce::AudioBuffer<float> harmonizerBuffer (1, buffer.getNumSamples());
-            harmonizerBuffer.copyFrom (0, 0, originalBuffer, 0, 0, buffer.getNumSamples());
-            
-            // Process harmonizer with 100% wet mix and no feedback
-            harmonizers[channel].processBlock (harmonizerBuffer, harmonizerInterval, 1.0f, 0.0f);
-            
-            // Mix harmonizer with main output with proper gain staging
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+            return stepping ? modulationEngine.getStepEnd (step) : chunkSize;
+        };
+
+        // Correction and the diatonic interval follow the note the first channel is playing.
+        // Correcting, the tracker is fed a step at a time, and each step aims for a new correction.
+        float chunkHarmony = harmonizerInterval;
+        const bool followHarmony = useHarmonizer && diatonic;
+
+        if (correcting || followHarmony)
+        {
+            NOCTAVE_TRACE_SCOPE ("track pitch");
+            const auto* input = buffer.getReadPointer (0, startSample + offset);
+
+            if (correcting)
+            {
+                int root = 0;
+                auto scale = Scales::Scale::major;
+                getTargetScale (root, scale);
+
+                for (int step = 0, stepStart = 0; step < numSteps; stepStart = getStepEnd (step++))
+                {
+                    pitchTracker.process (input + stepStart, getStepEnd (step) - stepStart, detectKey);
+                    stepCorrections[(size_t) step] = pitchCorrector.update (pitchTracker.getPitch(), root, scale,
+                                                                            correction == Correction::midi);
+                }
+            }
+            else
             {
-                float mainSample = singleChannelBuffer.getSample (0, sample);
-                float harmonySample = harmonizerBuffer.getSample (0, sample);
-                
-                // Limit both signals before mixing to prevent clipping (more aggressive)
-                mainSample = juce::jlimit (-0.85f, 0.85f, mainSample);
-                harmonySample = juce::jlimit (-0.85f, 0.85f, harmonySample);
-                
-                // Mix: 60% main, 40% harmony with reduced gain for headroom
-                // Additional reduction when mix is high to prevent clipping
-                float mixLevel = mixParam->load();
-                float mixScale = 1.0f - (mixLevel * 0.1f); // Reduce up to 10% more when mix is high
-                float mixed = (mainSample * 0.6f + harmonySample * 0.4f) * mixScale;
-                
-                // Apply aggressive soft limiting to prevent clipping
-                if (std::abs (mixed) > 0.8f)
+                pitchTracker.process (input, chunkSize, detectKey);
+            }
+
+            if (followHarmony)
+                chunkHarmony = (float) getDiatonicInterval (harmonizerInterval);
+        }
+
+        const auto getModulated = [&] (ModulationEngine::Destination destination, float value, float minimum, float maximum, int step)
+        {
+            return modulating ? juce::jlimit (minimum, maximum, value + modulationEngine.getOffsets (destination)[step])
+                              : value;
+        };
+
+        auto processVoice = [&] (int task)
+        {
+            const int channel = task / numVoices;
+
+            if (task % numVoices != 0)
+            {
+                NOCTAVE_TRACE_SCOPE ("harmonizer");
+
+                // Process harmonizer with 100% wet mix and no feedback
+                for (int step = 0, stepStart = 0; step < numSteps; stepStart = getStepEnd (step++))
+                {
+                    auto* harmonySamples = harmonyBuffer.getWritePointer (channel, stepStart);
+                    juce::AudioBuffer<float> harmonizerBuffer (&harmonySamples, 1, getStepEnd (step) - stepStart);
+                    harmonizers[channel].processBlock (harmonizerBuffer,
+                                                       getModulated (ModulationEngine::Destination::harmony, chunkHarmony, -12.0f, 12.0f, step),
+                                                       1.0f, 0.0f);
+                }
+
+                return;
+            }
+
+            NOCTAVE_TRACE_SCOPE ("shift channel");
+
+            for (int step = 0, stepStart = 0; step < numSteps; stepStart = getStepEnd (step++))
+            {
+                auto* channelData = buffer.getWritePointer (channel, startSample + offset + stepStart);
+                const int stepLength = getStepEnd (step) - stepStart;
+                juce::AudioBuffer<float> mainBuffer (&channelData, 1, stepLength);
+
+                float stepPitch = getModulated (ModulationEngine::Destination::pitch, pitchShift, -24.0f, 24.0f, step);
+
+                if (correcting)
+                    stepPitch = juce::jlimit (-24.0f, 24.0f, stepPitch + stepCorrections[(size_t) step]);
+                const float stepMix = getModulated (ModulationEngine::Destination::mix, mix, 0.0f, 1.0f, step);
+
+                // The octave engines follow the pitch knob to the nearest octave
+                const int octaves = juce::jlimit (-2, 2, juce::roundToInt (stepPitch / 12.0f));
+
+                // Process the channel with the selected engine
+                if (engine == Engine::analogOctave)
+                {
+                    analogOctaves[channel].process (channelData, stepLength, octaves, stepMix);
+                }
+                else if (engine == Engine::polyOctave && offload)
+                {
+                    // Offline, wait for every frame rather than dropping to the fallback
+                    offloadedOctaves[channel].setNumBands (polyBands);
+                    offloadedOctaves[channel].process (channelData, stepLength, octaves, stepMix, isNonRealtime());
+                }
+                else if (engine == Engine::polyOctave)
+                {
+                    polyOctaves[channel].setNumBands (polyBands);
+                    polyOctaves[channel].process (channelData, stepLength, octaves, stepMix);
+                }
+                else
                 {
-                    float sign = mixed > 0.0f ? 1.0f : -1.0f;
-                    float absValue = std::abs (mixed);
-                    float excess = absValue - 0.8f;
-                    mixed = sign * (0.8f + (1.0f - 0.8f) * std::tanh (excess * 6.0f));
+                    const float stepFeedback = getModulated (ModulationEngine::Destination::feedback, feedback, 0.0f, 0.5f, step);
+                    pitchShifters[channel].processBlock (mainBuffer, stepPitch, stepMix, stepFeedback);
                 }
-                
-                // Final hard limit (more conservative)
-                mixed = juce::jlimit (-0.9f, 0.9f, mixed);
-                singleChannelBuffer.setSample (0, sample, mixed);
             }
+        };
+
+        // Small chunks finish sooner than the workers would wake up
+        if (isNonRealtime() && numTasks > 1 && chunkSize >= minParallelChunkSize)
+        {
+            workerPool->run (numTasks, processVoice);
+        }
+        else
+        {
+            for (int task = 0; task < numTasks; ++task)
+                processVoice (task);
+        }
+
+        // Mid Only passes the side through. Mono Wet gives it the same gain as the dry part
+        // of the mid, so each side keeps its own dry signal under the shared wet one.
+        if (midSide)
+        {
+            auto* side = buffer.getWritePointer (1, startSample + offset);
+
+            for (int step = 0, stepStart = 0; step < numSteps; stepStart = getStepEnd (step++))
+            {
+                const float sideLevel = stereoMode == StereoMode::monoWet
+                                          ? 1.0f - getModulated (ModulationEngine::Destination::mix, mix, 0.0f, 1.0f, step)
+                                          : 1.0f;
+
+                if (std::exchange (snapSideGain, false))
+                    sideGain.setCurrentAndTargetValue (sideLevel);
+                else
+                    sideGain.setTargetValue (sideLevel);
+
+                sideGain.applyGain (side + stepStart, getStepEnd (step) - stepStart);
+            }
+        }
+
+        if (! useHarmonizer)
+            continue;
+
+        NOCTAVE_TRACE_SCOPE ("mix harmony");
+
+        // The harmony voice goes on top of the main output at unity; the output limiter catches the sum
+        harmonyGain.applyGain (harmonyBuffer, chunkSize);
+
+        for (int channel = 0; channel < numChains; ++channel)
+        {
+            harmonyDelays[channel].process (harmonyBuffer.getWritePointer (channel), chunkSize);
+            juce::FloatVectorOperations::add (buffer.getWritePointer (channel, startSample + offset),
+                                              harmonyBuffer.getReadPointer (channel), chunkSize);
         }
-        
-        // Copy processed audio back to main buffer
-        buffer.copyFrom (channel, 0, singleChannelBuffer, 0, 0, buffer.getNumSamples());
     }
+
+    if (! midSide)
+        return;
+
+    NOCTAVE_TRACE_SCOPE ("mid/side decode");
+    decodeMidSide (buffer.getWritePointer (0, startSample), buffer.getWritePointer (1, startSample), numSamples);
 }
 
 //==============================================================================
@@ -358,13 +1063,31 @@ juce::AudioProcessorEditor* NoctaveAudioProcessor::createEditor()
 //==============================================================================
 void NoctaveAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    StateFormat::write (*stateIndex, currentProgram.load(), destData);
 }
 
 void NoctaveAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    NOCTAVE_TRACE_SCOPE ("load state");
+
+    // Restored values replace whatever program the audio thread was gliding to
+    pendingProgram.store (-1);
+    programToSync.store (-1);
+    overrideProgram.store (-1);
+
+    if (StateFormat::isBinaryState (data, sizeInBytes))
+    {
+        auto program = currentProgram.load();
+
+        // The session may come from a machine with more user programs than this one
+        if (StateFormat::read (*stateIndex, data, sizeInBytes, program)
+             && juce::isPositiveAndBelow (program, presetBank->getNumPresets()))
+            currentProgram.store (program);
+
+        return;
+    }
+
+    // Sessions saved before the binary format hold the APVTS as XML
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
     if (xmlState.get() != nullptr)
@@ -406,6 +1129,204 @@ juce::AudioProcessorValueTreeState::ParameterLayout NoctaveAudioProcessor::creat
         0.0f, "semitones"
     ));
 
+    // Interpolation: kernel used to read between delay-line samples
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("INTERPOLATION", 1), "Interpolation",
+        Interpolation::getKernelNames(),
+        static_cast<int> (Interpolation::Kernel::hermite)
+    ));
+
+    // Engine: delay-line shifter, or one of the zero-latency octave engines
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("ENGINE", 1), "Engine",
+        juce::StringArray { "Delay Line", "Analog Octave", "Poly Octave" },
+        static_cast<int> (Engine::delayLine)
+    ));
+
+    // Poly Bands: filter bank size for the polyphonic octave engine
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("POLY_BANDS", 1), "Poly Bands",
+        PolyOctave::getBandCountNames(),
+        1
+    ));
+
+    // Stereo Mode: shift left and right separately, or only the mid
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("STEREO_MODE", 1), "Stereo Mode",
+        juce::StringArray { "L/R", "Mid Only", "Mono Wet" },
+        static_cast<int> (StereoMode::leftRight)
+    ));
+
+    // Limit Ceiling: true-peak level the output limiter holds the output under
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("LIMIT_CEILING", 1), "Limit Ceiling",
+        juce::NormalisableRange<float> (-12.0f, 0.0f, 0.1f),
+        -1.0f, "dB"
+    ));
+
+    // Limit Release: how quickly the limiter lets the gain recover after a peak
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("LIMIT_RELEASE", 1), "Limit Release",
+        juce::NormalisableRange<float> (10.0f, 1000.0f, 1.0f, 0.4f),
+        100.0f, "ms"
+    ));
+
+    // Transient Lookahead: how far ahead the delay line looks for onsets to splice onto. Off adds no latency
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("TRANSIENT_LOOKAHEAD", 1), "Transient Lookahead",
+        juce::NormalisableRange<float> (0.0f, (float) (PitchShifter::maxLookaheadSeconds * 1000.0), 0.5f),
+        0.0f,
+        juce::AudioParameterFloatAttributes().withStringFromValueFunction ([] (float value, int)
+        {
+            return value > 0.0f ? juce::String (value, 1) + " ms" : juce::String ("Off");
+        })
+    ));
+
+    // Harmony Mode: the harmonizer's interval as it is, or read as a step in the key's scale
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("HARMONY_MODE", 1), "Harmony Mode",
+        juce::StringArray { "Chromatic", "Diatonic" },
+        static_cast<int> (HarmonyMode::chromatic)
+    ));
+
+    // Key and Scale: what the diatonic harmonizer and pitch correction work in. Auto follows the key heard in the input
+    juce::StringArray keyNames { "Auto" };
+    keyNames.addArray (Scales::getNoteNames());
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("KEY", 1), "Key",
+        keyNames,
+        1
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("SCALE", 1), "Scale",
+        Scales::getScaleNames(),
+        static_cast<int> (Scales::Scale::major)
+    ));
+
+    // Correction: pull the delay line's pitch onto the nearest note of the scale, or of the notes held on MIDI
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("CORRECTION", 1), "Correction",
+        juce::StringArray { "Off", "Scale", "MIDI" },
+        static_cast<int> (Correction::off)
+    ));
+
+    // Retune Speed: how long correction takes to reach a new note. 0 snaps to it
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("RETUNE_SPEED", 1), "Retune Speed",
+        juce::NormalisableRange<float> (0.0f, 400.0f, 1.0f, 0.5f),
+        50.0f, "ms"
+    ));
+
+    // Humanise: how much more slowly sustained notes are retuned, so they keep their vibrato
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("HUMANISE", 1), "Humanise",
+        juce::NormalisableRange<float> (0.0f, 1.0f, 0.01f),
+        0.0f, "%"
+    ));
+
+    // Poly Offload: run the Poly Octave engine on threads shared by all instances, a block late
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID ("POLY_OFFLOAD", 1), "Poly Offload",
+        false
+    ));
+
+    // Sequencer: a pattern of pitch and harmony intervals added to the knobs, one step per
+    // synced division, locked to the host's beat
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID ("SEQ_ON", 1), "Sequencer",
+        false
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("SEQ_RATE", 1), "Sequencer Rate",
+        ModulationEngine::getDivisionNames(),
+        1
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID ("SEQ_LENGTH", 1), "Sequencer Length",
+        1, StepSequencer::maxSteps, 8
+    ));
+
+    for (int step = 1; step <= StepSequencer::maxSteps; ++step)
+    {
+        params.push_back (std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID ("SEQ_PITCH_" + juce::String (step), 1), "Step " + juce::String (step) + " Pitch",
+            juce::NormalisableRange<float> (-24.0f, 24.0f, 1.0f),
+            0.0f, "semitones"
+        ));
+
+        params.push_back (std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID ("SEQ_HARMONY_" + juce::String (step), 1), "Step " + juce::String (step) + " Harmony",
+            juce::NormalisableRange<float> (-12.0f, 12.0f, 1.0f),
+            0.0f, "semitones"
+        ));
+    }
+
+    // Freeze: hold what the Delay Line engine's voices last heard as a looping pad
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID ("FREEZE", 1), "Freeze",
+        false
+    ));
+
+    // Modulation: tempo-synced LFO, input envelope and stepped random value, each routed to
+    // one setting with a signed depth. A depth of 1 swings pitch and harmony an octave.
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("MOD_LFO_SHAPE", 1), "LFO Shape",
+        ModulationEngine::getShapeNames(),
+        static_cast<int> (ModulationEngine::Shape::sine)
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("MOD_LFO_RATE", 1), "LFO Rate",
+        ModulationEngine::getDivisionNames(),
+        ModulationEngine::getDefaultDivision()
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("MOD_LFO_TARGET", 1), "LFO Target",
+        ModulationEngine::getDestinationNames(),
+        static_cast<int> (ModulationEngine::Destination::none)
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("MOD_LFO_DEPTH", 1), "LFO Depth",
+        juce::NormalisableRange<float> (-1.0f, 1.0f, 0.01f),
+        0.0f
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("MOD_ENV_TARGET", 1), "Envelope Target",
+        ModulationEngine::getDestinationNames(),
+        static_cast<int> (ModulationEngine::Destination::none)
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("MOD_ENV_DEPTH", 1), "Envelope Depth",
+        juce::NormalisableRange<float> (-1.0f, 1.0f, 0.01f),
+        0.0f
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("MOD_RANDOM_RATE", 1), "Random Rate",
+        ModulationEngine::getDivisionNames(),
+        ModulationEngine::getDefaultDivision()
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("MOD_RANDOM_TARGET", 1), "Random Target",
+        ModulationEngine::getDestinationNames(),
+        static_cast<int> (ModulationEngine::Destination::none)
+    ));
+
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("MOD_RANDOM_DEPTH", 1), "Random Depth",
+        juce::NormalisableRange<float> (-1.0f, 1.0f, 0.01f),
+        0.0f
+    ));
+
     return { params.begin(), params.end() };
 }
 
@@ -9,6 +9,21 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PitchShifter.h"
+#include "AnalogOctave.h"
+#include "PolyOctave.h"
+#include "OffloadedPolyOctave.h"
+#include "PitchTracker.h"
+#include "PitchCorrector.h"
+#include "Scales.h"
+#include "OutputLimiter.h"
+#include "ModulationEngine.h"
+#include "StepSequencer.h"
+#include "PresetBank.h"
+#include "StateFormat.h"
+#include "WorkerPool.h"
+#include "RealtimeChecks.h"
+#include "Trace.h"
 
 //==============================================================================
 /**
@@ -17,6 +32,7 @@ class NoctaveAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::Timer
 {
 public:
     //==============================================================================
@@ -52,10 +68,57 @@ public:
     const juce::String getProgramName (int index) override;
     void changeProgramName (int index, const juce::String& newName) override;
 
+    /** Stores the current settings as a new user program. Returns its index, or -1 if the bank is full. */
+    int saveCurrentAsUserPreset (const juce::String& name);
+    const PresetBank& getPresetBank() const noexcept    { return *presetBank; }
+
+    /** Clears every engine and carries on as if samplePosition samples had already gone
+        through at the current settings, so one file can be rendered in separate chunks.
+        After getRestartWarmUpSamples() of pre-roll the delay-line engine's output is
+        exactly what a single pass would give; the octave engines only settle close to it.
+        Output still comes getLatencySamples() late, as it does in a single pass.
+    */
+    void restartAt (juce::int64 samplePosition);
+    int getRestartWarmUpSamples() const;
+
+    /** One line on what this instance's delay lines and buffers take, for the debug log. */
+    juce::String getMemoryReport() const;
+
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    /** Choices of the ENGINE parameter. */
+    enum class Engine
+    {
+        delayLine = 0,
+        analogOctave,
+        polyOctave
+    };
+
+    /** Choices of the HARMONY_MODE parameter. */
+    enum class HarmonyMode
+    {
+        chromatic = 0,
+        diatonic
+    };
+
+    /** Choices of the CORRECTION parameter. */
+    enum class Correction
+    {
+        off = 0,
+        scale,
+        midi
+    };
+
+    /** Choices of the STEREO_MODE parameter. */
+    enum class StereoMode
+    {
+        leftRight = 0,
+        midOnly,
+        monoWet
+    };
+
     //==============================================================================
     // Parameter management
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
@@ -66,36 +129,111 @@ public:
     std::atomic<float>* mixParam = nullptr;
     std::atomic<float>* feedbackParam = nullptr;
     std::atomic<float>* harmonizerParam = nullptr;
+    std::atomic<float>* interpolationParam = nullptr;
+    std::atomic<float>* engineParam = nullptr;
+    std::atomic<float>* polyBandsParam = nullptr;
+    std::atomic<float>* stereoModeParam = nullptr;
+    std::atomic<float>* limitCeilingParam = nullptr;
+    std::atomic<float>* limitReleaseParam = nullptr;
+    std::atomic<float>* transientLookaheadParam = nullptr;
+    std::atomic<float>* polyOffloadParam = nullptr;
+    std::atomic<float>* harmonyModeParam = nullptr;
+    std::atomic<float>* keyParam = nullptr;
+    std::atomic<float>* scaleParam = nullptr;
+    std::atomic<float>* correctionParam = nullptr;
+    std::atomic<float>* retuneSpeedParam = nullptr;
+    std::atomic<float>* humaniseParam = nullptr;
+    std::atomic<float>* freezeParam = nullptr;
+
+    // Modulation parameters
+    std::atomic<float>* lfoShapeParam = nullptr;
+    std::atomic<float>* lfoRateParam = nullptr;
+    std::atomic<float>* lfoTargetParam = nullptr;
+    std::atomic<float>* lfoDepthParam = nullptr;
+    std::atomic<float>* envelopeTargetParam = nullptr;
+    std::atomic<float>* envelopeDepthParam = nullptr;
+    std::atomic<float>* randomRateParam = nullptr;
+    std::atomic<float>* randomTargetParam = nullptr;
+    std::atomic<float>* randomDepthParam = nullptr;
+
+    // Step sequencer parameters, with one pitch and one harmony interval per step
+    std::atomic<float>* sequencerParam = nullptr;
+    std::atomic<float>* sequencerRateParam = nullptr;
+    std::atomic<float>* sequencerLengthParam = nullptr;
+    std::array<std::atomic<float>*, StepSequencer::maxSteps> sequencerPitchParams {};
+    std::array<std::atomic<float>*, StepSequencer::maxSteps> sequencerHarmonyParams {};
 
 private:
-    //==============================================================================
-    // Pitch shifter implementation using delay-based approach
-    class PitchShifter
-    {
-    public:
-        PitchShifter();
-        void prepare (double sampleRate, int maxBlockSize);
-        void reset();
-        void processBlock (juce::AudioBuffer<float>& buffer, float pitchShiftSemitones, float mix, float feedback);
-        
-    private:
-        static constexpr int maxDelaySamples = 44100; // 1 second at 44.1kHz
-        
-        struct Voice
-        {
-            juce::AudioBuffer<float> delayBuffer;
-            float writePosition = 0.0f;
-            float readPosition = 0.0f;
-        };
-        
-        Voice voices[1]; // Single voice for pitch shifting
-        double currentSampleRate = 44100.0;
-        float smoothedPitchShift = 0.0f;
-    };
-    
     PitchShifter pitchShifters[2]; // One per channel (stereo)
     PitchShifter harmonizers[2]; // One per channel for harmonizer
+    AnalogOctave analogOctaves[2]; // One per channel, used instead of pitchShifters in analog mode
+    PolyOctave polyOctaves[2]; // One per channel, used instead of pitchShifters in polyphonic mode
+    OffloadedPolyOctave offloadedOctaves[2]; // Used instead of polyOctaves with Poly Offload on
+    Engine activeEngine = Engine::delayLine;
+    StereoMode activeStereoMode = StereoMode::leftRight;
+    bool activeOffload = false;
+    juce::SmoothedValue<float> sideGain; // Side level in the mid/side modes
+    LookaheadDelay sideDelay; // Keeps the side in step with the mid's transient lookahead or offload
+    LookaheadDelay harmonyDelays[2]; // Keep the harmony voice in step with an offloaded main voice
+    PitchTracker pitchTracker; // Follows the first channel's notes and key for the diatonic harmonizer and pitch correction
+    Scales::NoteFollower noteFollower;
+    PitchCorrector pitchCorrector;
+    std::vector<float> stepCorrections; // Pitch correction for each grid step of a chunk, sized in prepareToPlay
+    int sideGainGlide = 0;
+    ModulationEngine modulationEngine;
+    StepSequencer stepSequencer;
+    int sequencerStep = -1; // Step being played, or -1 with the sequencer off
+    juce::SmoothedValue<float> harmonyGain; // Fades the harmony voice out on sequencer steps without harmony
+    bool snapHarmonyGain = true;
+    OutputLimiter outputLimiter; // Last in the chain; everything before it runs at unity gain
+    bool snapSideGain = true;
+    juce::AudioBuffer<float> harmonyBuffer; // Harmonizer input per chain, sized in prepareToPlay
+    juce::SharedResourcePointer<WorkerPool> workerPool; // Offline rendering, and Poly Offload's workers
     double currentSampleRate = 44100.0;
+    const DspKernels::Table* kernels = &DspKernels::getActive();
+
+    // Programs: the audio thread switches by index and reads the program's values
+    // directly (overrideProgram) until the timer has pushed them to the parameters
+    juce::SharedResourcePointer<PresetBank> presetBank;  // One bank for every instance
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<int> pendingProgram { -1 };
+    std::atomic<int> overrideProgram { -1 };
+    std::atomic<int> programToSync { -1 };
+    std::atomic<bool> isPrepared { false };
+
+    // The harmonizer's delay lines are only allocated while it's in use. The timer makes
+    // them and offers them to the audio thread, which hands them back to be freed once
+    // the harmonizer has been off for a while. Each mailbox holds one pair at a time.
+    struct HistoryMailbox
+    {
+        std::array<std::unique_ptr<PitchShifter::History>, 2> lines;
+        std::atomic<bool> full { false };
+    };
+
+    HistoryMailbox offeredHistory, retiredHistory;
+    std::atomic<bool> harmonizerHasHistory { false };
+    std::atomic<bool> releaseHarmonizerHistory { false };
+    juce::uint32 lastHarmonizerUse = 0; // Message thread only
+
+    // Hash-sorted parameter list for the binary state format, built once
+    std::unique_ptr<StateFormat::ParameterIndex> stateIndex;
+
+    void processSegment (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void limitOutput (juce::AudioBuffer<float>& buffer) noexcept;
+    ModulationEngine::Settings getModulationSettings() const noexcept;
+    int getLookaheadSamples() const noexcept;
+    int getOffloadLatencySamples() const noexcept;
+    void getTargetScale (int& root, Scales::Scale& scale) const noexcept;
+    int getDiatonicInterval (float harmonizerInterval) noexcept;
+    void updateOffloadWorkers();
+    void applyProgram (int index) noexcept;
+    void pushProgramToParameters (int index);
+    float getParameterValue (int slot, const std::atomic<float>* parameter) const noexcept;
+    bool isHarmonizerWanted() const noexcept;
+    bool sequencesHarmony() const noexcept;
+    void updateHarmonizerHistory (bool useHarmonizer);
+    void manageHarmonizerHistory();
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NoctaveAudioProcessor)
 };
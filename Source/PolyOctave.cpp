@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+    PolyOctave.cpp
+    Polyphonic octave generator built on a vectorised filter bank.
+
+  ==============================================================================
+*/
+
+#include "PolyOctave.h"
+#include "ModulationEngine.h"
+#include "RealtimeChecks.h"
+
+namespace
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    constexpr double lowestBandHz = 80.0;
+    constexpr double highestBandHz = 5000.0;
+
+    const int bandCounts[] = { 16, 32, 48, 64 };
+
+    // Band amplitudes below about -80 dBFS are treated as silence
+    constexpr float maximumInverse = 1.0e4f;
+
+    // No band gets louder than this, so an estimate that's fallen to here always climbs back
+    constexpr float minimumInverse = 0.05f;
+
+    // Two Newton steps towards 1 / sqrt (x), starting from the previous sample's estimate, which is
+    // already close since a band's envelope moves slowly. An estimate that overshoots is clamped
+    // to the bottom of the range and climbs back by half again each step.
+    Vec inverseSqrt (Vec x, Vec estimate) noexcept
+    {
+        for (int step = 0; step < 2; ++step)
+            estimate = estimate * (Vec::expand (1.5f) - x * estimate * estimate * 0.5f);
+
+        return Vec::min (Vec::max (estimate, Vec::expand (minimumInverse)), Vec::expand (maximumInverse));
+    }
+
+    // Moves the unit phasor h to half the angle of the unit phasor p = (c, s). If h is at half
+    // the previous angle, h + p * conj (h) points at half the new one, following it continuously
+    // through every turn; if h has drifted, the same step pulls it back.
+    void halveAngle (Vec c, Vec s, Vec& hx, Vec& hy, Vec& norm) noexcept
+    {
+        // The offset keeps the sum off zero when h starts out opposite the right answer
+        const auto x = hx + c * hx + s * hy + Vec::expand (1.0e-6f);
+        const auto y = hy + s * hx - c * hy;
+
+        norm = inverseSqrt (x * x + y * y, norm);
+        hx = x * norm;
+        hy = y * norm;
+    }
+}
+
+//==============================================================================
+const juce::StringArray& PolyOctave::getBandCountNames()
+{
+    static const juce::StringArray names { "16", "32", "48", "64" };
+    return names;
+}
+
+int PolyOctave::getBandCount (int choiceIndex) noexcept
+{
+    return bandCounts[juce::jlimit (0, (int) std::size (bandCounts) - 1, choiceIndex)];
+}
+
+void PolyOctave::prepare (double newSampleRate)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    sampleRate = newSampleRate;
+
+    updateCoefficients();
+
+    defaultMixGlide = (int) std::floor (sampleRate * 0.02);
+    mixGlide = 0;
+    mixAmount.reset (defaultMixGlide);
+    reset();
+}
+
+void PolyOctave::setMixGlide (int numSamples) noexcept
+{
+    if (numSamples == mixGlide)
+        return;
+
+    mixGlide = numSamples;
+    ModulationEngine::setRampLength (mixAmount, numSamples > 0 ? numSamples : defaultMixGlide);
+}
+
+void PolyOctave::reset()
+{
+    for (int group = 0; group < maxGroups; ++group)
+    {
+        ic1eq[group] = ic2eq[group] = Vec::expand (0.0f);
+        inverseEnvelope[group] = Vec::expand (1.0f);
+
+        halfX[group] = quarterX[group] = Vec::expand (1.0f);
+        halfY[group] = quarterY[group] = Vec::expand (0.0f);
+        halfNorm[group] = quarterNorm[group] = Vec::expand (0.5f);
+    }
+
+    snapToTargets = true;
+}
+
+void PolyOctave::setNumBands (int newNumBands) noexcept
+{
+    newNumBands = juce::jlimit (lanes, maxBands, newNumBands - newNumBands % lanes);
+
+    if (newNumBands == numBands)
+        return;
+
+    numBands = newNumBands;
+    numGroups = numBands / lanes;
+    updateCoefficients();
+    reset();
+}
+
+void PolyOctave::updateCoefficients() noexcept
+{
+    const auto highest = juce::jmin (highestBandHz, sampleRate * 0.4);
+    const auto ratio = std::pow (highest / lowestBandHz, 1.0 / (numBands - 1));
+
+    // Neighbouring bands cross at -3 dB
+    const auto k = (ratio - 1.0) / std::sqrt (ratio);
+
+    for (int band = 0; band < numBands; ++band)
+    {
+        const auto frequency = lowestBandHz * std::pow (ratio, band);
+        const auto g = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto c1 = 1.0 / (1.0 + g * (g + k));
+
+        const auto group = (size_t) (band / lanes);
+        const auto lane = (size_t) (band % lanes);
+        a1[group].set (lane, (float) c1);
+        a2[group].set (lane, (float) (g * c1));
+        a3[group].set (lane, (float) (g * g * c1));
+
+        // Both outputs peak at 1 / k at the centre frequency
+        bandGain[group].set (lane, (float) k);
+    }
+
+    // The bands overlap, so scale their sum to unity on average across the range
+    constexpr int numProbes = 64;
+    double totalGain = 0.0;
+
+    for (int probe = 0; probe < numProbes; ++probe)
+    {
+        const auto frequency = lowestBandHz * std::pow (highest / lowestBandHz, (probe + 0.5) / numProbes);
+        std::complex<double> response;
+
+        for (int band = 0; band < numBands; ++band)
+        {
+            const std::complex<double> s (0.0, frequency / (lowestBandHz * std::pow (ratio, band)));
+            response += k * s / (s * s + k * s + 1.0);
+        }
+
+        totalGain += std::abs (response);
+    }
+
+    outputGain = (float) (numProbes / totalGain);
+}
+
+//==============================================================================
+template <int Octaves>
+float PolyOctave::processSample (float input) noexcept
+{
+    const auto in = Vec::expand (input);
+    auto sum = Vec::expand (0.0f);
+
+    for (int group = 0; group < numGroups; ++group)
+    {
+        // Trapezoidal state-variable filter. v1 is the band-pass output and v2 the low-pass,
+        // which lags it by exactly 90 degrees at every frequency.
+        const auto v3 = in - ic2eq[group];
+        const auto v1 = a1[group] * ic1eq[group] + a2[group] * v3;
+        const auto v2 = ic2eq[group] + a2[group] * ic1eq[group] + a3[group] * v3;
+        ic1eq[group] = v1 * 2.0f - ic1eq[group];
+        ic2eq[group] = v2 * 2.0f - ic2eq[group];
+
+        const auto re = v1 * bandGain[group];
+        const auto im = v2 * bandGain[group];
+        const auto amplitudeSquared = re * re + im * im;
+
+        inverseEnvelope[group] = inverseSqrt (amplitudeSquared, inverseEnvelope[group]);
+        const auto amplitude = amplitudeSquared * inverseEnvelope[group];
+        const auto c = re * inverseEnvelope[group];
+        const auto s = im * inverseEnvelope[group];
+
+        if constexpr (Octaves == 1)
+        {
+            sum += amplitude * (c * c - s * s);
+        }
+        else if constexpr (Octaves == 2)
+        {
+            const auto c2 = c * c - s * s;
+            const auto s2 = c * s * 2.0f;
+            sum += amplitude * (c2 * c2 - s2 * s2);
+        }
+        else
+        {
+            halveAngle (c, s, halfX[group], halfY[group], halfNorm[group]);
+
+            if constexpr (Octaves == -1)
+            {
+                sum += amplitude * halfX[group];
+            }
+            else
+            {
+                halveAngle (halfX[group], halfY[group], quarterX[group], quarterY[group], quarterNorm[group]);
+                sum += amplitude * quarterX[group];
+            }
+        }
+    }
+
+    return sum.sum() * outputGain;
+}
+
+void PolyOctave::process (float* samples, int numSamples, int octaves, float mix) noexcept
+{
+    if (snapToTargets)
+    {
+        mixAmount.setCurrentAndTargetValue (mix);
+        snapToTargets = false;
+    }
+    else
+    {
+        mixAmount.setTargetValue (mix);
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Same unity-gain crossfade as the other engines, so switching keeps the level
+        const float dry = samples[i];
+
+        float wet = dry;
+
+        switch (octaves)
+        {
+            case -2:    wet = processSample<-2> (dry); break;
+            case -1:    wet = processSample<-1> (dry); break;
+            case 1:     wet = processSample<1> (dry); break;
+            case 2:     wet = processSample<2> (dry); break;
+            default:    break;
+        }
+
+        const float currentMix = mixAmount.getNextValue();
+        samples[i] = dry * (1.0f - currentMix) + wet * currentMix;
+    }
+}
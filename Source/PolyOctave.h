@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    PolyOctave.h
+    Polyphonic octave generator built on a vectorised filter bank.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Polyphonic octaves in the style of a POG pedal: the input is split into
+    narrow bands, each band is shifted by an octave on its own, and the bands
+    are summed. A chord is shifted note by note, as long as its notes fall in
+    different bands, and nothing is buffered, so there is no added latency
+    beyond the filters' own group delay.
+
+    Each band is a state-variable filter whose band-pass and low-pass outputs
+    are exactly 90 degrees apart, so together they give the band's envelope
+    and phase. Octaves up square the phase, and octaves down halve it with a
+    recursion that follows it continuously. Everything is multiplies and adds,
+    so the filter states are stored structure-of-arrays in SIMDRegisters and
+    one instruction advances SIMDRegister<float>::size() bands.
+*/
+class PolyOctave
+{
+public:
+    static constexpr int maxBands = 64;
+
+    /** Choices of the POLY_BANDS parameter and the band count for each. */
+    static const juce::StringArray& getBandCountNames();
+    static int getBandCount (int choiceIndex) noexcept;
+
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Re-tunes the bank for a new band count. Doesn't allocate, so it's safe on the audio thread. */
+    void setNumBands (int newNumBands) noexcept;
+    int getNumBands() const noexcept    { return numBands; }
+
+    /** Samples the mix takes to glide to a new setting. Zero keeps the default glide. */
+    void setMixGlide (int numSamples) noexcept;
+
+    /** Processes samples in place. octaves is -2 to 2; 0 passes the input through as the wet signal. */
+    void process (float* samples, int numSamples, int octaves, float mix) noexcept;
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+    static constexpr int lanes = (int) Vec::size();
+    static constexpr int maxGroups = maxBands / lanes;
+
+    template <int Octaves>
+    float processSample (float input) noexcept;
+
+    void updateCoefficients() noexcept;
+
+    // Per-band coefficients and state, one SIMDRegister per group of lanes bands
+    std::array<Vec, maxGroups> a1, a2, a3, bandGain;
+    std::array<Vec, maxGroups> ic1eq, ic2eq;
+    std::array<Vec, maxGroups> inverseEnvelope;                    // tracks 1 / band amplitude
+    std::array<Vec, maxGroups> halfX, halfY, halfNorm;             // unit phasor at half the band's phase
+    std::array<Vec, maxGroups> quarterX, quarterY, quarterNorm;    // ... and at a quarter
+
+    double sampleRate = 44100.0;
+    int numBands = 32;
+    int numGroups = 32 / lanes;
+    float outputGain = 1.0f;
+
+    juce::SmoothedValue<float> mixAmount;
+    int defaultMixGlide = 0, mixGlide = 0;
+    bool snapToTargets = true;
+};
@@ -0,0 +1,311 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    Factory and user programs, held in memory for instant recall.
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include "RealtimeChecks.h"
+#include "StepSequencer.h"
+
+namespace
+{
+    constexpr char presetFileMagic[4] = { 'N', 'P', 'R', 'B' };
+    constexpr int presetFileVersion = 1;
+
+    // Switches for playing live and for where the work runs, not part of a sound, and the
+    // settings a program change couldn't switch mid-note without a click: the engine and
+    // stereo layout restart the shifters, the band count clears the filter bank, and the
+    // lookahead moves the dry signal and the latency
+    const char* const unstoredParameterIDs[] = { "FREEZE", "POLY_OFFLOAD", "ENGINE", "STEREO_MODE",
+                                                 "POLY_BANDS", "TRANSIENT_LOOKAHEAD" };
+}
+
+//==============================================================================
+PresetBank::PresetBank()
+{
+    const auto& ids = getParameterIDs();
+    jassert (ids.size() == numSlots && numSlots <= maxParameters);
+    jassert (ids[sequencerPitchSlot] == "SEQ_PITCH_1" && ids[sequencerHarmonySlot] == "SEQ_HARMONY_1");
+    jassert (ids[lfoShapeSlot] == "MOD_LFO_SHAPE" && ids[randomDepthSlot] == "MOD_RANDOM_DEPTH");
+    juce::ignoreUnused (ids);
+}
+
+const juce::StringArray& PresetBank::getParameterIDs()
+{
+    static const juce::StringArray ids = []
+    {
+        juce::StringArray list { "PITCH_SHIFT", "MIX", "FEEDBACK", "HARMONIZER",
+                                 "INTERPOLATION", "LIMIT_CEILING", "LIMIT_RELEASE",
+                                 "HARMONY_MODE", "KEY", "SCALE",
+                                 "CORRECTION", "RETUNE_SPEED", "HUMANISE",
+                                 "SEQ_ON", "SEQ_RATE", "SEQ_LENGTH" };
+
+        for (int step = 1; step <= StepSequencer::maxSteps; ++step)
+            list.add ("SEQ_PITCH_" + juce::String (step));
+
+        for (int step = 1; step <= StepSequencer::maxSteps; ++step)
+            list.add ("SEQ_HARMONY_" + juce::String (step));
+
+        list.addArray (juce::StringArray { "MOD_LFO_SHAPE", "MOD_LFO_RATE", "MOD_LFO_TARGET", "MOD_LFO_DEPTH",
+                                           "MOD_ENV_TARGET", "MOD_ENV_DEPTH",
+                                           "MOD_RANDOM_RATE", "MOD_RANDOM_TARGET", "MOD_RANDOM_DEPTH" });
+        return list;
+    }();
+
+    return ids;
+}
+
+juce::uint32 PresetBank::hashParameterID (const juce::String& parameterID) noexcept
+{
+    juce::uint32 hash = 2166136261u;
+
+    for (auto* p = parameterID.toRawUTF8(); *p != 0; ++p)
+    {
+        hash ^= (juce::uint8) *p;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+//==============================================================================
+void PresetBank::initialise (juce::AudioProcessorValueTreeState& state)
+{
+    // Instances share the bank, and may be created on different threads
+    std::call_once (initialised, [this, &state]
+    {
+        const auto& ids = getParameterIDs();
+
+        for (int slot = 0; slot < ids.size(); ++slot)
+            if (auto* parameter = state.getParameter (ids[slot]))
+                defaults[(size_t) slot] = parameter->convertFrom0to1 (parameter->getDefaultValue());
+
+       #if JUCE_DEBUG
+        // A parameter missing from the list would be silently left out of every program
+        for (auto* parameter : state.processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+                jassert (ids.contains (ranged->getParameterID())
+                          || std::find (std::begin (unstoredParameterIDs), std::end (unstoredParameterIDs),
+                                        ranged->getParameterID()) != std::end (unstoredParameterIDs));
+       #endif
+
+        // Reserve every slot now so entries never move once the audio thread can see them
+        presets.clear();
+        presets.reserve (64 + maxUserPresets);
+        numPresets.store (0);
+
+        addFactoryPreset ("Init",               {});
+        addFactoryPreset ("Octave Down",        { { "PITCH_SHIFT", -12.0f } });
+        addFactoryPreset ("Octave Up",          { { "PITCH_SHIFT",  12.0f } });
+        addFactoryPreset ("Two Octaves Down",   { { "PITCH_SHIFT", -24.0f } });
+        addFactoryPreset ("Two Octaves Up",     { { "PITCH_SHIFT",  24.0f } });
+        addFactoryPreset ("Sub Blend",          { { "PITCH_SHIFT", -12.0f }, { "MIX", 0.5f } });
+        addFactoryPreset ("Fifth Harmony",      { { "MIX", 0.0f }, { "HARMONIZER", 7.0f } });
+        addFactoryPreset ("Third Harmony",      { { "MIX", 0.0f }, { "HARMONIZER", 4.0f } });
+        addFactoryPreset ("Octave + Fifth",     { { "PITCH_SHIFT", -12.0f }, { "MIX", 0.6f }, { "HARMONIZER", 7.0f } });
+        addFactoryPreset ("Detune",             { { "PITCH_SHIFT", 0.2f }, { "MIX", 0.5f } });
+        addFactoryPreset ("Shimmer",            { { "PITCH_SHIFT", 12.0f }, { "MIX", 0.4f }, { "FEEDBACK", 0.35f } });
+        addFactoryPreset ("Crypt Descent",      { { "PITCH_SHIFT", -5.0f }, { "MIX", 0.7f }, { "FEEDBACK", 0.45f } });
+
+        numFactoryPresets = (int) presets.size();
+        loadUserPresets (getUserPresetFile());
+    });
+}
+
+PresetBank::Preset& PresetBank::appendPreset()
+{
+    jassert (presets.size() < presets.capacity());
+
+    presets.emplace_back();
+    auto& preset = presets.back();
+    preset.values = defaults;
+    return preset;
+}
+
+void PresetBank::addFactoryPreset (const juce::String& name, std::initializer_list<std::pair<const char*, float>> overrides)
+{
+    auto& preset = appendPreset();
+    preset.name = name;
+    preset.isFactory = true;
+
+    for (const auto& [parameterID, value] : overrides)
+    {
+        const auto slot = getParameterIDs().indexOf (parameterID);
+        jassert (slot >= 0);
+
+        if (slot >= 0)
+            preset.values[(size_t) slot] = value;
+    }
+
+    numPresets.store ((int) presets.size(), std::memory_order_release);
+}
+
+//==============================================================================
+int PresetBank::addUserPreset (const juce::String& name, juce::AudioProcessorValueTreeState& state)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    if ((int) presets.size() >= numFactoryPresets + maxUserPresets)
+        return -1;
+
+    auto& preset = appendPreset();
+    preset.name = name;
+
+    const auto& ids = getParameterIDs();
+
+    for (int slot = 0; slot < ids.size(); ++slot)
+        if (auto* value = state.getRawParameterValue (ids[slot]))
+            preset.values[(size_t) slot] = value->load();
+
+    // Publish only once the entry is complete
+    numPresets.store ((int) presets.size(), std::memory_order_release);
+
+    saveUserPresets (getUserPresetFile());
+    return (int) presets.size() - 1;
+}
+
+void PresetBank::renamePreset (int index, const juce::String& newName)
+{
+    if (juce::isPositiveAndBelow (index, getNumPresets()) && ! presets[(size_t) index].isFactory)
+    {
+        presets[(size_t) index].name = newName;
+        saveUserPresets (getUserPresetFile());
+    }
+}
+
+//==============================================================================
+juce::File PresetBank::getUserPresetFile()
+{
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+             .getChildFile (JucePlugin_Manufacturer)
+             .getChildFile (JucePlugin_Name)
+             .getChildFile ("UserPresets.nprb");
+}
+
+bool PresetBank::loadUserPresets (const juce::File& file)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    juce::MemoryBlock data;
+
+    if (! file.existsAsFile() || ! file.loadFileAsData (data))
+        return false;
+
+    juce::MemoryInputStream input (data, false);
+
+    char magic[4] = {};
+    if (input.read (magic, 4) != 4 || std::memcmp (magic, presetFileMagic, 4) != 0)
+        return false;
+
+    const int version = (juce::uint16) input.readShort();
+    const int numFileParameters = (juce::uint16) input.readShort();
+    const int numFilePresets = input.readInt();
+
+    if (version > presetFileVersion || numFilePresets < 0
+         || (juce::int64) numFilePresets * 8 + (juce::int64) numFileParameters * 4 > (juce::int64) data.getSize())
+        return false;
+
+    // Map each column in the file onto one of our slots, or -1 if we don't know it
+    const auto& ids = getParameterIDs();
+    std::vector<int> slotForColumn ((size_t) numFileParameters, -1);
+
+    for (int column = 0; column < numFileParameters; ++column)
+    {
+        const auto hash = (juce::uint32) input.readInt();
+
+        for (int slot = 0; slot < ids.size(); ++slot)
+            if (hashParameterID (ids[slot]) == hash)
+                slotForColumn[(size_t) column] = slot;
+    }
+
+    struct IndexEntry { int nameOffset, nameLength; };
+    std::vector<IndexEntry> index;
+
+    for (int i = 0; i < numFilePresets; ++i)
+    {
+        const int nameOffset = input.readInt();
+        const int nameLength = (juce::uint16) input.readShort();
+        input.skipNextBytes (2);
+        index.push_back ({ nameOffset, nameLength });
+    }
+
+    const auto valuesStart = input.getPosition();
+    const auto namesStart = valuesStart + (juce::int64) numFilePresets * numFileParameters * (juce::int64) sizeof (float);
+
+    if (namesStart > (juce::int64) data.getSize())
+        return false;
+
+    const int numToLoad = juce::jmin (numFilePresets, numFactoryPresets + maxUserPresets - (int) presets.size());
+
+    for (int i = 0; i < numToLoad; ++i)
+    {
+        auto& preset = appendPreset();
+
+        for (int column = 0; column < numFileParameters; ++column)
+        {
+            const auto value = input.readFloat();
+
+            if (const auto slot = slotForColumn[(size_t) column]; slot >= 0)
+                preset.values[(size_t) slot] = value;
+        }
+
+        const auto& entry = index[(size_t) i];
+        const auto nameStart = namesStart + entry.nameOffset;
+
+        // Offsets come from the file, so a damaged one mustn't reach outside the name blob
+        if (entry.nameOffset >= 0 && entry.nameLength >= 0
+             && nameStart + entry.nameLength <= (juce::int64) data.getSize())
+            preset.name = juce::String::fromUTF8 (static_cast<const char*> (data.getData()) + nameStart, entry.nameLength);
+
+        if (preset.name.isEmpty())
+            preset.name = "User " + juce::String (i + 1);
+    }
+
+    numPresets.store ((int) presets.size(), std::memory_order_release);
+    return true;
+}
+
+bool PresetBank::saveUserPresets (const juce::File& file) const
+{
+    RealtimeChecks::assertNotRealtime();
+
+    const auto& ids = getParameterIDs();
+    const int numUserPresets = getNumPresets() - numFactoryPresets;
+
+    juce::MemoryOutputStream output;
+    juce::MemoryOutputStream names;
+
+    output.write (presetFileMagic, 4);
+    output.writeShort ((short) presetFileVersion);
+    output.writeShort ((short) ids.size());
+    output.writeInt (numUserPresets);
+
+    for (const auto& parameterID : ids)
+        output.writeInt ((int) hashParameterID (parameterID));
+
+    for (int i = 0; i < numUserPresets; ++i)
+    {
+        const auto& name = presets[(size_t) (numFactoryPresets + i)].name;
+        const auto numBytes = juce::jmin ((int) name.getNumBytesAsUTF8(), 0xffff);
+
+        output.writeInt ((int) names.getDataSize());
+        output.writeShort ((short) numBytes);
+        output.writeShort (0);
+        names.write (name.toRawUTF8(), (size_t) numBytes);
+    }
+
+    for (int i = 0; i < numUserPresets; ++i)
+        for (int slot = 0; slot < ids.size(); ++slot)
+            output.writeFloat (presets[(size_t) (numFactoryPresets + i)].values[(size_t) slot]);
+
+    output << names.getMemoryBlock();
+
+    if (file.getParentDirectory().createDirectory().failed())
+        return false;
+
+    return file.replaceWithData (output.getData(), output.getDataSize());
+}
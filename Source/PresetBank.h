@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    Factory and user programs, held in memory for instant recall.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <mutex>
+#include "StepSequencer.h"
+
+//==============================================================================
+/**
+    Holds every program the plugin offers: the factory set compiled in, plus
+    user presets loaded once from a compact indexed file.
+
+    Storage for all programs is reserved up front and entries are never moved,
+    so the audio thread can read a program's values while the message thread
+    adds new user presets. Only the message thread touches names or the file.
+
+    Every plugin instance in the process shares one bank through a
+    juce::SharedResourcePointer, so the user file is read once, by the first
+    instance, and a preset saved in one instance is offered by all of them.
+
+    User preset file layout (little-endian):
+
+        char[4]   magic "NPRB"
+        uint16    format version
+        uint16    number of parameters (P)
+        uint32    number of presets (N)
+        uint32[P] parameter ID hashes
+        N x { uint32 name offset, uint16 name length, uint16 reserved }
+        N x P     float32 plain parameter values
+        UTF-8     name blob
+
+    Parameters are matched by ID hash, so presets saved by an older or newer
+    build load with any unknown parameters ignored and missing ones at default.
+*/
+class PresetBank
+{
+public:
+    static constexpr int maxParameters = 96;
+    static constexpr int maxUserPresets = 128;
+
+    /** Slot of each parameter in Preset::values; matches getParameterIDs(). */
+    enum ParameterSlot
+    {
+        pitchShiftSlot = 0,
+        mixSlot,
+        feedbackSlot,
+        harmonizerSlot,
+        interpolationSlot,
+        limitCeilingSlot,
+        limitReleaseSlot,
+        harmonyModeSlot,
+        keySlot,
+        scaleSlot,
+        correctionSlot,
+        retuneSpeedSlot,
+        humaniseSlot,
+        sequencerSlot,
+        sequencerRateSlot,
+        sequencerLengthSlot,
+        sequencerPitchSlot,                                             // One per step from here
+        sequencerHarmonySlot = sequencerPitchSlot + StepSequencer::maxSteps,
+        lfoShapeSlot = sequencerHarmonySlot + StepSequencer::maxSteps,
+        lfoRateSlot,
+        lfoTargetSlot,
+        lfoDepthSlot,
+        envelopeTargetSlot,
+        envelopeDepthSlot,
+        randomRateSlot,
+        randomTargetSlot,
+        randomDepthSlot,
+        numSlots
+    };
+
+    struct Preset
+    {
+        juce::String name;
+        std::array<float, maxParameters> values {};  // plain values, in getParameterIDs() order
+        bool isFactory = false;
+    };
+
+    PresetBank();
+
+    /** Parameters stored in a program, in slot order: every parameter but the
+        performance switches (Freeze and Offload) and the settings that restart
+        the shifters or change the latency (Engine, Stereo Mode, Poly Bands and
+        Transient Lookahead), which program changes leave alone. A new parameter
+        has to be added here and to ParameterSlot too, or initialise() asserts.
+    */
+    static const juce::StringArray& getParameterIDs();
+
+    /** Stable 32-bit FNV-1a hash used to identify parameters in binary files. */
+    static juce::uint32 hashParameterID (const juce::String& parameterID) noexcept;
+
+    /** Fills in factory defaults from the parameter layout and loads the user file.
+        Only the first call does anything; later instances find the bank ready.
+    */
+    void initialise (juce::AudioProcessorValueTreeState& state);
+
+    int getNumPresets() const noexcept                     { return numPresets.load (std::memory_order_acquire); }
+    int getNumFactoryPresets() const noexcept              { return numFactoryPresets; }
+    const Preset& getPreset (int index) const noexcept     { return presets[(size_t) index]; }
+
+    /** Captures the current parameter values as a new user preset and saves the file.
+        Returns the new program index, or -1 if the bank is full.
+    */
+    int addUserPreset (const juce::String& name, juce::AudioProcessorValueTreeState& state);
+
+    void renamePreset (int index, const juce::String& newName);
+
+    static juce::File getUserPresetFile();
+    bool loadUserPresets (const juce::File& file);
+    bool saveUserPresets (const juce::File& file) const;
+
+private:
+    void addFactoryPreset (const juce::String& name, std::initializer_list<std::pair<const char*, float>> overrides);
+    Preset& appendPreset();
+
+    std::vector<Preset> presets;
+    std::atomic<int> numPresets { 0 };
+    int numFactoryPresets = 0;
+    std::array<float, maxParameters> defaults {};
+    std::once_flag initialised;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    RealtimeChecks.h
+    Debug-build checks that the audio callback stays realtime-safe.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Catches realtime-safety regressions while developing, at no cost in release
+    builds, where everything here compiles to nothing.
+
+    processBlock marks its thread with a ScopedRealtimeRender while the host is
+    rendering in realtime. Anything that allocates, takes locks, does file I/O
+    or waits on other threads starts with assertNotRealtime(), so calling it
+    from the callback by mistake stops in the debugger instead of glitching
+    now and then in a session. checkOutput() catches NaNs, infinities and
+    denormals leaving the plugin.
+*/
+namespace RealtimeChecks
+{
+   #if JUCE_DEBUG
+    inline bool& realtimeFlag() noexcept
+    {
+        thread_local bool isRealtime = false;
+        return isRealtime;
+    }
+   #endif
+
+    /** True on a thread that's inside a realtime processBlock. Always false in release builds. */
+    inline bool isRealtimeThread() noexcept
+    {
+       #if JUCE_DEBUG
+        return realtimeFlag();
+       #else
+        return false;
+       #endif
+    }
+
+    /** Marks the calling thread as rendering in realtime for the object's lifetime.
+        Offline renders may block, so they pass false and aren't marked.
+    */
+    class ScopedRealtimeRender
+    {
+    public:
+        explicit ScopedRealtimeRender (bool isRealtime) noexcept
+        {
+           #if JUCE_DEBUG
+            previous = std::exchange (realtimeFlag(), isRealtime);
+           #else
+            juce::ignoreUnused (isRealtime);
+           #endif
+        }
+
+        ~ScopedRealtimeRender()
+        {
+           #if JUCE_DEBUG
+            realtimeFlag() = previous;
+           #endif
+        }
+
+    private:
+       #if JUCE_DEBUG
+        bool previous = false;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeRender)
+    };
+
+    /** Put at the top of anything that mustn't run inside the realtime callback. */
+    inline void assertNotRealtime() noexcept
+    {
+        jassert (! isRealtimeThread());
+    }
+
+    /** Asserts that every sample leaving the plugin is finite and not denormal. */
+    inline void checkOutput (const juce::AudioBuffer<float>& buffer) noexcept
+    {
+       #if JUCE_DEBUG
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            const auto* samples = buffer.getReadPointer (channel);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                jassert (std::isfinite (samples[i]));
+                jassert (samples[i] == 0.0f || std::abs (samples[i]) >= std::numeric_limits<float>::min());
+            }
+        }
+       #else
+        juce::ignoreUnused (buffer);
+       #endif
+    }
+}
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    Scales.cpp
+    Keys, scales and diatonic intervals for the scale-aware harmonizer.
+
+  ==============================================================================
+*/
+
+#include "Scales.h"
+
+namespace
+{
+    struct Degrees
+    {
+        std::array<int, 12> semitones;
+        int size;
+    };
+
+    const Degrees& getDegrees (Scales::Scale scale) noexcept
+    {
+        static const std::array<Degrees, 8> degrees
+        {{
+            { { 0, 2, 4, 5, 7, 9, 11 }, 7 },    // Major
+            { { 0, 2, 3, 5, 7, 8, 10 }, 7 },    // Natural Minor
+            { { 0, 2, 3, 5, 7, 8, 11 }, 7 },    // Harmonic Minor
+            { { 0, 2, 3, 5, 7, 9, 10 }, 7 },    // Dorian
+            { { 0, 1, 3, 5, 7, 8, 10 }, 7 },    // Phrygian
+            { { 0, 2, 4, 6, 7, 9, 11 }, 7 },    // Lydian
+            { { 0, 2, 4, 5, 7, 9, 10 }, 7 },    // Mixolydian
+            { { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 }, 12 }
+        }};
+
+        return degrees[(size_t) juce::jlimit (0, (int) degrees.size() - 1, static_cast<int> (scale))];
+    }
+
+    int floorDivide (int value, int divisor) noexcept
+    {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    int positiveModulo (int value, int divisor) noexcept
+    {
+        return value - divisor * floorDivide (value, divisor);
+    }
+
+    // Hold a note until the pitch is this many semitones away from it
+    constexpr float noteHysteresis = 0.75f;
+}
+
+//==============================================================================
+const juce::StringArray& Scales::getScaleNames()
+{
+    static const juce::StringArray names { "Major", "Natural Minor", "Harmonic Minor", "Dorian",
+                                           "Phrygian", "Lydian", "Mixolydian", "Chromatic" };
+    return names;
+}
+
+const juce::StringArray& Scales::getNoteNames()
+{
+    static const juce::StringArray names { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    return names;
+}
+
+bool Scales::contains (int root, Scale scale, int pitchClass) noexcept
+{
+    const auto& degrees = getDegrees (scale);
+    const int relative = positiveModulo (pitchClass - root, 12);
+
+    return std::find (degrees.semitones.begin(), degrees.semitones.begin() + degrees.size, relative)
+             != degrees.semitones.begin() + degrees.size;
+}
+
+int Scales::getNearestNote (float midiNote, int root, Scale scale) noexcept
+{
+    // Every scale here has a note within a tone of any pitch, so two either side is enough
+    const int below = (int) std::floor (midiNote);
+    int nearest = below;
+    float nearestDistance = std::numeric_limits<float>::max();
+
+    for (int note = below - 2; note <= below + 3; ++note)
+    {
+        const float distance = std::abs ((float) note - midiNote);
+
+        if (contains (root, scale, note) && distance < nearestDistance)
+        {
+            nearest = note;
+            nearestDistance = distance;
+        }
+    }
+
+    return nearest;
+}
+
+int Scales::getScaleSteps (int semitones, Scale scale) noexcept
+{
+    if (getDegrees (scale).size == 12)
+        return semitones;
+
+    // Seconds, thirds, sixths and sevenths come major or minor; the tritone counts as a fifth
+    static constexpr std::array<int, 12> stepsForSemitones { 0, 1, 1, 2, 2, 3, 4, 4, 5, 5, 6, 6 };
+
+    const int size = std::abs (semitones);
+    const int steps = 7 * (size / 12) + stepsForSemitones[(size_t) (size % 12)];
+
+    return semitones < 0 ? -steps : steps;
+}
+
+int Scales::getDiatonicInterval (int note, int root, Scale scale, int steps) noexcept
+{
+    const auto& degrees = getDegrees (scale);
+    const int scaleNote = getNearestNote ((float) note, root, scale);
+
+    const int relative = scaleNote - root;
+    const int octave = floorDivide (relative, 12);
+    const int degree = (int) (std::find (degrees.semitones.begin(), degrees.semitones.begin() + degrees.size,
+                                         positiveModulo (relative, 12)) - degrees.semitones.begin());
+
+    const int target = degree + steps;
+    const int targetNote = root + 12 * (octave + floorDivide (target, degrees.size))
+                             + degrees.semitones[(size_t) positiveModulo (target, degrees.size)];
+
+    return targetNote - scaleNote;
+}
+
+//==============================================================================
+int Scales::NoteFollower::update (float frequency) noexcept
+{
+    if (frequency <= 0.0f)
+        return note;
+
+    const float played = frequencyToNote (frequency);
+
+    if (note < 0 || std::abs (played - (float) note) > noteHysteresis)
+        note = juce::roundToInt (played);
+
+    return note;
+}
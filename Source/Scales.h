@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    Scales.h
+    Keys, scales and diatonic intervals for the scale-aware harmonizer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Note arithmetic in a key. Notes are MIDI note numbers and pitch classes
+    count semitones up from C.
+*/
+namespace Scales
+{
+    /** Choices of the SCALE parameter. */
+    enum class Scale
+    {
+        major = 0,
+        naturalMinor,
+        harmonicMinor,
+        dorian,
+        phrygian,
+        lydian,
+        mixolydian,
+        chromatic
+    };
+
+    const juce::StringArray& getScaleNames();
+
+    /** "C" to "B". */
+    const juce::StringArray& getNoteNames();
+
+    /** True if the pitch class is in the scale on root. */
+    bool contains (int root, Scale scale, int pitchClass) noexcept;
+
+    /** The note of the scale nearest a fractional MIDI note. Ties go down. */
+    int getNearestNote (float midiNote, int root, Scale scale) noexcept;
+
+    /** Scale steps for an interval given in semitones, read as the interval it
+        names: 3 or 4 semitones is a third (2 steps), 7 a fifth (4 steps), 12 an
+        octave (7 steps). In the chromatic scale steps are semitones.
+    */
+    int getScaleSteps (int semitones, Scale scale) noexcept;
+
+    /** Semitones from note to the note steps scale steps away from it. A note
+        outside the scale gets the interval of the scale note nearest to it.
+    */
+    int getDiatonicInterval (int note, int root, Scale scale, int steps) noexcept;
+
+    /** Fractional MIDI note of a frequency in Hz, at A4 = 440 Hz. */
+    inline float frequencyToNote (float frequency) noexcept
+    {
+        return 69.0f + 12.0f * std::log2 (frequency / 440.0f);
+    }
+
+    //==============================================================================
+    /**
+        Follows which note is being played from a stream of pitch estimates. It
+        holds a note until the pitch is most of a semitone away from it, so
+        vibrato or a slightly sharp note doesn't flip between neighbours.
+    */
+    class NoteFollower
+    {
+    public:
+        void reset() noexcept   { note = -1; }
+
+        /** Takes a pitch in Hz, or 0 while unvoiced, which holds the last note.
+            Returns the note, or -1 if nothing has been played yet.
+        */
+        int update (float frequency) noexcept;
+
+        int getNote() const noexcept    { return note; }
+
+    private:
+        int note = -1;
+    };
+}
@@ -0,0 +1,394 @@
+/*
+  ==============================================================================
+
+    SourceAnalysis.cpp
+    Offline pitch, onset and transient analysis of whole audio sources.
+
+  ==============================================================================
+*/
+
+#include "SourceAnalysis.h"
+
+namespace
+{
+    constexpr float lowestPitchHz = 60.0f;
+    constexpr float highestPitchHz = 1500.0f;
+
+    // YIN: first dip of the normalised difference below this is the period...
+    constexpr float pitchThreshold = 0.15f;
+
+    // ...and if nothing dips below this the frame is unvoiced
+    constexpr float voicingThreshold = 0.35f;
+
+    // Frames quieter than about -60 dBFS RMS are treated as silence
+    constexpr float silenceMeanSquare = 1.0e-6f;
+
+    constexpr int fluxAverageHops = 8;
+    constexpr float onsetTransientRatio = 1.5f;
+    constexpr float minimumOnsetFlux = 5.0f;
+    constexpr int minimumOnsetSpacingHops = 3;
+    constexpr int onsetRefineBlock = 32;
+}
+
+//==============================================================================
+float SourceAnalysis::getPitchAt (juce::int64 sample) const noexcept
+{
+    if (sample < 0 || sample >= numSamples)
+        return 0.0f;
+
+    const auto& chunk = chunks[(size_t) (sample / chunkSize)];
+    return chunk != nullptr ? chunk->pitch[(size_t) ((sample % chunkSize) / hopSize)] : 0.0f;
+}
+
+float SourceAnalysis::getTransientAt (juce::int64 sample) const noexcept
+{
+    if (sample < 0 || sample >= numSamples)
+        return 0.0f;
+
+    const auto& chunk = chunks[(size_t) (sample / chunkSize)];
+    return chunk != nullptr ? chunk->transient[(size_t) ((sample % chunkSize) / hopSize)] : 0.0f;
+}
+
+void SourceAnalysis::getOnsets (juce::int64 start, juce::int64 end, std::vector<juce::int64>& result) const
+{
+    start = juce::jmax ((juce::int64) 0, start);
+    end = juce::jmin (numSamples, end);
+
+    for (auto chunkIndex = start / chunkSize; chunkIndex * chunkSize < end; ++chunkIndex)
+    {
+        const auto& chunk = chunks[(size_t) chunkIndex];
+
+        if (chunk == nullptr)
+            continue;
+
+        for (auto offset : chunk->onsets)
+        {
+            const auto position = chunkIndex * chunkSize + offset;
+
+            if (position >= start && position < end)
+                result.push_back (position);
+        }
+    }
+}
+
+void SourceAnalysis::getChunkInput (const juce::AudioBuffer<float>& audio, int chunkIndex, float* mono) noexcept
+{
+    const int inputSize = chunkSize + 2 * chunkMargin;
+    const auto inputStart = (juce::int64) chunkIndex * chunkSize - chunkMargin;
+
+    juce::FloatVectorOperations::clear (mono, inputSize);
+
+    const auto first = (int) juce::jmax ((juce::int64) 0, inputStart);
+    const auto last = (int) juce::jmin ((juce::int64) audio.getNumSamples(), inputStart + inputSize);
+
+    if (last <= first || audio.getNumChannels() == 0)
+        return;
+
+    const float gain = 1.0f / (float) audio.getNumChannels();
+
+    for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+        juce::FloatVectorOperations::addWithMultiply (mono + (first - inputStart), audio.getReadPointer (channel, first),
+                                                      gain, last - first);
+}
+
+juce::uint64 SourceAnalysis::hashChunkInput (const float* mono, double sampleRate) noexcept
+{
+    juce::uint64 hash = 14695981039346656037ull;
+
+    auto addWord = [&hash] (juce::uint64 word)
+    {
+        hash ^= word;
+        hash *= 1099511628211ull;
+    };
+
+    addWord ((juce::uint64) analysisVersion);
+    addWord ((juce::uint64) juce::roundToInt (sampleRate));
+
+    for (int i = 0; i < chunkSize + 2 * chunkMargin; ++i)
+    {
+        juce::uint32 bits;
+        std::memcpy (&bits, mono + i, sizeof (bits));
+        addWord (bits);
+    }
+
+    return hash;
+}
+
+//==============================================================================
+bool SourceAnalysis::Chunk::writeTo (juce::OutputStream& output) const
+{
+    bool success = true;
+
+    for (auto value : pitch)
+        success = success && output.writeFloat (value);
+
+    for (auto value : transient)
+        success = success && output.writeFloat (value);
+
+    success = success && output.writeInt ((int) onsets.size());
+
+    for (auto offset : onsets)
+        success = success && output.writeInt (offset);
+
+    return success;
+}
+
+std::shared_ptr<const SourceAnalysis::Chunk> SourceAnalysis::Chunk::readFrom (juce::InputStream& input)
+{
+    auto chunk = std::make_shared<Chunk>();
+
+    for (auto& value : chunk->pitch)
+        value = input.readFloat();
+
+    for (auto& value : chunk->transient)
+        value = input.readFloat();
+
+    const auto numOnsets = input.readInt();
+
+    if (! juce::isPositiveAndNotGreaterThan (numOnsets, hopsPerChunk))
+        return nullptr;
+
+    for (int i = 0; i < numOnsets; ++i)
+        chunk->onsets.push_back (juce::jlimit (0, chunkSize - 1, input.readInt()));
+
+    return chunk;
+}
+
+//==============================================================================
+SourceAnalyser::SourceAnalyser (double rate)
+    : sampleRate (rate),
+      minLag (juce::jmax (2, (int) (rate / highestPitchHz))),
+      maxLag (juce::jmin (SourceAnalysis::frameSize / 2, (int) (rate / lowestPitchHz))),
+      fftBuffer ((size_t) fftSize * 2),
+      energies ((size_t) SourceAnalysis::frameSize + 1),
+      difference ((size_t) SourceAnalysis::frameSize / 2 + 2),
+      fluxWindow ((size_t) fluxFrameSize),
+      magnitudes ((size_t) numFluxBins),
+      previousMagnitudes ((size_t) numFluxBins)
+{
+    juce::dsp::WindowingFunction<float>::fillWindowingTables (fluxWindow.data(), (size_t) fluxFrameSize,
+                                                             juce::dsp::WindowingFunction<float>::hann, false);
+}
+
+std::shared_ptr<const SourceAnalysis::Chunk> SourceAnalyser::analyseChunk (const float* mono)
+{
+    constexpr int hopSize = SourceAnalysis::hopSize;
+    constexpr int numHops = SourceAnalysis::hopsPerChunk;
+    constexpr int margin = SourceAnalysis::chunkMargin;
+
+    auto chunk = std::make_shared<SourceAnalysis::Chunk>();
+    std::array<float, numHops> flux {};
+
+    // The flux of the first hop needs the spectrum of the hop before it, which the margin covers
+    computeMagnitudes (mono + margin - hopSize / 2 - fluxFrameSize / 2, previousMagnitudes.data());
+
+    for (int hop = 0; hop < numHops; ++hop)
+    {
+        const int centre = margin + hop * hopSize + hopSize / 2;
+
+        chunk->pitch[(size_t) hop] = detectPitch (mono + centre - SourceAnalysis::frameSize / 2);
+
+        computeMagnitudes (mono + centre - fluxFrameSize / 2, magnitudes.data());
+
+        float hopFlux = 0.0f;
+
+        for (int bin = 0; bin < numFluxBins; ++bin)
+            hopFlux += juce::jmax (0.0f, magnitudes[(size_t) bin] - previousMagnitudes[(size_t) bin]);
+
+        flux[(size_t) hop] = hopFlux;
+        std::swap (magnitudes, previousMagnitudes);
+    }
+
+    // Transient strength is flux relative to its neighbourhood; onsets are its clear peaks
+    int lastOnsetHop = -minimumOnsetSpacingHops;
+
+    for (int hop = 0; hop < numHops; ++hop)
+    {
+        const int first = juce::jmax (0, hop - fluxAverageHops);
+        const int last = juce::jmin (numHops - 1, hop + fluxAverageHops);
+
+        float average = 0.0f;
+
+        for (int i = first; i <= last; ++i)
+            average += flux[(size_t) i];
+
+        average /= (float) (last - first + 1);
+
+        const float strength = flux[(size_t) hop] / (average + 1.0f);
+        chunk->transient[(size_t) hop] = strength;
+
+        const bool isPeak = (hop == 0 || flux[(size_t) hop] >= flux[(size_t) hop - 1])
+                         && (hop == numHops - 1 || flux[(size_t) hop] > flux[(size_t) hop + 1]);
+
+        if (! isPeak || strength < onsetTransientRatio || flux[(size_t) hop] < minimumOnsetFlux
+             || hop - lastOnsetHop < minimumOnsetSpacingHops)
+            continue;
+
+        lastOnsetHop = hop;
+
+        // Move the onset back from the loudest point of the attack to where it starts rising
+        const int searchStart = hop * hopSize + hopSize / 2 - fluxFrameSize / 2;
+        constexpr int numBlocks = fluxFrameSize / onsetRefineBlock;
+        std::array<float, numBlocks> blockEnergy {};
+        int loudest = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const auto* samples = mono + margin + searchStart + block * onsetRefineBlock;
+
+            for (int i = 0; i < onsetRefineBlock; ++i)
+                blockEnergy[(size_t) block] += samples[i] * samples[i];
+
+            if (blockEnergy[(size_t) block] > blockEnergy[(size_t) loudest])
+                loudest = block;
+        }
+
+        int start = loudest;
+
+        while (start > 0 && blockEnergy[(size_t) start - 1] >= blockEnergy[(size_t) loudest] * 0.25f)
+            --start;
+
+        const int offset = juce::jlimit (0, SourceAnalysis::chunkSize - 1, searchStart + start * onsetRefineBlock);
+
+        if (chunk->onsets.empty() || offset > chunk->onsets.back())
+            chunk->onsets.push_back (offset);
+    }
+
+    return chunk;
+}
+
+float SourceAnalyser::detectPitch (const float* frame)
+{
+    constexpr int frameSize = SourceAnalysis::frameSize;
+
+    energies[0] = 0.0f;
+
+    for (int i = 0; i < frameSize; ++i)
+        energies[(size_t) i + 1] = energies[(size_t) i] + frame[i] * frame[i];
+
+    const float totalEnergy = energies[(size_t) frameSize];
+
+    if (totalEnergy < silenceMeanSquare * (float) frameSize)
+        return 0.0f;
+
+    // Autocorrelation through the FFT, zero-padded so it doesn't wrap
+    std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    std::copy (frame, frame + frameSize, fftBuffer.begin());
+
+    autocorrelationFFT.performRealOnlyForwardTransform (fftBuffer.data());
+
+    for (int bin = 0; bin < fftSize; ++bin)
+    {
+        const float re = fftBuffer[(size_t) bin * 2];
+        const float im = fftBuffer[(size_t) bin * 2 + 1];
+        fftBuffer[(size_t) bin * 2] = re * re + im * im;
+        fftBuffer[(size_t) bin * 2 + 1] = 0.0f;
+    }
+
+    autocorrelationFFT.performRealOnlyInverseTransform (fftBuffer.data());
+
+    // Lag 0 is the frame's energy, which pins down the transform's scaling
+    const float scale = fftBuffer[0] > 0.0f ? totalEnergy / fftBuffer[0] : 0.0f;
+
+    // Mean squared difference at each lag, then YIN's cumulative mean normalisation
+    float runningSum = 0.0f;
+    difference[0] = 1.0f;
+
+    for (int lag = 1; lag <= maxLag; ++lag)
+    {
+        const float overlapEnergy = energies[(size_t) (frameSize - lag)]
+                                  + (totalEnergy - energies[(size_t) lag]);
+        const float squaredDifference = juce::jmax (0.0f, overlapEnergy - 2.0f * scale * fftBuffer[(size_t) lag]);
+        const float meanDifference = squaredDifference / (float) (frameSize - lag);
+
+        runningSum += meanDifference;
+        difference[(size_t) lag] = runningSum > 0.0f ? meanDifference * (float) lag / runningSum : 1.0f;
+    }
+
+    int bestLag = -1;
+
+    for (int lag = minLag; lag < maxLag; ++lag)
+    {
+        if (difference[(size_t) lag] < pitchThreshold)
+        {
+            while (lag + 1 < maxLag && difference[(size_t) lag + 1] < difference[(size_t) lag])
+                ++lag;
+
+            bestLag = lag;
+            break;
+        }
+    }
+
+    if (bestLag < 0)
+    {
+        bestLag = minLag;
+
+        for (int lag = minLag + 1; lag < maxLag; ++lag)
+            if (difference[(size_t) lag] < difference[(size_t) bestLag])
+                bestLag = lag;
+
+        if (difference[(size_t) bestLag] > voicingThreshold)
+            return 0.0f;
+    }
+
+    // Parabolic interpolation around the dip for a sub-sample period
+    const float before = difference[(size_t) bestLag - 1];
+    const float at = difference[(size_t) bestLag];
+    const float after = difference[(size_t) bestLag + 1];
+    const float curvature = before - 2.0f * at + after;
+    const float shift = curvature > 0.0f ? juce::jlimit (-0.5f, 0.5f, 0.5f * (before - after) / curvature) : 0.0f;
+
+    return (float) (sampleRate / ((double) bestLag + shift));
+}
+
+void SourceAnalyser::computeMagnitudes (const float* frame, float* result)
+{
+    std::fill (fftBuffer.begin(), fftBuffer.begin() + fluxFrameSize * 2, 0.0f);
+    juce::FloatVectorOperations::multiply (fftBuffer.data(), frame, fluxWindow.data(), fluxFrameSize);
+
+    fluxFFT.performFrequencyOnlyForwardTransform (fftBuffer.data(), true);
+
+    // Log compression keeps loud sustained partials from swamping the flux
+    for (int bin = 0; bin < numFluxBins; ++bin)
+        result[bin] = std::log1p (10.0f * fftBuffer[(size_t) bin]);
+}
+
+//==============================================================================
+AnalysisCache::AnalysisCache (size_t maximumChunks)
+    : maxChunks (maximumChunks)
+{
+}
+
+std::shared_ptr<const SourceAnalysis::Chunk> AnalysisCache::find (juce::uint64 hash)
+{
+    const juce::ScopedLock sl (lock);
+
+    auto it = entries.find (hash);
+
+    if (it == entries.end())
+        return nullptr;
+
+    it->second.lastUsed = ++useCounter;
+    return it->second.chunk;
+}
+
+void AnalysisCache::add (juce::uint64 hash, std::shared_ptr<const SourceAnalysis::Chunk> chunk)
+{
+    if (chunk == nullptr)
+        return;
+
+    const juce::ScopedLock sl (lock);
+
+    if (entries.size() >= maxChunks && entries.find (hash) == entries.end())
+    {
+        auto oldest = entries.begin();
+
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+            if (it->second.lastUsed < oldest->second.lastUsed)
+                oldest = it;
+
+        entries.erase (oldest);
+    }
+
+    entries[hash] = { std::move (chunk), ++useCounter };
+}
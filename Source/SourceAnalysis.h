@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    SourceAnalysis.h
+    Offline pitch, onset and transient analysis of whole audio sources.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <unordered_map>
+
+//==============================================================================
+/**
+    What the offline analysis knows about one audio source.
+
+    The source is cut into fixed-size chunks that are analysed independently,
+    each from a mono mixdown padded with half a frame of its neighbours. A chunk
+    is identified by a hash of exactly the samples it was analysed from, so an
+    edit only invalidates the chunks it touches and identical audio (duplicated
+    clips, a session reopened) is never analysed twice.
+*/
+struct SourceAnalysis
+{
+    static constexpr int hopSize = 512;
+    static constexpr int frameSize = 2048;
+    static constexpr int hopsPerChunk = 128;
+    static constexpr int chunkSize = hopSize * hopsPerChunk;
+
+    // Samples each side of a chunk that its first and last frames reach into
+    static constexpr int chunkMargin = frameSize / 2;
+
+    /** Bump whenever the analysis changes, so stale cached chunks stop matching. */
+    static constexpr int analysisVersion = 1;
+
+    struct Chunk
+    {
+        std::array<float, hopsPerChunk> pitch {};      // Hz at the centre of each hop, 0 where unvoiced
+        std::array<float, hopsPerChunk> transient {};  // spectral flux over its local average, per hop
+        std::vector<int> onsets;                       // sample offsets within the chunk, ascending
+
+        /** Returns false if the stream failed to take any of it. */
+        bool writeTo (juce::OutputStream& output) const;
+        static std::shared_ptr<const Chunk> readFrom (juce::InputStream& input);
+    };
+
+    double sampleRate = 44100.0;
+    juce::int64 numSamples = 0;
+    std::vector<juce::uint64> chunkHashes;
+    std::vector<std::shared_ptr<const Chunk>> chunks;
+
+    /** Detected fundamental at a sample, or 0 if that part of the source is unvoiced. */
+    float getPitchAt (juce::int64 sample) const noexcept;
+
+    /** Transient strength at a sample; around 1 for steady material, well above at attacks. */
+    float getTransientAt (juce::int64 sample) const noexcept;
+
+    /** Appends the onsets in [start, end) to the list, in source samples. */
+    void getOnsets (juce::int64 start, juce::int64 end, std::vector<juce::int64>& result) const;
+
+    static int getNumChunks (juce::int64 numSamples) noexcept    { return (int) ((numSamples + chunkSize - 1) / chunkSize); }
+
+    /** Fills mono with the mixdown a chunk is analysed from: chunkSize + 2 * chunkMargin
+        samples starting chunkMargin before the chunk, zero outside the source.
+    */
+    static void getChunkInput (const juce::AudioBuffer<float>& audio, int chunkIndex, float* mono) noexcept;
+
+    /** 64-bit FNV-1a over the chunk input, the sample rate and the analysis version. */
+    static juce::uint64 hashChunkInput (const float* mono, double sampleRate) noexcept;
+};
+
+//==============================================================================
+/**
+    Analyses chunks of one source. Holds the FFT and frame buffers, so keep one
+    per worker thread rather than one per chunk.
+*/
+class SourceAnalyser
+{
+public:
+    explicit SourceAnalyser (double sampleRate);
+
+    /** Analyses a chunk from the input filled in by SourceAnalysis::getChunkInput(). */
+    std::shared_ptr<const SourceAnalysis::Chunk> analyseChunk (const float* mono);
+
+private:
+    float detectPitch (const float* frame);
+    void computeMagnitudes (const float* frame, float* magnitudes);
+
+    static constexpr int fftOrder = 12;                 // room for the linear autocorrelation of a frame
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int fluxFrameSize = 1024;
+    static constexpr int numFluxBins = fluxFrameSize / 2 + 1;
+
+    double sampleRate;
+    int minLag, maxLag;
+
+    juce::dsp::FFT autocorrelationFFT { fftOrder };
+    juce::dsp::FFT fluxFFT { fftOrder - 2 };
+    std::vector<float> fftBuffer, energies, difference, fluxWindow;
+    std::vector<float> magnitudes, previousMagnitudes;
+};
+
+//==============================================================================
+/**
+    Analysed chunks keyed by content hash, shared by every source in a document.
+    Least recently used chunks are dropped once the cache is full. Thread safe.
+*/
+class AnalysisCache
+{
+public:
+    explicit AnalysisCache (size_t maxChunks = 8192);
+
+    std::shared_ptr<const SourceAnalysis::Chunk> find (juce::uint64 hash);
+    void add (juce::uint64 hash, std::shared_ptr<const SourceAnalysis::Chunk> chunk);
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const SourceAnalysis::Chunk> chunk;
+        juce::uint64 lastUsed = 0;
+    };
+
+    juce::CriticalSection lock;
+    std::unordered_map<juce::uint64, Entry> entries;
+    juce::uint64 useCounter = 0;
+    const size_t maxChunks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalysisCache)
+};
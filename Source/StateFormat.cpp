@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    StateFormat.cpp
+    Compact, versioned binary encoding of the plugin state.
+
+  ==============================================================================
+*/
+
+#include "StateFormat.h"
+#include "PresetBank.h"
+#include "RealtimeChecks.h"
+
+namespace StateFormat
+{
+namespace
+{
+    constexpr char stateMagic[4] = { 'N', 'C', 'S', 'T' };
+    constexpr char programTag[4] = { 'P', 'R', 'O', 'G' };
+    constexpr int headerSize = 8;
+    constexpr int entrySize = 8;
+
+    /** Rewrites a value saved by an older schema into today's terms.
+        Returns false to drop the entry. Add a case here whenever a
+        parameter's ID, range or meaning changes.
+    */
+    bool migrateEntry (int schemaVersion, juce::uint32 hash, float& value) noexcept
+    {
+        juce::ignoreUnused (schemaVersion, hash, value);
+        return true;
+    }
+}
+
+//==============================================================================
+ParameterIndex::ParameterIndex (juce::AudioProcessor& processor)
+{
+    for (auto* parameter : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            entries.push_back ({ PresetBank::hashParameterID (ranged->getParameterID()), ranged });
+
+    std::sort (entries.begin(), entries.end(),
+               [] (const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+    // Two IDs with the same hash would restore into one parameter; rename one of them
+    jassert (std::adjacent_find (entries.begin(), entries.end(),
+                                 [] (const Entry& a, const Entry& b) { return a.hash == b.hash; }) == entries.end());
+}
+
+int ParameterIndex::indexOf (juce::uint32 hash) const noexcept
+{
+    auto it = std::lower_bound (entries.begin(), entries.end(), hash,
+                                [] (const Entry& entry, juce::uint32 h) { return entry.hash < h; });
+
+    return (it != entries.end() && it->hash == hash) ? (int) (it - entries.begin()) : -1;
+}
+
+//==============================================================================
+bool isBinaryState (const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= headerSize && std::memcmp (data, stateMagic, 4) == 0;
+}
+
+void write (const ParameterIndex& index, int currentProgram, juce::MemoryBlock& destData)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    const auto& entries = index.getEntries();
+
+    destData.setSize (0);
+    juce::MemoryOutputStream output (destData, false);
+    output.preallocate (headerSize + entries.size() * entrySize + 12);
+
+    output.write (stateMagic, 4);
+    output.writeShort ((short) currentSchemaVersion);
+    output.writeShort ((short) entries.size());
+
+    for (const auto& entry : entries)
+    {
+        output.writeInt ((int) entry.hash);
+        output.writeFloat (entry.parameter->convertFrom0to1 (entry.parameter->getValue()));
+    }
+
+    output.write (programTag, 4);
+    output.writeInt (4);
+    output.writeInt (currentProgram);
+}
+
+bool read (const ParameterIndex& index, const void* data, int sizeInBytes, int& currentProgram)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    if (! isBinaryState (data, sizeInBytes))
+        return false;
+
+    juce::MemoryInputStream input (data, (size_t) sizeInBytes, false);
+    input.skipNextBytes (4);
+
+    const int schemaVersion = (juce::uint16) input.readShort();
+    const int numEntries = (juce::uint16) input.readShort();
+
+    if (headerSize + numEntries * entrySize > sizeInBytes)
+        return false;
+
+    const auto& entries = index.getEntries();
+    std::vector<bool> restored (entries.size(), false);
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        const auto hash = (juce::uint32) input.readInt();
+        auto value = input.readFloat();
+
+        if (const auto entry = index.indexOf (hash); entry >= 0 && migrateEntry (schemaVersion, hash, value))
+        {
+            auto* parameter = entries[(size_t) entry].parameter;
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+            restored[(size_t) entry] = true;
+        }
+    }
+
+    // A blob from before a parameter existed restores it to its default, as the XML did,
+    // rather than leaving whatever this instance was last set to
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (! restored[i])
+            entries[i].parameter->setValueNotifyingHost (entries[i].parameter->getDefaultValue());
+
+    // Tagged sections; anything from a newer schema we don't know is skipped
+    while (input.getNumBytesRemaining() >= 8)
+    {
+        char tag[4];
+        input.read (tag, 4);
+        const auto size = input.readInt();
+
+        if (size < 0 || size > input.getNumBytesRemaining())
+            break;
+
+        const auto next = input.getPosition() + size;
+
+        if (std::memcmp (tag, programTag, 4) == 0 && size >= 4)
+            currentProgram = input.readInt();
+
+        input.setPosition (next);
+    }
+
+    return true;
+}
+}
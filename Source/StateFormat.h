@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    StateFormat.h
+    Compact, versioned binary encoding of the plugin state.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Saves and restores the plugin's parameters as a small binary blob instead
+    of the APVTS XML, so hosts loading hundreds of instances don't parse and
+    rebuild a ValueTree for each one.
+
+    Layout (little-endian):
+
+        char[4]   magic "NCST"
+        uint16    schema version
+        uint16    number of parameter entries (N)
+        N x { uint32 parameter ID hash, float32 plain value }
+        sections: { char[4] tag, uint32 size, size bytes } until end of data
+
+    Schema history:
+        0   APVTS XML written with copyXmlToBinary (still read by the processor)
+        1   the layout above; section "PROG" holds the current program index
+
+    Every version keeps this prefix, so an older build reads a newer blob by
+    skipping entries and sections it doesn't recognise (forward migration),
+    and parameters missing from an older blob are reset to their defaults.
+    Value changes between versions go through migrateEntry (backward migration).
+*/
+namespace StateFormat
+{
+    static constexpr int currentSchemaVersion = 1;
+
+    //==============================================================================
+    /** Parameters sorted by ID hash, built once so restoring is one binary search
+        and one assignment per entry.
+    */
+    class ParameterIndex
+    {
+    public:
+        explicit ParameterIndex (juce::AudioProcessor& processor);
+
+        /** Position of the hash in getEntries(), or -1. */
+        int indexOf (juce::uint32 hash) const noexcept;
+
+        struct Entry
+        {
+            juce::uint32 hash;
+            juce::RangedAudioParameter* parameter;
+        };
+
+        const std::vector<Entry>& getEntries() const noexcept    { return entries; }
+
+    private:
+        std::vector<Entry> entries;
+    };
+
+    //==============================================================================
+    /** True if the data starts with this format's magic. */
+    bool isBinaryState (const void* data, int sizeInBytes) noexcept;
+
+    void write (const ParameterIndex& index, int currentProgram, juce::MemoryBlock& destData);
+
+    /** Assigns every recognised entry to its parameter, and resets the parameters
+        the blob doesn't hold to their defaults. Returns false (having changed
+        nothing) if the data isn't a well-formed blob of this format.
+        currentProgram is left untouched unless the blob stores one.
+    */
+    bool read (const ParameterIndex& index, const void* data, int sizeInBytes, int& currentProgram);
+}
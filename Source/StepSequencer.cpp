@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    StepSequencer.cpp
+    Tempo-synced step sequencer of pitch and harmony intervals.
+
+  ==============================================================================
+*/
+
+#include "StepSequencer.h"
+
+namespace
+{
+    // Beat positions on a step boundary can come out a hair short of it
+    constexpr double boundaryTolerance = 1.0e-9;
+}
+
+//==============================================================================
+void StepSequencer::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void StepSequencer::reset (juce::int64 samplePosition) noexcept
+{
+    jassert (samplePosition >= 0);
+
+    position = anchorPosition = samplePosition;
+    anchorBeats = (double) samplePosition * beatsPerMinute / (60.0 * sampleRate);
+    looping = false;
+    currentStep = -1;
+    numTransitions = 0;
+}
+
+void StepSequencer::setTransport (const juce::Optional<juce::AudioPlayHead::PositionInfo>& transport) noexcept
+{
+    if (! transport.hasValue())
+        return;
+
+    // Re-anchor on a tempo change so the beat carries on from where it was
+    if (const auto bpm = transport->getBpm(); bpm.hasValue() && *bpm > 0.0 && *bpm != beatsPerMinute)
+    {
+        anchorBeats = getBeatsAt (position);
+        anchorPosition = position;
+        beatsPerMinute = *bpm;
+    }
+
+    looping = false;
+
+    // While playing, follow the host's beat, which also picks up loops and jumps
+    if (! transport->getIsPlaying())
+        return;
+
+    if (const auto ppq = transport->getPpqPosition(); ppq.hasValue())
+    {
+        anchorBeats = *ppq;
+        anchorPosition = position;
+    }
+
+    if (const auto loop = transport->getLoopPoints(); transport->getIsLooping() && loop.hasValue())
+    {
+        // A loop shorter than a sample would never let the block finish
+        looping = (loop->ppqEnd - loop->ppqStart) * 60.0 * sampleRate / beatsPerMinute >= 1.0;
+        loopStart = loop->ppqStart;
+        loopEnd = loop->ppqEnd;
+    }
+}
+
+void StepSequencer::schedule (double stepBeats, int numSteps, int numSamples) noexcept
+{
+    jassert (stepBeats > 0.0 && numSteps > 0 && numSteps <= maxSteps);
+
+    numTransitions = 0;
+
+    const double samplesPerBeat = 60.0 * sampleRate / beatsPerMinute;
+
+    const auto getStep = [stepBeats, numSteps] (double beats)
+    {
+        const auto index = (juce::int64) std::floor (beats / stepBeats + boundaryTolerance);
+        return (int) (((index % numSteps) + numSteps) % numSteps);
+    };
+
+    // A change that doesn't fit is left for the next block, which starts on it
+    const auto addTransition = [this] (int sample, int step)
+    {
+        if (step == currentStep || numTransitions == maxTransitions)
+            return;
+
+        transitions[(size_t) numTransitions++] = { sample, step };
+        currentStep = step;
+    };
+
+    // A jump, a loop back or a change of pattern can put the block's start on another step
+    double beats = getBeatsAt (position);
+    addTransition (0, getStep (beats));
+
+    // Walk the boundaries in the block. Each step starts on the first sample at or after its
+    // boundary, counted from the block's start so rounding doesn't build up across steps.
+    for (double boundarySample = 0.0;;)
+    {
+        const double nextBoundary = (std::floor (beats / stepBeats + boundaryTolerance) + 1.0) * stepBeats;
+        const bool wraps = looping && beats < loopEnd && nextBoundary >= loopEnd;
+        const double target = wraps ? loopEnd : nextBoundary;
+
+        boundarySample += (target - beats) * samplesPerBeat;
+        const int sample = (int) std::ceil (boundarySample - boundaryTolerance);
+
+        if (sample >= numSamples || numTransitions == maxTransitions)
+            break;
+
+        beats = wraps ? loopStart : target;
+        addTransition (sample, getStep (beats));
+    }
+
+    position += numSamples;
+}
+
+double StepSequencer::getBeatsAt (juce::int64 samplePosition) const noexcept
+{
+    return anchorBeats + (double) (samplePosition - anchorPosition) * beatsPerMinute / (60.0 * sampleRate);
+}
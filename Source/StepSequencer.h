@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    StepSequencer.h
+    Tempo-synced step sequencer of pitch and harmony intervals.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/**
+    Plays a pattern of up to maxSteps steps, one per synced division, locked to
+    the host's beat.
+
+    Before each block, schedule() works out the samples in it where a new step
+    starts, so the processor can split the block there the way it splits it at
+    MIDI program changes. While the host plays, every block is anchored to its
+    beat position, so tempo changes and transport jumps are picked up at the
+    next block, and a jump that lands on another step starts it on the block's
+    first sample. A loop's end is found inside the block, and the step at the
+    loop's start follows on the exact sample. While the transport is stopped the
+    beat carries on from the sample count at the host's last tempo, as the
+    modulation sources do.
+
+    Everything is fixed-size, and with the sequencer off the processor only
+    calls advance(), which adds to a counter.
+*/
+class StepSequencer
+{
+public:
+    static constexpr int maxSteps = 16;
+
+    /** Most step changes one block can hold; any beyond start on the next block's first sample. */
+    static constexpr int maxTransitions = 64;
+
+    struct Transition
+    {
+        int sample = 0;     // From the start of the block
+        int step = 0;
+    };
+
+    void prepare (double sampleRate);
+
+    /** Carries on as if samplePosition samples had already played with the transport
+        stopped, with no step playing yet.
+    */
+    void reset (juce::int64 samplePosition = 0) noexcept;
+
+    /** Takes the tempo, the beat at the start of the block and the loop while the host is playing. */
+    void setTransport (const juce::Optional<juce::AudioPlayHead::PositionInfo>& position) noexcept;
+
+    /** Finds the step changes in the next numSamples samples, one step per stepBeats
+        quarter notes, numSteps steps to the pattern.
+    */
+    void schedule (double stepBeats, int numSteps, int numSamples) noexcept;
+
+    /** Moves past samples played with the sequencer off, which stops the step. */
+    void advance (int numSamples) noexcept     { position += numSamples; currentStep = -1; }
+
+    /** The last schedule() call's step changes, in order. */
+    int getNumTransitions() const noexcept                  { return numTransitions; }
+    const Transition& getTransition (int index) const noexcept { return transitions[(size_t) index]; }
+
+private:
+    double getBeatsAt (juce::int64 samplePosition) const noexcept;
+
+    double sampleRate = 44100.0;
+    double beatsPerMinute = 120.0;
+
+    // Beats at anchorPosition; between transport updates the beat follows the sample count
+    juce::int64 position = 0, anchorPosition = 0;
+    double anchorBeats = 0.0;
+
+    // The host's loop, while it's playing one
+    bool looping = false;
+    double loopStart = 0.0, loopEnd = 0.0;
+
+    int currentStep = -1;   // At the end of the last block scheduled
+    std::array<Transition, maxTransitions> transitions;
+    int numTransitions = 0;
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    Trace.cpp
+    Scoped trace markers, exported as Chrome/Perfetto trace JSON.
+
+  ==============================================================================
+*/
+
+#include "Trace.h"
+
+#if NOCTAVE_TRACE
+
+namespace Trace
+{
+namespace
+{
+    constexpr int maxThreads = 32;
+    constexpr int eventsPerThread = 8192; // A power of two, so the index wraps with a mask
+
+    struct Event
+    {
+        const char* name;
+        juce::int64 startTicks, endTicks;
+    };
+
+    // One writer per ring, so recording is a store and a release increment
+    struct ThreadRing
+    {
+        std::array<Event, eventsPerThread> events;
+        std::atomic<juce::uint32> numWritten { 0 };
+    };
+
+    // Static storage, so a thread's first event claims a ring without allocating
+    ThreadRing rings[maxThreads];
+    std::atomic<int> numRingsClaimed { 0 };
+
+    ThreadRing* getThreadRing() noexcept
+    {
+        thread_local ThreadRing* ring = [] () -> ThreadRing*
+        {
+            const auto index = numRingsClaimed++;
+            return index < maxThreads ? &rings[index] : nullptr;
+        }();
+
+        return ring;
+    }
+}
+
+void ScopedEvent::end() noexcept
+{
+    if (std::exchange (ended, true))
+        return;
+
+    const auto endTicks = juce::Time::getHighResolutionTicks();
+
+    if (auto* ring = getThreadRing())
+    {
+        const auto index = ring->numWritten.load (std::memory_order_relaxed);
+        ring->events[index & (eventsPerThread - 1)] = { name, startTicks, endTicks };
+        ring->numWritten.store (index + 1, std::memory_order_release);
+    }
+}
+
+bool dumpToFile (const juce::File& file)
+{
+    const auto microsecondsPerTick = 1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    const int numRings = juce::jmin (numRingsClaimed.load(), maxThreads);
+
+    juce::MemoryOutputStream json;
+    json << "{\"traceEvents\":[";
+    bool first = true;
+
+    for (int thread = 0; thread < numRings; ++thread)
+    {
+        const auto& ring = rings[thread];
+        const auto numWritten = ring.numWritten.load (std::memory_order_acquire);
+        const auto numKept = juce::jmin (numWritten, (juce::uint32) eventsPerThread);
+
+        for (auto i = numWritten - numKept; i != numWritten; ++i)
+        {
+            const auto& event = ring.events[i & (eventsPerThread - 1)];
+
+            json << (first ? "" : ",")
+                 << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread + 1
+                 << ",\"ts\":" << juce::String ((double) event.startTicks * microsecondsPerTick, 3)
+                 << ",\"dur\":" << juce::String ((double) (event.endTicks - event.startTicks) * microsecondsPerTick, 3)
+                 << "}";
+            first = false;
+        }
+    }
+
+    json << "],\"displayTimeUnit\":\"ms\"}";
+
+    return file.replaceWithData (json.getData(), json.getDataSize());
+}
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    Trace.h
+    Scoped trace markers, exported as Chrome/Perfetto trace JSON.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Off unless the build defines NOCTAVE_TRACE=1; the markers then expand to nothing
+#ifndef NOCTAVE_TRACE
+ #define NOCTAVE_TRACE 0
+#endif
+
+//==============================================================================
+/**
+    Timing markers for finding out where a glitch came from. Wrap a stage in
+    NOCTAVE_TRACE_SCOPE ("name") and its start and duration are recorded into
+    a ring buffer owned by the calling thread. Recording is two timestamp reads
+    and a few stores, with no locks or allocation, so it's safe on the audio
+    thread. Each ring keeps that thread's most recent events. Built without
+    NOCTAVE_TRACE, the macros are empty and cost nothing.
+
+    dumpToFile() writes every thread's events as a Chrome trace, which
+    chrome://tracing and ui.perfetto.dev open directly. Events recorded while
+    the dump runs may come out garbled, so dump after the glitch, not during.
+*/
+namespace Trace
+{
+   #if NOCTAVE_TRACE
+    /** Records one event from construction to destruction. name must be a string literal. */
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent (const char* eventName) noexcept
+            : name (eventName), startTicks (juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedEvent()                  { end(); }
+
+        /** Records the event now rather than at the end of the scope. */
+        void end() noexcept;
+
+    private:
+        const char* name;
+        juce::int64 startTicks;
+        bool ended = false;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedEvent)
+    };
+
+    /** Writes all recorded events as Chrome trace JSON. Call on the message thread. */
+    bool dumpToFile (const juce::File& file);
+   #endif
+}
+
+// BEGIN and END mark a stage that doesn't fill a scope of its own
+#if NOCTAVE_TRACE
+ #define NOCTAVE_TRACE_SCOPE(name)        const Trace::ScopedEvent JUCE_JOIN_MACRO (traceEvent_, __LINE__) (name)
+ #define NOCTAVE_TRACE_BEGIN(id, name)    Trace::ScopedEvent id (name)
+ #define NOCTAVE_TRACE_END(id)            id.end()
+#else
+ #define NOCTAVE_TRACE_SCOPE(name)
+ #define NOCTAVE_TRACE_BEGIN(id, name)
+ #define NOCTAVE_TRACE_END(id)
+#endif
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    TransientDetector.cpp
+    Realtime onset detection and the lookahead delay it runs ahead of.
+
+  ==============================================================================
+*/
+
+#include "TransientDetector.h"
+#include "RealtimeChecks.h"
+
+namespace
+{
+    // A hop's slope energy must jump this far above the background to be an onset (about 8 dB)
+    constexpr float onsetRatio = 6.0f;
+
+    // Slope energy of a -60 dBFS sine at 1 kHz and 48 kHz; anything quieter is never an onset
+    constexpr float minimumOnsetEnergy = 1.0e-8f;
+
+    constexpr double backgroundSeconds = 0.05;
+    constexpr double minimumSpacingSeconds = 0.05;
+}
+
+//==============================================================================
+void TransientDetector::prepare (double sampleRate)
+{
+    backgroundCoefficient = (float) std::exp (-hopSize / (backgroundSeconds * sampleRate));
+    minimumSpacing = (int) std::ceil (minimumSpacingSeconds * sampleRate);
+    reset();
+}
+
+void TransientDetector::reset (juce::int64 samplePosition) noexcept
+{
+    jassert (samplePosition >= 0);
+
+    position = samplePosition;
+    lastOnset = samplePosition - minimumSpacing;
+    previousSample = hopEnergy = background = 0.0f;
+    hopFill = (int) (samplePosition % hopSize);
+    firstPending = numPending = 0;
+}
+
+void TransientDetector::process (const float* input, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float slope = input[i] - previousSample;
+        previousSample = input[i];
+        hopEnergy += slope * slope;
+
+        if (++hopFill == hopSize)
+            finishHop (position + i + 1 - hopSize);
+    }
+
+    position += numSamples;
+}
+
+void TransientDetector::popOnset() noexcept
+{
+    if (numPending == 0)
+        return;
+
+    firstPending = (firstPending + 1) % maxPendingOnsets;
+    --numPending;
+}
+
+void TransientDetector::finishHop (juce::int64 hopStart) noexcept
+{
+    const float energy = hopEnergy / (float) hopSize;
+
+    if (energy > onsetRatio * background + minimumOnsetEnergy && hopStart - lastOnset >= minimumSpacing)
+    {
+        lastOnset = hopStart;
+
+        // Onsets nobody has taken are stale; keep the newest
+        if (numPending == maxPendingOnsets)
+            popOnset();
+
+        pending[(size_t) ((firstPending + numPending) % maxPendingOnsets)] = hopStart;
+        ++numPending;
+    }
+
+    background = energy + (background - energy) * backgroundCoefficient;
+    hopEnergy = 0.0f;
+    hopFill = 0;
+}
+
+//==============================================================================
+void LookaheadDelay::prepare (int maxSamples)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    line.assign ((size_t) juce::jmax (1, maxSamples + 1), 0.0f);
+    delay = juce::jmin (delay, maxSamples);
+    reset();
+}
+
+void LookaheadDelay::reset() noexcept
+{
+    std::fill (line.begin(), line.end(), 0.0f);
+    writePosition = 0;
+}
+
+void LookaheadDelay::setDelay (int numSamples) noexcept
+{
+    numSamples = juce::jlimit (0, (int) line.size() - 1, numSamples);
+
+    if (numSamples == delay)
+        return;
+
+    delay = numSamples;
+    reset();
+}
+
+void LookaheadDelay::process (float* samples, int numSamples) noexcept
+{
+    if (delay == 0)
+        return;
+
+    const int size = (int) line.size();
+    int readPosition = writePosition - delay;
+
+    if (readPosition < 0)
+        readPosition += size;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        line[(size_t) writePosition] = samples[i];
+        samples[i] = line[(size_t) readPosition];
+
+        if (++writePosition == size)
+            writePosition = 0;
+
+        if (++readPosition == size)
+            readPosition = 0;
+    }
+}
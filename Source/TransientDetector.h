@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    TransientDetector.h
+    Realtime onset detection and the lookahead delay it runs ahead of.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/**
+    Finds note onsets in a live signal as it arrives, so a shifter running a few
+    milliseconds behind can place its splices on them.
+
+    The signal's slope (its first difference, which weights attacks above steady
+    low notes) is squared and summed over short hops. An onset is a hop whose
+    energy jumps well above the recent background. The test is a ratio rather
+    than a level, so soft and hard playing trigger alike. Hops are counted from
+    the reset position rather than the block, so onsets don't depend on how the
+    host splits its blocks. It costs a few operations per sample, and nothing is
+    allocated once it's running.
+*/
+class TransientDetector
+{
+public:
+    /** Onsets are placed at the start of the hop they're found in. */
+    static constexpr int hopSize = 16;
+
+    void prepare (double sampleRate);
+
+    /** Starts again from silence, counting input from samplePosition. */
+    void reset (juce::int64 samplePosition = 0) noexcept;
+
+    /** Looks for onsets in the next numSamples of input. */
+    void process (const float* input, int numSamples) noexcept;
+
+    /** Input position of the earliest onset not yet taken with popOnset(), or -1 if there's none. */
+    juce::int64 getNextOnset() const noexcept
+    {
+        return numPending > 0 ? pending[(size_t) firstPending] : -1;
+    }
+
+    void popOnset() noexcept;
+
+private:
+    // Onsets are at least minimumSpacingSeconds apart, so a few pending is plenty
+    static constexpr int maxPendingOnsets = 8;
+
+    void finishHop (juce::int64 hopStart) noexcept;
+
+    juce::int64 position = 0, lastOnset = 0;
+    float previousSample = 0.0f, hopEnergy = 0.0f, background = 0.0f;
+    float backgroundCoefficient = 0.0f;
+    int hopFill = 0, minimumSpacing = 0;
+
+    std::array<juce::int64, maxPendingOnsets> pending {};
+    int firstPending = 0, numPending = 0;
+};
+
+//==============================================================================
+/**
+    Short delay that holds a signal back by the detector's lookahead, so parts
+    that aren't steered stay in time with the parts that are.
+*/
+class LookaheadDelay
+{
+public:
+    /** Sizes the line for delays up to maxSamples. */
+    void prepare (int maxSamples);
+    void reset() noexcept;
+
+    /** Changes the delay, clearing the line if it changes. */
+    void setDelay (int numSamples) noexcept;
+    int getDelay() const noexcept     { return delay; }
+
+    /** Delays numSamples samples in place. */
+    void process (float* samples, int numSamples) noexcept;
+
+private:
+    std::vector<float> line;
+    int delay = 0, writePosition = 0;
+};
@@ -0,0 +1,378 @@
+/*
+  ==============================================================================
+
+    WorkerPool.cpp
+    Process-wide threads for fanning work out across cores.
+
+  ==============================================================================
+*/
+
+#include "WorkerPool.h"
+#include "RealtimeChecks.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <mach/mach.h>
+#else
+ #include <semaphore.h>
+#endif
+
+namespace
+{
+    int getDefaultNumThreads()
+    {
+        return juce::jmax (1, juce::SystemStats::getNumCpus() - 1);
+    }
+
+    // Set while the thread is working through tasks handed out by WorkerPool::run
+    thread_local bool isInsideRun = false;
+}
+
+//==============================================================================
+/*
+    A counting semaphore the audio thread can post without locking. The count
+    lives in an atomic, so posting only reaches the operating system when a
+    worker is actually parked, and then through a call that wakes it directly:
+    a futex-backed sem_post on Linux, a Mach semaphore on macOS, and
+    ReleaseSemaphore on Windows. None of them takes a user-space lock or waits.
+*/
+class WorkerPool::Semaphore
+{
+public:
+    Semaphore()
+    {
+       #if JUCE_WINDOWS
+        handle = CreateSemaphoreW (nullptr, 0, std::numeric_limits<LONG>::max(), nullptr);
+       #elif JUCE_MAC || JUCE_IOS
+        semaphore_create (mach_task_self(), &handle, SYNC_POLICY_FIFO, 0);
+       #else
+        sem_init (&handle, 0, 0);
+       #endif
+    }
+
+    ~Semaphore()
+    {
+       #if JUCE_WINDOWS
+        CloseHandle (handle);
+       #elif JUCE_MAC || JUCE_IOS
+        semaphore_destroy (mach_task_self(), handle);
+       #else
+        sem_destroy (&handle);
+       #endif
+    }
+
+    /** Any thread, including the audio thread. Lets one waiting worker through. */
+    void post (int numPosts = 1) noexcept
+    {
+        // A negative count is the number of workers parked in wait()
+        const auto previous = count.fetch_add (numPosts, std::memory_order_release);
+        const auto numToWake = juce::jmin (numPosts, -previous);
+
+        for (int i = 0; i < numToWake; ++i)
+            postToSystem();
+    }
+
+    /** Worker threads. Returns at once if posts are pending, otherwise parks. */
+    void wait() noexcept
+    {
+        if (count.fetch_sub (1, std::memory_order_acquire) > 0)
+            return;
+
+       #if JUCE_WINDOWS
+        WaitForSingleObject (handle, INFINITE);
+       #elif JUCE_MAC || JUCE_IOS
+        while (semaphore_wait (handle) == KERN_ABORTED) {}
+       #else
+        while (sem_wait (&handle) != 0 && errno == EINTR) {}
+       #endif
+    }
+
+private:
+    void postToSystem() noexcept
+    {
+       #if JUCE_WINDOWS
+        ReleaseSemaphore (handle, 1, nullptr);
+       #elif JUCE_MAC || JUCE_IOS
+        semaphore_signal (handle);
+       #else
+        sem_post (&handle);
+       #endif
+    }
+
+    std::atomic<int> count { 0 };
+
+   #if JUCE_WINDOWS
+    HANDLE handle = nullptr;
+   #elif JUCE_MAC || JUCE_IOS
+    semaphore_t handle {};
+   #else
+    sem_t handle {};
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (Semaphore)
+};
+
+//==============================================================================
+/*
+    Parks on the pool's semaphore while there's nothing to do. Every post() from
+    an audio thread lets one parked worker through, which scans all the clients
+    from its own starting point and runs whatever it finds queued, then parks
+    again once a scan turns up nothing. Posts made while every worker is busy
+    are counted, so each one still gets a scan after the current job.
+*/
+class WorkerPool::RealtimeWorker  : public juce::Thread
+{
+public:
+    RealtimeWorker (WorkerPool& pool, int workerIndex)
+        : juce::Thread ("Noctave realtime worker"), owner (pool), index (workerIndex)
+    {
+    }
+
+    ~RealtimeWorker() override
+    {
+        // The pool posts once per worker after asking them all to exit
+        stopThread (2000);
+    }
+
+    void run() override
+    {
+        // Same float mode as the host's audio thread
+        juce::ScopedNoDenormals noDenormals;
+
+        while (! threadShouldExit())
+        {
+            bool ranJobs = false;
+            scanning.store (true);
+
+            // Workers start their scans at different clients so they don't all contend for the first
+            for (int i = 0; i < maxClients; ++i)
+                if (auto* client = owner.clients[(size_t) ((index + i) % maxClients)].load())
+                    ranJobs = client->runPending() || ranJobs;
+
+            scanning.store (false);
+            ++passes;
+
+            if (! ranJobs)
+                owner.semaphore->wait();
+        }
+    }
+
+    // Returns once a pass over the clients that was under way has finished
+    void waitForPass() const noexcept
+    {
+        const auto pass = passes.load();
+
+        while (scanning.load() && passes.load() == pass)
+            juce::Thread::yield();
+    }
+
+private:
+    WorkerPool& owner;
+    const int index;
+    std::atomic<bool> scanning { false };
+    std::atomic<juce::uint32> passes { 0 };
+};
+
+//==============================================================================
+WorkerPool::WorkerPool()
+    : pool (juce::ThreadPoolOptions{}
+              .withThreadName ("Noctave worker")
+              .withNumberOfThreads (getDefaultNumThreads())),
+      semaphore (std::make_unique<Semaphore>())
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    // Instances remove their clients before the last one lets go of the pool
+    jassert (numClients.load() == 0);
+
+    for (auto* worker : realtimeWorkers)
+        worker->signalThreadShouldExit();
+
+    semaphore->post (realtimeWorkers.size());
+    realtimeWorkers.clear();
+    pool.removeAllJobs (true, 2000);
+}
+
+int WorkerPool::getNumThreads() const noexcept
+{
+    return pool.getNumThreads();
+}
+
+void WorkerPool::run (int numTasks, const std::function<void (int)>& task)
+{
+    // Waits for other threads, so only offline renders may use it
+    RealtimeChecks::assertNotRealtime();
+
+    // A task that fans out again, like a chunk render whose instance splits its voices,
+    // would wait on helpers queued behind the very jobs waiting for it, so it runs inline
+    if (isInsideRun)
+    {
+        for (int index = 0; index < numTasks; ++index)
+            task (index);
+
+        return;
+    }
+
+    std::atomic<int> nextTask { 0 };
+
+    // Whoever is free takes the next task, so an uneven mix of tasks still balances
+    auto work = [&]
+    {
+        const auto wasInsideRun = std::exchange (isInsideRun, true);
+
+        for (int index = nextTask++; index < numTasks; index = nextTask++)
+            task (index);
+
+        isInsideRun = wasInsideRun;
+    };
+
+    // The calling thread works too, so one task fewer needs a helper
+    const int numHelpers = juce::jmin (numTasks - 1, pool.getNumThreads());
+    std::atomic<int> helpersRunning { numHelpers };
+    juce::WaitableEvent helpersFinished;
+
+    for (int i = 0; i < numHelpers; ++i)
+    {
+        pool.addJob ([&]
+        {
+            // Same float mode as the host's render thread
+            juce::ScopedNoDenormals noDenormals;
+            work();
+
+            if (--helpersRunning == 0)
+                helpersFinished.signal();
+        });
+    }
+
+    work();
+
+    // Helpers read this frame's state, so they must all be gone before returning
+    if (numHelpers > 0)
+        helpersFinished.wait();
+}
+
+//==============================================================================
+bool WorkerPool::addClient (Client& client)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    auto slot = std::find_if (clients.begin(), clients.end(), [] (const auto& c) { return c.load() == nullptr; });
+
+    if (slot == clients.end())
+        return false;
+
+    client.owner.store (this);
+    slot->store (&client);
+    ++numClients;
+
+    // The realtime workers only start once something needs them
+    if (realtimeWorkers.isEmpty())
+    {
+        for (int i = 0; i < getDefaultNumThreads(); ++i)
+            realtimeWorkers.add (new RealtimeWorker (*this, i * maxClients / getDefaultNumThreads()))
+                ->startThread (juce::Thread::Priority::highest);
+    }
+
+    return true;
+}
+
+void WorkerPool::removeClient (Client& client)
+{
+    RealtimeChecks::assertNotRealtime();
+
+    client.owner.store (nullptr);
+
+    for (auto& slot : clients)
+    {
+        auto* expected = &client;
+
+        if (slot.compare_exchange_strong (expected, nullptr))
+            --numClients;
+    }
+
+    // A worker that loaded the client before it was removed may still be using it.
+    // Passes that start from now on can't see it.
+    for (auto* worker : realtimeWorkers)
+        worker->waitForPass();
+}
+
+//==============================================================================
+bool WorkerPool::Client::isFree (int slot) const noexcept
+{
+    return states[(size_t) slot].load (std::memory_order_acquire) == freeSlot;
+}
+
+void WorkerPool::Client::post (int slot) noexcept
+{
+    jassert (isFree (slot));
+    states[(size_t) slot].store (queued, std::memory_order_release);
+
+    if (auto* pool = owner.load (std::memory_order_acquire))
+        pool->semaphore->post();
+}
+
+bool WorkerPool::Client::isFinished (int slot) const noexcept
+{
+    return states[(size_t) slot].load (std::memory_order_acquire) == finished;
+}
+
+void WorkerPool::Client::release (int slot) noexcept
+{
+    jassert (isFinished (slot));
+    states[(size_t) slot].store (freeSlot, std::memory_order_release);
+}
+
+void WorkerPool::Client::runQueuedJobs() noexcept
+{
+    const auto isPending = [] (const std::atomic<int>& state)
+    {
+        const auto value = state.load (std::memory_order_acquire);
+        return value == queued || value == running;
+    };
+
+    // If a worker has the client, it runs everything queued before letting go
+    for (;;)
+    {
+        runPending();
+
+        if (std::none_of (states.begin(), states.end(), isPending))
+            return;
+
+        juce::Thread::yield();
+    }
+}
+
+bool WorkerPool::Client::runPending() noexcept
+{
+    bool ranJobs = false;
+
+    // A job posted just as another thread lets go of the client would otherwise wait for
+    // the next post, since its own post may have woken a worker that found the client busy
+    while (! busy.exchange (true, std::memory_order_acquire))
+    {
+        for (;;)
+        {
+            auto& state = states[(size_t) nextToRun];
+            int expected = queued;
+
+            if (! state.compare_exchange_strong (expected, running, std::memory_order_acquire))
+                break;
+
+            runJob (nextToRun);
+            state.store (finished, std::memory_order_release);
+            nextToRun = (nextToRun + 1) % numSlots;
+            ranJobs = true;
+        }
+
+        const auto next = nextToRun;
+        busy.store (false, std::memory_order_release);
+
+        if (states[(size_t) next].load (std::memory_order_acquire) != queued)
+            break;
+    }
+
+    return ranJobs;
+}
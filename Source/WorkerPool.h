@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    WorkerPool.h
+    Process-wide threads for fanning work out across cores.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/**
+    One set of worker threads shared by every Noctave instance in the process,
+    held through juce::SharedResourcePointer<WorkerPool>. Bouncing many stems
+    at once, or playing many instances that hand work off, then keeps one
+    thread per core, not one set per instance.
+
+    run() is for offline renders: it takes locks and waits for the helpers,
+    which realtime processing can't afford. Realtime work goes through a
+    Client instead, which never locks or waits on the audio thread.
+*/
+class WorkerPool
+{
+public:
+    WorkerPool();
+    ~WorkerPool();
+
+    /** Calls task (index) for every index from 0 to numTasks - 1, spread across
+        the pool and the calling thread, and returns once they've all finished.
+        Tasks must be independent of each other. A task that calls run() again
+        gets its own tasks run in turn on its thread, as every core is busy already.
+    */
+    void run (int numTasks, const std::function<void (int)>& task);
+
+    int getNumThreads() const noexcept;
+
+    //==============================================================================
+    /**
+        A stream of jobs posted from one audio thread. Each job lives in one of
+        numSlots slots, which are posted in turn. Jobs of one client run one at a
+        time and in order, since each usually carries on from the last, on
+        whichever realtime worker gets to them first; jobs of different clients
+        run side by side.
+
+        Checking on a job is a single atomic load, and posting one is an atomic
+        store plus a post to the pool's semaphore, which only calls into the
+        system when a worker is parked and never locks or waits. The post wakes
+        one parked worker, which scans every client and runs whatever is queued.
+        Clients aren't tied to workers and jobs aren't stolen between them: a
+        client's queue simply goes to whichever worker scans it first.
+    */
+    class Client
+    {
+    public:
+        static constexpr int numSlots = 4;
+
+        Client() = default;
+        virtual ~Client() = default;
+
+        /** Audio thread. True if the slot can take a new job. */
+        bool isFree (int slot) const noexcept;
+
+        /** Audio thread. Queues the job in a free slot, the one after the last posted. */
+        void post (int slot) noexcept;
+
+        /** Audio thread. True once the slot's job has run; its results stay until release(). */
+        bool isFinished (int slot) const noexcept;
+
+        /** Audio thread. Frees a finished slot. */
+        void release (int slot) noexcept;
+
+        /** Runs any queued jobs on the calling thread, first waiting for a worker to
+            finish one it has already started. For offline renders, which mustn't
+            depend on how busy the workers are.
+        */
+        void runQueuedJobs() noexcept;
+
+    protected:
+        /** Does the work for a posted slot, on a worker or in runQueuedJobs(). */
+        virtual void runJob (int slot) noexcept = 0;
+
+    private:
+        friend class WorkerPool;
+
+        enum State
+        {
+            freeSlot = 0,
+            queued,
+            running,
+            finished
+        };
+
+        // Runs queued jobs unless another thread already is; true if any ran
+        bool runPending() noexcept;
+
+        std::array<std::atomic<int>, numSlots> states {};
+        std::atomic<WorkerPool*> owner { nullptr };   // Set while added, so post() can wake a worker
+        std::atomic<bool> busy { false };
+        int nextToRun = 0; // Only touched by the thread holding busy
+
+        JUCE_DECLARE_NON_COPYABLE (Client)
+    };
+
+    /** Message thread. Starts handing the client's jobs to the realtime workers,
+        starting them the first time. They stay parked until a job is posted. False if there are already maxClients.
+    */
+    bool addClient (Client& client);
+
+    /** Message thread. Stops handing out the client's jobs, and waits until no
+        worker is still looking at it, so it can be deleted afterwards.
+    */
+    void removeClient (Client& client);
+
+    /** Two per instance is plenty for a session of many stereo instances. */
+    static constexpr int maxClients = 128;
+
+private:
+    class Semaphore;
+    class RealtimeWorker;
+
+    juce::ThreadPool pool;
+    std::unique_ptr<Semaphore> semaphore;   // Posted once per queued job, waited on by idle realtime workers
+
+    std::array<std::atomic<Client*>, maxClients> clients {};
+    std::atomic<int> numClients { 0 };
+    juce::OwnedArray<RealtimeWorker> realtimeWorkers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerPool)
+};
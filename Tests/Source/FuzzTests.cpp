@@ -0,0 +1,277 @@
+/*
+  ==============================================================================
+
+    FuzzTests.cpp
+    Drives the plugin through random host behaviour.
+
+  ==============================================================================
+*/
+
+#include "FuzzTests.h"
+#include "RealtimeMonitor.h"
+
+namespace FuzzTests
+{
+namespace
+{
+    const double sampleRates[] = { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    const int maxBlockSizes[] = { 1, 15, 64, 128, 441, 512, 1024, 2048, 4096 };
+
+    // 0 dBFS is the highest ceiling there is, and a changed ceiling takes the
+    // limiter's lookahead to reach, so this is all a random run can promise
+    const float peakLimit = juce::Decibels::decibelsToGain (0.01f);
+
+    enum class Input
+    {
+        testSignal = 0,
+        silence,
+        square,
+        tiny,
+        numInputs
+    };
+
+    class Fuzzer
+    {
+    public:
+        Fuzzer (const Options& options, TestHarness::Outcome& outcomeToFill)
+            : random (options.seed), seed (options.seed), outcome (outcomeToFill),
+              testSignal (TestHarness::makeTestSignal (44100.0, 2.0))
+        {
+        }
+
+        ~Fuzzer()
+        {
+            if (isPrepared)
+                processor.releaseResources();
+        }
+
+        void step (int index)
+        {
+            stepIndex = index;
+            const auto roll = random.nextInt (100);
+
+            if (! isPrepared)
+            {
+                // Hosts poke at a plugin before preparing it, and may release one that was never prepared
+                if (roll < 60)          prepare();
+                else if (roll < 70)     processor.releaseResources();
+                else if (roll < 80)     parameterStorm (true);
+                else if (roll < 90)     changeProgram();
+                else                    saveOrRestoreState();
+
+                return;
+            }
+
+            if (roll < 50)              processBlocks();
+            else if (roll < 62)         parameterStorm (random.nextBool());
+            else if (roll < 70)         changeProgram();
+            else if (roll < 76)         saveOrRestoreState();
+            else if (roll < 86)         runTimers();
+            else if (roll < 94)         prepare();
+            else                        release();
+        }
+
+    private:
+        juce::String where() const
+        {
+            return "seed " + juce::String (seed) + ", step " + juce::String (stepIndex) + " ("
+                     + juce::String (sampleRate, 0) + " Hz, " + juce::String (maxBlockSize) + " max, "
+                     + (processor.isNonRealtime() ? "offline" : "realtime") + "): ";
+        }
+
+        //==============================================================================
+        void prepare()
+        {
+            sampleRate = sampleRates[random.nextInt ((int) std::size (sampleRates))];
+            maxBlockSize = maxBlockSizes[random.nextInt ((int) std::size (maxBlockSizes))];
+
+            // Hosts switch to offline for a bounce, and usually prepare again around it
+            if (random.nextInt (4) == 0)
+                processor.setNonRealtime (! processor.isNonRealtime());
+
+            // Sometimes straight over a running one, with no release in between
+            processor.setPlayConfigDetails (2, 2, sampleRate, maxBlockSize);
+            processor.prepareToPlay (sampleRate, maxBlockSize);
+            storage.setSize (2, maxBlockSize);
+            isPrepared = true;
+        }
+
+        void release()
+        {
+            processor.releaseResources();
+            isPrepared = false;
+        }
+
+        //==============================================================================
+        void processBlocks()
+        {
+            const auto input = static_cast<Input> (random.nextInt (static_cast<int> (Input::numInputs)));
+            const int numBlocks = 1 + random.nextInt (32);
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                // Whole blocks most of the time, otherwise anything down to none at all
+                const int numSamples = random.nextInt (3) == 0 ? random.nextInt (maxBlockSize + 1) : maxBlockSize;
+                fillInput (input, numSamples);
+
+                juce::MidiBuffer midi;
+                addRandomMidi (midi, numSamples);
+
+                // Automation between blocks, the way hosts deliver it
+                if (random.nextInt (4) == 0)
+                    parameterStorm (false);
+
+                processBlock (numSamples, midi);
+            }
+        }
+
+        void fillInput (Input input, int numSamples)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                auto* samples = storage.getWritePointer (channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    switch (input)
+                    {
+                        case Input::testSignal:     samples[i] = testSignal.getSample (channel, (signalPosition + i) % testSignal.getNumSamples()); break;
+                        case Input::square:         samples[i] = ((signalPosition + i) / 37) % 2 == 0 ? 1.0f : -1.0f; break;
+                        case Input::tiny:           samples[i] = 1.0e-36f * (2.0f * random.nextFloat() - 1.0f) + 1.0e-37f; break;
+                        case Input::silence:
+                        case Input::numInputs:      samples[i] = 0.0f; break;
+                    }
+                }
+            }
+
+            signalPosition += numSamples;
+        }
+
+        void addRandomMidi (juce::MidiBuffer& midi, int numSamples)
+        {
+            const auto position = [&] { return random.nextInt (juce::jmax (1, numSamples)); };
+
+            if (random.nextInt (10) == 0)
+                midi.addEvent (juce::MidiMessage::programChange (1, random.nextInt (128)), position());
+
+            if (random.nextInt (5) == 0)
+                midi.addEvent (juce::MidiMessage::noteOn (1, 36 + random.nextInt (48), 0.8f), position());
+
+            if (random.nextInt (5) == 0)
+                midi.addEvent (juce::MidiMessage::noteOff (1, 36 + random.nextInt (48)), position());
+
+            if (random.nextInt (50) == 0)
+                midi.addEvent (juce::MidiMessage::allNotesOff (1), position());
+        }
+
+        void processBlock (int numSamples, juce::MidiBuffer& midi)
+        {
+            juce::AudioBuffer<float> block (storage.getArrayOfWritePointers(), 2, numSamples);
+            RealtimeMonitor::Violations violations;
+
+            if (processor.isNonRealtime())
+            {
+                processor.processBlock (block, midi);
+            }
+            else
+            {
+                const RealtimeMonitor::ScopedAudioCallback callback;
+                processor.processBlock (block, midi);
+                violations = callback.getViolations();
+            }
+
+            const auto badSample = TestHarness::findBadSample (block, numSamples, peakLimit);
+            outcome.check (badSample.isEmpty(), where() + badSample + " in a " + juce::String (numSamples) + "-sample block");
+            outcome.check (! violations.any(), where() + "processBlock made " + violations.toText());
+        }
+
+        //==============================================================================
+        void parameterStorm (bool everyParameter)
+        {
+            const auto& parameters = processor.getParameters();
+            const int numToChange = everyParameter ? parameters.size() : 1 + random.nextInt (8);
+
+            for (int i = 0; i < numToChange; ++i)
+            {
+                auto* parameter = everyParameter ? parameters[i] : parameters[random.nextInt (parameters.size())];
+
+                // The ends of each range as often as anything in between
+                const auto roll = random.nextInt (4);
+                parameter->setValueNotifyingHost (roll == 0 ? 0.0f : roll == 1 ? 1.0f : random.nextFloat());
+            }
+        }
+
+        void changeProgram()
+        {
+            // Out-of-range indexes too, which must be ignored
+            processor.setCurrentProgram (random.nextInt (processor.getNumPrograms() + 2) - 1);
+        }
+
+        void saveOrRestoreState()
+        {
+            const auto roll = random.nextInt (4);
+
+            if (roll == 0 || savedStates.empty())
+            {
+                juce::MemoryBlock state;
+                processor.getStateInformation (state);
+                savedStates.push_back (std::move (state));
+            }
+            else if (roll == 1)
+            {
+                // A damaged or foreign blob must be shrugged off
+                juce::MemoryBlock garbage ((size_t) random.nextInt (256));
+
+                for (size_t i = 0; i < garbage.getSize(); ++i)
+                    garbage[i] = (char) random.nextInt (256);
+
+                processor.setStateInformation (garbage.getData(), (int) garbage.getSize());
+            }
+            else
+            {
+                const auto& state = savedStates[(size_t) random.nextInt ((int) savedStates.size())];
+
+                // Cut short now and then
+                const int size = random.nextInt (5) == 0 ? random.nextInt ((int) state.getSize() + 1) : (int) state.getSize();
+                processor.setStateInformation (state.getData(), size);
+            }
+        }
+
+        void runTimers()
+        {
+            // The processor's timer hands the harmonizer its delay lines and attaches the offload workers
+            juce::MessageManager::getInstance()->runDispatchLoopUntil (1 + random.nextInt (40));
+        }
+
+        //==============================================================================
+        juce::Random random;
+        const juce::int64 seed;
+        TestHarness::Outcome& outcome;
+        NoctaveAudioProcessor processor;
+
+        const juce::AudioBuffer<float> testSignal;
+        juce::AudioBuffer<float> storage;  // The host's buffer, sized by prepare()
+        int signalPosition = 0;
+        std::vector<juce::MemoryBlock> savedStates;
+
+        bool isPrepared = false;
+        double sampleRate = 44100.0;
+        int maxBlockSize = 512;
+        int stepIndex = 0;
+    };
+}
+
+//==============================================================================
+TestHarness::Outcome run (const Options& options)
+{
+    TestHarness::Outcome outcome;
+    outcome.name = "Fuzz (seed " + juce::String (options.seed) + ")";
+
+    Fuzzer fuzzer (options, outcome);
+
+    for (int step = 0; step < options.numSteps; ++step)
+        fuzzer.step (step);
+
+    return outcome;
+}
+}
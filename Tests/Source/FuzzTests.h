@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    FuzzTests.h
+    Drives the plugin through random host behaviour.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TestHarness.h"
+
+//==============================================================================
+/**
+    Plays the part of an unpredictable host: random block sizes up to the
+    prepared maximum (empty blocks included), sample-rate changes, every legal
+    ordering of prepareToPlay and releaseResources, switches between realtime
+    and offline processing, program changes from the host and over MIDI,
+    restored states, and parameter storms that set every parameter between
+    blocks. The input alternates between the test signal, silence, full-scale
+    square waves and values near the denormal range.
+
+    Every block must come out finite, free of denormals and under 0 dBFS, the
+    highest ceiling the limiter allows, and realtime blocks must neither
+    allocate nor lock. A failure names the seed and step, so it can be replayed.
+*/
+namespace FuzzTests
+{
+    struct Options
+    {
+        juce::int64 seed = 1;
+        int numSteps = 2000;
+    };
+
+    TestHarness::Outcome run (const Options& options);
+}
@@ -0,0 +1,287 @@
+/*
+  ==============================================================================
+
+    GoldenTests.cpp
+    Renders fixed material through every engine and compares it with stored output.
+
+  ==============================================================================
+*/
+
+#include "GoldenTests.h"
+
+namespace GoldenTests
+{
+namespace
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr int blockSize = 512;
+    constexpr double signalSeconds = 0.75;
+    constexpr int goldenBitDepth = 24;
+
+    struct Case
+    {
+        juce::String name;
+        TestHarness::Settings settings;
+        TestHarness::Settings halfway = {};    // Changed halfway through, to catch the glides and switches
+    };
+
+    using Engine = NoctaveAudioProcessor::Engine;
+    using Destination = ModulationEngine::Destination;
+
+    float choice (Engine engine)                { return (float) static_cast<int> (engine); }
+    float choice (Destination destination)      { return (float) static_cast<int> (destination); }
+
+    std::vector<Case> getCases()
+    {
+        std::vector<Case> cases
+        {
+            // Delay line
+            { "delay-octave-down",      { { "PITCH_SHIFT", -12.0f } } },
+            { "delay-fifth-half-mix",   { { "PITCH_SHIFT", 7.0f }, { "MIX", 0.5f } } },
+            { "delay-feedback",         { { "PITCH_SHIFT", 12.0f }, { "FEEDBACK", 0.4f } } },
+            { "delay-pitch-jump",       { { "PITCH_SHIFT", 0.0f } }, { { "PITCH_SHIFT", 12.0f } } },
+            { "delay-freeze",           { { "PITCH_SHIFT", -5.0f } }, { { "FREEZE", 1.0f } } },
+            { "delay-transients",       { { "PITCH_SHIFT", -12.0f }, { "TRANSIENT_LOOKAHEAD", 10.0f } } },
+            { "delay-mid-only",         { { "PITCH_SHIFT", -12.0f }, { "STEREO_MODE", 1.0f } } },
+            { "delay-mono-wet",         { { "PITCH_SHIFT", -12.0f }, { "STEREO_MODE", 2.0f } } },
+            { "delay-limiter",          { { "MIX", 0.0f }, { "HARMONIZER", 12.0f }, { "LIMIT_CEILING", -6.0f }, { "LIMIT_RELEASE", 20.0f } } },
+
+            // Harmonizer
+            { "harmony-chromatic",      { { "MIX", 0.7f }, { "HARMONIZER", 4.0f } } },
+            { "harmony-diatonic",       { { "MIX", 0.0f }, { "HARMONIZER", 2.0f }, { "HARMONY_MODE", 1.0f }, { "KEY", 1.0f } } },
+            { "harmony-auto-key-minor", { { "MIX", 0.0f }, { "HARMONIZER", 5.0f }, { "HARMONY_MODE", 1.0f }, { "KEY", 0.0f },
+                                          { "SCALE", (float) static_cast<int> (Scales::Scale::harmonicMinor) } } },
+
+            // Pitch correction
+            { "correct-scale",          { { "CORRECTION", 1.0f }, { "RETUNE_SPEED", 0.0f } } },
+            { "correct-scale-humanise", { { "CORRECTION", 1.0f }, { "RETUNE_SPEED", 100.0f }, { "HUMANISE", 0.6f } } },
+            { "correct-midi",           { { "CORRECTION", 2.0f }, { "RETUNE_SPEED", 20.0f } } },
+
+            // Step sequencer
+            { "sequencer",              { { "SEQ_ON", 1.0f }, { "SEQ_RATE", 3.0f }, { "SEQ_LENGTH", 4.0f },
+                                          { "SEQ_PITCH_2", 12.0f }, { "SEQ_PITCH_3", -12.0f }, { "SEQ_PITCH_4", 7.0f },
+                                          { "SEQ_HARMONY_1", 4.0f }, { "SEQ_HARMONY_3", -5.0f } } },
+
+            // Modulation
+            { "mod-envelope-mix",       { { "PITCH_SHIFT", -12.0f }, { "MOD_ENV_TARGET", choice (Destination::mix) }, { "MOD_ENV_DEPTH", -0.8f } } },
+            { "mod-random-harmony",     { { "MIX", 0.5f }, { "HARMONIZER", 7.0f },
+                                          { "MOD_RANDOM_TARGET", choice (Destination::harmony) }, { "MOD_RANDOM_DEPTH", 0.3f } } },
+            { "mod-lfo-feedback",       { { "PITCH_SHIFT", 5.0f }, { "MOD_LFO_TARGET", choice (Destination::feedback) }, { "MOD_LFO_DEPTH", 0.7f } } },
+
+            // Analog octave
+            { "analog-down",            { { "ENGINE", choice (Engine::analogOctave) }, { "PITCH_SHIFT", -12.0f } } },
+            { "analog-two-down-mix",    { { "ENGINE", choice (Engine::analogOctave) }, { "PITCH_SHIFT", -24.0f }, { "MIX", 0.5f } } },
+            { "analog-up",              { { "ENGINE", choice (Engine::analogOctave) }, { "PITCH_SHIFT", 12.0f } } },
+
+            // Poly octave
+            { "poly-up",                { { "ENGINE", choice (Engine::polyOctave) }, { "PITCH_SHIFT", 12.0f } } },
+            { "poly-two-down",          { { "ENGINE", choice (Engine::polyOctave) }, { "PITCH_SHIFT", -24.0f } } },
+            { "poly-offload",           { { "ENGINE", choice (Engine::polyOctave) }, { "PITCH_SHIFT", -12.0f }, { "POLY_OFFLOAD", 1.0f } } },
+            { "poly-engine-switch",     { { "ENGINE", choice (Engine::polyOctave) }, { "PITCH_SHIFT", -12.0f } },
+                                        { { "ENGINE", choice (Engine::delayLine) } } },
+        };
+
+        // Every interpolation kernel, every Poly Bands size and every LFO shape
+        for (int kernel = 0; kernel < Interpolation::getKernelNames().size(); ++kernel)
+            cases.push_back ({ "delay-kernel-" + juce::String (kernel), { { "PITCH_SHIFT", 5.0f }, { "INTERPOLATION", (float) kernel } } });
+
+        for (int bands = 0; bands < PolyOctave::getBandCountNames().size(); ++bands)
+            cases.push_back ({ "poly-down-bands-" + juce::String (bands),
+                               { { "ENGINE", choice (Engine::polyOctave) }, { "PITCH_SHIFT", -12.0f }, { "POLY_BANDS", (float) bands } } });
+
+        for (int shape = 0; shape < ModulationEngine::getShapeNames().size(); ++shape)
+            cases.push_back ({ "mod-lfo-pitch-shape-" + juce::String (shape),
+                               { { "MOD_LFO_SHAPE", (float) shape }, { "MOD_LFO_RATE", 4.0f },
+                                 { "MOD_LFO_TARGET", choice (Destination::pitch) }, { "MOD_LFO_DEPTH", 0.25f } } });
+
+        return cases;
+    }
+
+    // A note held over each third, for the MIDI correction case; the others only note them
+    juce::MidiBuffer makeMidi (int length)
+    {
+        juce::MidiBuffer midi;
+        const int notes[] = { 57, 60, 64 };
+        const int noteLength = length / (int) std::size (notes);
+
+        for (int i = 0; i < (int) std::size (notes); ++i)
+        {
+            midi.addEvent (juce::MidiMessage::noteOn (1, notes[i], 0.8f), i * noteLength);
+            midi.addEvent (juce::MidiMessage::noteOff (1, notes[i]), (i + 1) * noteLength - 1);
+        }
+
+        return midi;
+    }
+
+    struct Rendered
+    {
+        juce::AudioBuffer<float> audio;
+        float ceilingDecibels = 0.0f;
+    };
+
+    Rendered render (const Case& testCase, const juce::AudioBuffer<float>& input, const juce::MidiBuffer& midi)
+    {
+        // Offline, so nothing depends on timers or on how busy the workers are
+        auto processor = TestHarness::createProcessor (sampleRate, blockSize, false);
+        TestHarness::apply (*processor, testCase.settings);
+
+        Rendered rendered;
+        rendered.ceilingDecibels = processor->limitCeilingParam->load();
+
+        auto& output = rendered.audio;
+        output.makeCopyOf (input);
+
+        const int length = output.getNumSamples();
+        bool changedHalfway = false;
+
+        for (int start = 0; start < length; start += blockSize)
+        {
+            const int numSamples = juce::jmin (blockSize, length - start);
+
+            if (! changedHalfway && start >= length / 2)
+            {
+                TestHarness::apply (*processor, testCase.halfway);
+                changedHalfway = true;
+            }
+
+            juce::AudioBuffer<float> block (output.getArrayOfWritePointers(), output.getNumChannels(), start, numSamples);
+            juce::MidiBuffer blockMidi;
+            blockMidi.addEvents (midi, start, numSamples, -start);
+
+            processor->processBlock (block, blockMidi);
+        }
+
+        processor->releaseResources();
+        return rendered;
+    }
+
+    bool writeGolden (const juce::File& file, const juce::AudioBuffer<float>& audio)
+    {
+        if (file.getParentDirectory().createDirectory().failed())
+            return false;
+
+        file.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if (stream->openedOk())
+            writer.reset (juce::WavAudioFormat().createWriterFor (stream.get(), sampleRate, (unsigned int) audio.getNumChannels(),
+                                                                  goldenBitDepth, {}, 0));
+
+        if (writer != nullptr)
+            stream.release(); // Owned by the writer now
+
+        return writer != nullptr && writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples());
+    }
+
+    std::optional<juce::AudioBuffer<float>> readGolden (const juce::File& file)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader (juce::WavAudioFormat().createReaderFor (file.createInputStream().release(), true));
+
+        if (reader == nullptr || reader->lengthInSamples > std::numeric_limits<int>::max())
+            return std::nullopt;
+
+        juce::AudioBuffer<float> audio ((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read (&audio, 0, audio.getNumSamples(), 0, true, true);
+        return audio;
+    }
+
+    // Empty if the output matches, otherwise where it first differs and by how much at most
+    juce::String compare (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& golden, float tolerance)
+    {
+        if (output.getNumChannels() != golden.getNumChannels() || output.getNumSamples() != golden.getNumSamples())
+            return "is " + juce::String (output.getNumChannels()) + " x " + juce::String (output.getNumSamples())
+                     + " samples, the golden file " + juce::String (golden.getNumChannels()) + " x " + juce::String (golden.getNumSamples());
+
+        float maxDeviation = 0.0f;
+        int firstSample = -1, firstChannel = -1;
+
+        for (int channel = 0; channel < output.getNumChannels(); ++channel)
+        {
+            const auto* rendered = output.getReadPointer (channel);
+            const auto* expected = golden.getReadPointer (channel);
+
+            for (int i = 0; i < output.getNumSamples(); ++i)
+            {
+                const auto deviation = std::abs (rendered[i] - expected[i]);
+
+                // A NaN compares false with everything, so it's caught as a difference too
+                if (! (deviation <= tolerance))
+                {
+                    if (firstSample < 0 || i < firstSample)
+                    {
+                        firstSample = i;
+                        firstChannel = channel;
+                    }
+
+                    maxDeviation = std::isnan (deviation) ? deviation : juce::jmax (maxDeviation, deviation);
+                }
+            }
+        }
+
+        if (firstSample < 0)
+            return {};
+
+        return "differs from sample " + juce::String (firstSample) + " of channel " + juce::String (firstChannel)
+                 + " (" + juce::String (firstSample / sampleRate, 3) + " s), by up to "
+                 + juce::String (juce::Decibels::gainToDecibels (maxDeviation), 1) + " dBFS";
+    }
+}
+
+//==============================================================================
+TestHarness::Outcome run (const Options& options)
+{
+    TestHarness::Outcome outcome;
+    outcome.name = options.update ? "Golden (recording)" : "Golden";
+
+    const auto input = TestHarness::makeTestSignal (sampleRate, signalSeconds);
+    const auto midi = makeMidi (input.getNumSamples());
+
+    // With no baseline at all, say so once; the renders are still checked for bad samples
+    const bool hasBaseline = options.folder.getNumberOfChildFiles (juce::File::findFiles, "*.wav") > 0;
+
+    if (! options.update)
+        outcome.check (hasBaseline, "no golden files in " + options.folder.getFullPathName()
+                                      + ", so nothing was compared (record them with --update-golden on a known-good build)");
+
+    for (const auto& testCase : getCases())
+    {
+        const auto output = render (testCase, input, midi);
+        const auto file = options.folder.getChildFile (testCase.name + ".wav");
+
+        // Whatever the golden file says, the output must be clean and held under the
+        // limiter's ceiling, give or take 0.01 dB of rounding
+        const auto peakLimit = juce::Decibels::decibelsToGain (output.ceilingDecibels + 0.01f);
+        const auto badSample = TestHarness::findBadSample (output.audio, output.audio.getNumSamples(), peakLimit);
+        outcome.check (badSample.isEmpty(), testCase.name + ": " + badSample);
+
+        if (options.update)
+        {
+            outcome.check (writeGolden (file, output.audio), testCase.name + ": couldn't write " + file.getFullPathName());
+            continue;
+        }
+
+        if (! hasBaseline)
+            continue;
+
+        if (! file.existsAsFile())
+        {
+            outcome.check (false, testCase.name + ": no golden file at " + file.getFullPathName() + " (record them with --update-golden)");
+            continue;
+        }
+
+        if (const auto golden = readGolden (file))
+        {
+            const auto difference = compare (output.audio, *golden, options.tolerance);
+            outcome.check (difference.isEmpty(), testCase.name + ": " + difference);
+        }
+        else
+        {
+            outcome.check (false, testCase.name + ": couldn't read " + file.getFullPathName());
+        }
+    }
+
+    return outcome;
+}
+}
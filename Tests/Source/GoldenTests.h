@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    GoldenTests.h
+    Renders fixed material through every engine and compares it with stored output.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TestHarness.h"
+
+//==============================================================================
+/**
+    Catches changes in what the plugin sounds like. Each case renders the test
+    signal offline through one engine and a set of settings, and the output
+    has to match the case's golden file sample for sample, within a tolerance
+    that allows for the kernels picked on different CPUs. Every engine is
+    covered, and every choice of every switch appears in at least one case.
+
+    Golden files are 24-bit stereo WAVs named after their cases. After a change
+    that is meant to alter the sound, run with --update-golden to record them
+    again, listen to the difference, and commit the new files with the change.
+*/
+namespace GoldenTests
+{
+    struct Options
+    {
+        juce::File folder;              // Holds one .wav per case
+        bool update = false;            // Record the golden files instead of comparing
+        float tolerance = 1.0e-4f;      // Largest difference allowed from a golden sample
+    };
+
+    TestHarness::Outcome run (const Options& options);
+}
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command-line entry point of the regression and realtime-safety tests.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "GoldenTests.h"
+#include "FuzzTests.h"
+#include "SafetyTests.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: NoctaveTests [--only golden|fuzz|safety] [--golden <folder>] [--update-golden]\n"
+                     "                    [--tolerance <linear>] [--seed <n>] [--steps <n>] [--seconds <n>]\n\n"
+                     "Runs the golden-file comparison, the host fuzzer and the realtime-safety run,\n"
+                     "and exits with 1 if anything failed.\n\n"
+                     "--golden         Folder of golden files (default: Golden beside NoctaveTests.jucer)\n"
+                     "--update-golden  Record the golden files from this build instead of comparing\n"
+                     "--tolerance      Largest difference from a golden sample (default 1e-4)\n"
+                     "--seed, --steps  The fuzzer's random seed and number of steps (default 1 and 2000)\n"
+                     "--seconds        How long the realtime-safety run takes in all (default 20)\n";
+    }
+
+    // The executable sits somewhere under Tests/Builds, so look upwards for the project
+    juce::File findDefaultGoldenFolder()
+    {
+        for (auto folder = juce::File::getSpecialLocation (juce::File::currentExecutableFile).getParentDirectory();
+             ! folder.isRoot(); folder = folder.getParentDirectory())
+        {
+            if (folder.getChildFile ("NoctaveTests.jucer").existsAsFile())
+                return folder.getChildFile ("Golden");
+        }
+
+        return juce::File::getCurrentWorkingDirectory().getChildFile ("Golden");
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    const juce::ArgumentList arguments (argc, argv);
+
+    if (arguments.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    const auto only = arguments.getValueForOption ("--only");
+
+    if (only.isNotEmpty() && ! juce::StringArray { "golden", "fuzz", "safety" }.contains (only))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const auto shouldRun = [&only] (const char* part) { return only.isEmpty() || only == part; };
+
+    // The processors start timers, and the tests run them, so this thread is the message thread
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::vector<TestHarness::Outcome> outcomes;
+
+    if (shouldRun ("golden"))
+    {
+        GoldenTests::Options options;
+        options.folder = arguments.containsOption ("--golden") ? arguments.getFileForOption ("--golden") : findDefaultGoldenFolder();
+        options.update = arguments.containsOption ("--update-golden");
+
+        if (arguments.containsOption ("--tolerance"))
+            options.tolerance = arguments.getValueForOption ("--tolerance").getFloatValue();
+
+        std::cout << "Golden files in " << options.folder.getFullPathName() << std::endl;
+        outcomes.push_back (GoldenTests::run (options));
+        std::cout << outcomes.back().toText() << std::flush;
+    }
+
+    if (shouldRun ("fuzz"))
+    {
+        FuzzTests::Options options;
+
+        if (arguments.containsOption ("--seed"))
+            options.seed = arguments.getValueForOption ("--seed").getLargeIntValue();
+
+        if (arguments.containsOption ("--steps"))
+            options.numSteps = juce::jmax (1, arguments.getValueForOption ("--steps").getIntValue());
+
+        outcomes.push_back (FuzzTests::run (options));
+        std::cout << outcomes.back().toText() << std::flush;
+    }
+
+    if (shouldRun ("safety"))
+    {
+        SafetyTests::Options options;
+
+        if (arguments.containsOption ("--seconds"))
+            options.seconds = juce::jmax (1.0, arguments.getValueForOption ("--seconds").getDoubleValue());
+
+        outcomes.push_back (SafetyTests::run (options));
+        std::cout << outcomes.back().toText() << std::flush;
+    }
+
+    const bool allPassed = std::all_of (outcomes.begin(), outcomes.end(), [] (const auto& outcome) { return outcome.passed(); });
+    std::cout << (allPassed ? "\nAll tests passed.\n" : "\nSome tests failed.\n");
+
+    return allPassed ? 0 : 1;
+}
@@ -0,0 +1,301 @@
+/*
+  ==============================================================================
+
+    RealtimeMonitor.cpp
+    Catches allocations and locks made inside the audio callback.
+
+  ==============================================================================
+*/
+
+#include "RealtimeMonitor.h"
+#include "../../Source/RealtimeChecks.h"
+#include <new>
+
+#if JUCE_LINUX && defined (__GLIBC__)
+ #define NOCTAVE_WATCH_SYSTEM_CALLS 1
+ #include <dlfcn.h>
+ #include <pthread.h>
+
+// glibc's own allocator, which the replacements below pass everything on to
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void* __libc_valloc (size_t);
+    void __libc_free (void*);
+}
+#else
+ #define NOCTAVE_WATCH_SYSTEM_CALLS 0
+ #if JUCE_WINDOWS
+  #include <malloc.h>
+ #endif
+#endif
+
+namespace
+{
+    // Constant-initialised thread_locals, so reading them from inside malloc never allocates
+    thread_local bool insideCallback = false;
+    thread_local RealtimeMonitor::Violations threadCounts;
+
+    bool isInsideCallback() noexcept
+    {
+        return insideCallback || RealtimeChecks::isRealtimeThread();
+    }
+
+    void noteAllocation() noexcept
+    {
+        if (isInsideCallback())
+            ++threadCounts.allocations;
+    }
+
+    void noteFree (void* pointer) noexcept
+    {
+        if (pointer != nullptr && isInsideCallback())
+            ++threadCounts.frees;
+    }
+
+    // Straight to the system allocator. With malloc replaced too, going through it would count twice.
+    void* allocate (size_t size) noexcept
+    {
+       #if NOCTAVE_WATCH_SYSTEM_CALLS
+        return __libc_malloc (size == 0 ? 1 : size);
+       #else
+        return std::malloc (size == 0 ? 1 : size);
+       #endif
+    }
+
+    void release (void* pointer) noexcept
+    {
+       #if NOCTAVE_WATCH_SYSTEM_CALLS
+        __libc_free (pointer);
+       #else
+        std::free (pointer);
+       #endif
+    }
+
+    void* allocateAligned (size_t size, std::align_val_t alignment) noexcept
+    {
+        size = size == 0 ? 1 : size;
+
+       #if NOCTAVE_WATCH_SYSTEM_CALLS
+        return __libc_memalign ((size_t) alignment, size);
+       #elif JUCE_WINDOWS
+        return _aligned_malloc (size, (size_t) alignment);
+       #else
+        void* pointer = nullptr;
+        return posix_memalign (&pointer, (size_t) alignment, size) == 0 ? pointer : nullptr;
+       #endif
+    }
+
+    void releaseAligned (void* pointer) noexcept
+    {
+       #if JUCE_WINDOWS && ! NOCTAVE_WATCH_SYSTEM_CALLS
+        _aligned_free (pointer);
+       #else
+        release (pointer);
+       #endif
+    }
+
+   #if NOCTAVE_WATCH_SYSTEM_CALLS
+    using LockFunction = int (*) (pthread_mutex_t*);
+
+    LockFunction getSystemLock() noexcept
+    {
+        static std::atomic<LockFunction> function { nullptr };
+
+        // dlsym locks with glibc's internal calls, which don't come back through the wrapper
+        if (function.load (std::memory_order_acquire) == nullptr)
+            function.store (reinterpret_cast<LockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock")), std::memory_order_release);
+
+        return function.load (std::memory_order_acquire);
+    }
+
+    // Looked up while the program starts, never from inside a watched callback
+    [[maybe_unused]] const auto systemLock = getSystemLock();
+   #endif
+}
+
+//==============================================================================
+namespace RealtimeMonitor
+{
+juce::String Violations::toText() const
+{
+    juce::StringArray parts;
+
+    const auto add = [&parts] (juce::uint64 count, const char* noun)
+    {
+        if (count > 0)
+            parts.add (juce::String ((juce::int64) count) + " " + noun + (count == 1 ? "" : "s"));
+    };
+
+    add (allocations, "allocation");
+    add (frees, "free");
+    add (locks, "lock");
+
+    return parts.isEmpty() ? juce::String ("nothing") : parts.joinIntoString (", ");
+}
+
+ScopedAudioCallback::ScopedAudioCallback() noexcept
+    : atStart (threadCounts), wasInside (std::exchange (insideCallback, true))
+{
+}
+
+ScopedAudioCallback::~ScopedAudioCallback()
+{
+    insideCallback = wasInside;
+}
+
+Violations ScopedAudioCallback::getViolations() const noexcept
+{
+    Violations since;
+    since.allocations = threadCounts.allocations - atStart.allocations;
+    since.frees = threadCounts.frees - atStart.frees;
+    since.locks = threadCounts.locks - atStart.locks;
+    return since;
+}
+
+bool isWatchingSystemCalls() noexcept
+{
+    return NOCTAVE_WATCH_SYSTEM_CALLS != 0;
+}
+}
+
+//==============================================================================
+// Replacements for the global allocation functions, used by everything in the executable
+
+void* operator new (std::size_t size)
+{
+    noteAllocation();
+
+    if (auto* pointer = allocate (size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    noteAllocation();
+    return allocate (size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    noteAllocation();
+    return allocate (size);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    noteAllocation();
+
+    if (auto* pointer = allocateAligned (size, alignment))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    return operator new (size, alignment);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    noteAllocation();
+    return allocateAligned (size, alignment);
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    noteAllocation();
+    return allocateAligned (size, alignment);
+}
+
+void operator delete (void* pointer) noexcept                                                { noteFree (pointer); release (pointer); }
+void operator delete[] (void* pointer) noexcept                                              { noteFree (pointer); release (pointer); }
+void operator delete (void* pointer, std::size_t) noexcept                                   { noteFree (pointer); release (pointer); }
+void operator delete[] (void* pointer, std::size_t) noexcept                                 { noteFree (pointer); release (pointer); }
+void operator delete (void* pointer, const std::nothrow_t&) noexcept                         { noteFree (pointer); release (pointer); }
+void operator delete[] (void* pointer, const std::nothrow_t&) noexcept                       { noteFree (pointer); release (pointer); }
+void operator delete (void* pointer, std::align_val_t) noexcept                              { noteFree (pointer); releaseAligned (pointer); }
+void operator delete[] (void* pointer, std::align_val_t) noexcept                            { noteFree (pointer); releaseAligned (pointer); }
+void operator delete (void* pointer, std::size_t, std::align_val_t) noexcept                 { noteFree (pointer); releaseAligned (pointer); }
+void operator delete[] (void* pointer, std::size_t, std::align_val_t) noexcept               { noteFree (pointer); releaseAligned (pointer); }
+void operator delete (void* pointer, std::align_val_t, const std::nothrow_t&) noexcept       { noteFree (pointer); releaseAligned (pointer); }
+void operator delete[] (void* pointer, std::align_val_t, const std::nothrow_t&) noexcept     { noteFree (pointer); releaseAligned (pointer); }
+
+//==============================================================================
+#if NOCTAVE_WATCH_SYSTEM_CALLS
+// glibc lets a program replace malloc and its relatives, and the executable's
+// pthread_mutex_lock comes before the C library's for every caller
+extern "C"
+{
+    void* malloc (size_t size) noexcept
+    {
+        noteAllocation();
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t count, size_t size) noexcept
+    {
+        noteAllocation();
+        return __libc_calloc (count, size);
+    }
+
+    void* realloc (void* pointer, size_t size) noexcept
+    {
+        noteAllocation();
+        return __libc_realloc (pointer, size);
+    }
+
+    void free (void* pointer) noexcept
+    {
+        noteFree (pointer);
+        __libc_free (pointer);
+    }
+
+    void* memalign (size_t alignment, size_t size) noexcept
+    {
+        noteAllocation();
+        return __libc_memalign (alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size) noexcept
+    {
+        noteAllocation();
+        return __libc_memalign (alignment, size);
+    }
+
+    void* valloc (size_t size) noexcept
+    {
+        noteAllocation();
+        return __libc_valloc (size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size) noexcept
+    {
+        if (alignment < sizeof (void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        noteAllocation();
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex) noexcept
+    {
+        if (isInsideCallback())
+            ++threadCounts.locks;
+
+        return getSystemLock() (mutex);
+    }
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    RealtimeMonitor.h
+    Catches allocations and locks made inside the audio callback.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Counts what a thread does while it's marked as inside the audio callback,
+    in every build configuration.
+
+    The test executable replaces the global operator new and delete, so any
+    C++ allocation is seen. On Linux with glibc it also replaces malloc and
+    its relatives, which juce::HeapBlock and juce::AudioBuffer use, and wraps
+    pthread_mutex_lock, which juce::CriticalSection and std::mutex both come
+    down to. A thread counts as inside the callback while a ScopedAudioCallback
+    is alive on it, or while the plugin's own RealtimeChecks flag is set in a
+    debug build.
+*/
+namespace RealtimeMonitor
+{
+    struct Violations
+    {
+        juce::uint64 allocations = 0;   // Including reallocations
+        juce::uint64 frees = 0;
+        juce::uint64 locks = 0;
+
+        bool any() const noexcept       { return allocations > 0 || frees > 0 || locks > 0; }
+
+        /** For example "2 allocations, 1 lock". */
+        juce::String toText() const;
+    };
+
+    /** Marks the calling thread as inside the audio callback for the object's lifetime,
+        and keeps count of what it does meanwhile. Neither allocates nor locks.
+    */
+    class ScopedAudioCallback
+    {
+    public:
+        ScopedAudioCallback() noexcept;
+        ~ScopedAudioCallback();
+
+        /** What the thread has done since this object was created. */
+        Violations getViolations() const noexcept;
+
+    private:
+        Violations atStart;
+        bool wasInside = false;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedAudioCallback)
+    };
+
+    /** True where malloc and pthread_mutex_lock are watched, not only operator new. */
+    bool isWatchingSystemCalls() noexcept;
+}
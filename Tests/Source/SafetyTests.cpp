@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    SafetyTests.cpp
+    Checks the audio callback stays realtime-safe while a host works around it.
+
+  ==============================================================================
+*/
+
+#include "SafetyTests.h"
+#include "RealtimeMonitor.h"
+
+namespace SafetyTests
+{
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+
+    const float peakLimit = juce::Decibels::decibelsToGain (0.01f);
+
+    // The harmonizer comes on for a moment in every cycle, then stays off long enough
+    // for the timer to take its delay lines back
+    constexpr double harmonizerCycleSeconds = 2.5;
+    constexpr double harmonizerOnSeconds = 0.2;
+
+    // What the host automates and the editor moves while the audio runs
+    const char* const automatedParameterIDs[] = { "PITCH_SHIFT", "MIX", "FEEDBACK", "LIMIT_CEILING",
+                                                  "RETUNE_SPEED", "MOD_LFO_DEPTH", "SEQ_PITCH_1" };
+
+    struct Configuration
+    {
+        juce::String name;
+        TestHarness::Settings settings;
+    };
+
+    std::vector<Configuration> getConfigurations()
+    {
+        using Engine = NoctaveAudioProcessor::Engine;
+        using Destination = ModulationEngine::Destination;
+
+        const auto engine = [] (Engine e) { return TestHarness::Setting { "ENGINE", (float) static_cast<int> (e) }; };
+        const auto target = [] (const char* id, Destination d) { return TestHarness::Setting { id, (float) static_cast<int> (d) }; };
+
+        return {
+            { "delay line",         { engine (Engine::delayLine), { "PITCH_SHIFT", -12.0f }, { "FEEDBACK", 0.3f },
+                                      { "TRANSIENT_LOOKAHEAD", 5.0f } } },
+            { "diatonic harmony",   { { "HARMONIZER", 4.0f }, { "HARMONY_MODE", 1.0f }, { "KEY", 0.0f } } },
+            { "MIDI correction and sequencer",
+                                    { { "CORRECTION", 2.0f }, { "SEQ_ON", 1.0f }, { "SEQ_LENGTH", 8.0f }, { "SEQ_HARMONY_2", 7.0f } } },
+            { "modulation",         { { "HARMONIZER", 7.0f }, target ("MOD_LFO_TARGET", Destination::pitch), { "MOD_LFO_DEPTH", 0.5f },
+                                      target ("MOD_ENV_TARGET", Destination::mix), { "MOD_ENV_DEPTH", -0.5f },
+                                      target ("MOD_RANDOM_TARGET", Destination::harmony), { "MOD_RANDOM_DEPTH", 0.3f } } },
+            { "freeze",             { { "PITCH_SHIFT", 7.0f }, { "FREEZE", 1.0f } } },
+            { "analog octave",      { engine (Engine::analogOctave), { "PITCH_SHIFT", -12.0f }, { "STEREO_MODE", 1.0f } } },
+            { "poly octave",        { engine (Engine::polyOctave), { "PITCH_SHIFT", -12.0f },
+                                      { "POLY_BANDS", (float) (PolyOctave::getBandCountNames().size() - 1) } } },
+            { "poly offload",       { engine (Engine::polyOctave), { "PITCH_SHIFT", 12.0f }, { "POLY_OFFLOAD", 1.0f },
+                                      { "STEREO_MODE", 2.0f } } },
+        };
+    }
+
+    //==============================================================================
+    /*
+        Plays the host's audio thread: a block every millisecond or so, a few times
+        faster than realtime, with automation and MIDI between blocks. Only this
+        thread touches its outcome until it has stopped.
+    */
+    class AudioThread  : public juce::Thread
+    {
+    public:
+        AudioThread (NoctaveAudioProcessor& processorToPlay, const juce::String& configurationName)
+            : juce::Thread ("Noctave test audio"),
+              processor (processorToPlay), name (configurationName),
+              input (TestHarness::makeTestSignal (sampleRate, 2.0))
+        {
+        }
+
+        ~AudioThread() override
+        {
+            stopThread (4000);
+        }
+
+        void run() override
+        {
+            juce::Random random (43);
+            juce::AudioBuffer<float> buffer (2, blockSize);
+            juce::MidiBuffer midi;
+            int position = 0;
+
+            while (! threadShouldExit())
+            {
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample (channel, i, input.getSample (channel, (position + i) % input.getNumSamples()));
+
+                position += blockSize;
+
+                if (random.nextInt (8) == 0)
+                {
+                    const auto* parameterID = automatedParameterIDs[random.nextInt ((int) std::size (automatedParameterIDs))];
+                    processor.apvts.getParameter (parameterID)->setValueNotifyingHost (random.nextFloat());
+                }
+
+                midi.clear();
+
+                if (random.nextInt (16) == 0)
+                    midi.addEvent (juce::MidiMessage::noteOn (1, 48 + random.nextInt (24), 0.8f), random.nextInt (blockSize));
+
+                if (random.nextInt (16) == 0)
+                    midi.addEvent (juce::MidiMessage::noteOff (1, 48 + random.nextInt (24)), random.nextInt (blockSize));
+
+                RealtimeMonitor::Violations violations;
+
+                {
+                    const RealtimeMonitor::ScopedAudioCallback callback;
+                    processor.processBlock (buffer, midi);
+                    violations = callback.getViolations();
+                }
+
+                const auto badSample = TestHarness::findBadSample (buffer, blockSize, peakLimit);
+                const auto where = [this] { return name + ", block " + juce::String (numBlocks) + ": "; };
+
+                outcome.check (badSample.isEmpty(), where() + badSample);
+                outcome.check (! violations.any(), where() + "processBlock made " + violations.toText());
+                ++numBlocks;
+
+                juce::Thread::sleep (1);
+            }
+        }
+
+        TestHarness::Outcome outcome;
+        int numBlocks = 0;
+
+    private:
+        NoctaveAudioProcessor& processor;
+        const juce::String name;
+        const juce::AudioBuffer<float> input;
+    };
+
+    // Plays one configuration for a while, doing the message thread's work meanwhile
+    void play (const Configuration& configuration, double seconds, TestHarness::Outcome& outcome)
+    {
+        auto processor = TestHarness::createProcessor (sampleRate, blockSize, true);
+        TestHarness::apply (*processor, configuration.settings);
+
+        const bool setsHarmonizer = std::any_of (configuration.settings.begin(), configuration.settings.end(),
+                                                 [] (const auto& setting) { return setting.parameterID == "HARMONIZER"; });
+
+        AudioThread audioThread (*processor, configuration.name);
+        audioThread.startThread (juce::Thread::Priority::highest);
+
+        juce::Random random (44);
+        juce::MemoryBlock state;
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        for (;;)
+        {
+            const auto elapsed = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+            if (elapsed >= seconds)
+                break;
+
+            juce::MessageManager::getInstance()->runDispatchLoopUntil (20);
+
+            if (! setsHarmonizer)
+                TestHarness::apply (*processor, { { "HARMONIZER", std::fmod (elapsed, harmonizerCycleSeconds) < harmonizerOnSeconds ? 7.0f : 0.0f } });
+
+            // A host saving the session, and a control moved in the editor
+            processor->getStateInformation (state);
+
+            const auto* parameterID = automatedParameterIDs[random.nextInt ((int) std::size (automatedParameterIDs))];
+            processor->apvts.getParameter (parameterID)->setValueNotifyingHost (random.nextFloat());
+        }
+
+        audioThread.stopThread (4000);
+        processor->releaseResources();
+
+        outcome.numChecks += audioThread.outcome.numChecks;
+        outcome.failures.addArray (audioThread.outcome.failures);
+        outcome.check (audioThread.numBlocks > 0, configuration.name + ": the audio thread didn't get to process anything");
+    }
+}
+
+//==============================================================================
+TestHarness::Outcome run (const Options& options)
+{
+    TestHarness::Outcome outcome;
+    outcome.name = "Realtime safety";
+
+    const auto configurations = getConfigurations();
+
+    // Long enough for at least one full harmonizer cycle each
+    const auto secondsEach = juce::jmax (harmonizerCycleSeconds, options.seconds / (double) configurations.size());
+
+    for (const auto& configuration : configurations)
+        play (configuration, secondsEach, outcome);
+
+    if (! RealtimeMonitor::isWatchingSystemCalls())
+        outcome.name << " (operator new only; malloc and locks are watched on Linux)";
+
+    return outcome;
+}
+}
@@ -0,0 +1,34 @@
+/*
+  ==============================================================================
+
+    SafetyTests.h
+    Checks the audio callback stays realtime-safe while a host works around it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TestHarness.h"
+
+//==============================================================================
+/**
+    Runs each engine and feature in realtime on an audio thread of its own,
+    with automation arriving between blocks, while the message thread does
+    what a host and an open editor do meanwhile: runs the processor's timers,
+    saves the state, moves controls, and switches the harmonizer on and off
+    long enough for its delay lines to be handed over and taken back.
+
+    Every block is checked for NaNs, infinities, denormals and peaks over
+    0 dBFS, and fails if processBlock allocated, freed or locked anything.
+*/
+namespace SafetyTests
+{
+    struct Options
+    {
+        double seconds = 20.0;      // Shared between the configurations
+    };
+
+    TestHarness::Outcome run (const Options& options);
+}
@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    TestHarness.cpp
+    Shared pieces of the regression and realtime-safety tests.
+
+  ==============================================================================
+*/
+
+#include "TestHarness.h"
+
+namespace TestHarness
+{
+//==============================================================================
+void Outcome::check (bool passed, const juce::String& description)
+{
+    ++numChecks;
+
+    if (! passed)
+        failures.add (description);
+}
+
+juce::String Outcome::toText() const
+{
+    if (passed())
+        return name + ": " + juce::String (numChecks) + " checks, all passed\n";
+
+    // The first few say what broke; a thousand more of the same wouldn't help
+    constexpr int maxListed = 20;
+
+    juce::String text = name + ": " + juce::String (failures.size()) + " of " + juce::String (numChecks) + " checks failed\n";
+
+    for (int i = 0; i < juce::jmin (maxListed, failures.size()); ++i)
+        text << "  " << failures[i] << "\n";
+
+    if (failures.size() > maxListed)
+        text << "  ...and " << (failures.size() - maxListed) << " more\n";
+
+    return text;
+}
+
+//==============================================================================
+juce::AudioBuffer<float> makeTestSignal (double sampleRate, double seconds)
+{
+    const int length = juce::jmax (1, (int) (sampleRate * seconds));
+    const int sectionLength = length / 3;
+    juce::AudioBuffer<float> signal (2, length);
+    signal.clear();
+
+    const auto twoPi = juce::MathConstants<double>::twoPi;
+
+    // A log sweep from 80 Hz to 4 kHz, a little lower on the right
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* samples = signal.getWritePointer (channel);
+        const double scale = channel == 0 ? 1.0 : 0.7;
+        double phase = 0.0;
+
+        for (int i = 0; i < sectionLength; ++i)
+        {
+            const auto frequency = 80.0 * std::pow (50.0, (double) i / sectionLength) * scale;
+            phase += twoPi * frequency / sampleRate;
+            samples[i] = (float) (0.5 * std::sin (phase));
+        }
+    }
+
+    // Plucked notes, a fifth apart on the two sides. The last one dies away quickly
+    // enough to pass through the denormal range before the section ends.
+    const double notes[] = { 110.0, 130.81, 164.81, 220.0, 196.0 };
+    const int noteLength = sectionLength / (int) std::size (notes);
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* samples = signal.getWritePointer (channel, sectionLength);
+
+        for (int note = 0; note < (int) std::size (notes); ++note)
+        {
+            const bool isLast = note == (int) std::size (notes) - 1;
+            const auto frequency = notes[note] * (channel == 0 ? 1.0 : 1.5);
+            const auto decaySeconds = isLast ? 0.0004 : 0.05;
+
+            for (int i = 0; i < noteLength; ++i)
+            {
+                const auto t = i / sampleRate;
+                const auto envelope = 0.6 * std::exp (-t / decaySeconds);
+                const auto tone = std::sin (twoPi * frequency * t)
+                                    + 0.5 * std::sin (twoPi * 2.0 * frequency * t)
+                                    + 0.25 * std::sin (twoPi * 3.0 * frequency * t);
+
+                samples[note * noteLength + i] = (float) (envelope * tone / 1.75);
+            }
+        }
+    }
+
+    // Bursts of noise, 20 ms on and 30 ms off, different on each side
+    juce::Random random (36);
+    const int burstPeriod = juce::jmax (1, (int) (sampleRate * 0.05));
+    const int burstLength = (int) (sampleRate * 0.02);
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto* samples = signal.getWritePointer (channel);
+
+        for (int i = 2 * sectionLength; i < length; ++i)
+            if ((i - 2 * sectionLength) % burstPeriod < burstLength)
+                samples[i] = 0.3f * (2.0f * random.nextFloat() - 1.0f);
+    }
+
+    return signal;
+}
+
+//==============================================================================
+std::unique_ptr<NoctaveAudioProcessor> createProcessor (double sampleRate, int maxBlockSize, bool isRealtime)
+{
+    auto processor = std::make_unique<NoctaveAudioProcessor>();
+    processor->setPlayConfigDetails (2, 2, sampleRate, maxBlockSize);
+    processor->setNonRealtime (! isRealtime);
+    processor->prepareToPlay (sampleRate, maxBlockSize);
+    return processor;
+}
+
+void apply (NoctaveAudioProcessor& processor, const Settings& settings)
+{
+    for (const auto& setting : settings)
+    {
+        auto* parameter = processor.apvts.getParameter (setting.parameterID);
+
+        // A misspelt ID would quietly test the default instead
+        jassert (parameter != nullptr);
+
+        if (parameter != nullptr)
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (setting.value));
+    }
+}
+
+juce::String findBadSample (const juce::AudioBuffer<float>& buffer, int numSamples, float peakLimit)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        const auto* samples = buffer.getReadPointer (channel);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto sample = samples[i];
+            const auto at = [&] { return " at sample " + juce::String (i) + " of channel " + juce::String (channel); };
+
+            if (std::isnan (sample))
+                return "NaN" + at();
+
+            if (std::isinf (sample))
+                return "infinity" + at();
+
+            if (sample != 0.0f && std::abs (sample) < std::numeric_limits<float>::min())
+                return "denormal " + juce::String (sample) + at();
+
+            if (std::abs (sample) > peakLimit)
+                return juce::String (juce::Decibels::gainToDecibels (std::abs (sample)), 2) + " dBFS peak" + at()
+                         + ", over the " + juce::String (juce::Decibels::gainToDecibels (peakLimit), 2) + " dBFS limit";
+        }
+    }
+
+    return {};
+}
+}
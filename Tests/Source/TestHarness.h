@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    TestHarness.h
+    Shared pieces of the regression and realtime-safety tests.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+namespace TestHarness
+{
+    /** What one part of the suite checked, and what failed. */
+    struct Outcome
+    {
+        juce::String name;
+        int numChecks = 0;
+        juce::StringArray failures;
+
+        /** Counts a check, and records the description if it failed. */
+        void check (bool passed, const juce::String& description);
+
+        bool passed() const noexcept    { return failures.isEmpty(); }
+
+        /** A summary line, followed by the first few failures. */
+        juce::String toText() const;
+    };
+
+    /** A plain setting, as a parameter ID and a value in the parameter's own units
+        (semitones, dB, a choice's index and so on).
+    */
+    struct Setting
+    {
+        juce::String parameterID;
+        float value = 0.0f;
+    };
+
+    using Settings = std::vector<Setting>;
+
+    /** Stereo test material, the same on every run: a log sweep, plucked notes with
+        sharp attacks and a slow decay into the denormal range, and noise bursts.
+        The two sides get different notes, so the stereo modes have a side to work on.
+    */
+    juce::AudioBuffer<float> makeTestSignal (double sampleRate, double seconds);
+
+    /** A stereo processor set up the way a host does before playing. */
+    std::unique_ptr<NoctaveAudioProcessor> createProcessor (double sampleRate, int maxBlockSize, bool isRealtime);
+
+    /** Sets each parameter as the host does, notifying its listeners. */
+    void apply (NoctaveAudioProcessor& processor, const Settings& settings);
+
+    /** Describes the first NaN, infinity or denormal in the buffer, or the first sample
+        above peakLimit, with where it is. Empty if every sample is fine.
+    */
+    juce::String findBadSample (const juce::AudioBuffer<float>& buffer, int numSamples, float peakLimit);
+}